@@ -0,0 +1,24 @@
+;!
+; @header Boot info definitions.
+; stage2 collects what the kernel needs to know about the machine, which only
+; the BIOS can tell, into the boot info structure at BOOT_INFO_ADDR. It passes
+; the structure to the kernel's entry point with EAX = BOOT_INFO_MAGIC and
+; EBX = BOOT_INFO_ADDR.
+;
+; @IMPORTANT The offsets, sizes and BOOT_INFO_ADDR must match
+; kernel/boot_info.h.
+
+BOOT_INFO_ADDR       equ 0x0600 ; Right after the boot timeline. Free memory
+                                ; until stage2 at 0x1000.
+BOOT_INFO_MAGIC      equ 0x464e4942 ; "BINF".
+
+BOOT_INFO_BOOT_DRIVE equ 0      ; dd, the BIOS boot drive number.
+BOOT_INFO_MMAP_LEN   equ 4      ; dd, the number of memory map entries.
+BOOT_INFO_MMAP       equ 8      ; The memory map, BOOT_INFO_MMAP_MAX entries.
+BOOT_INFO_MODS_LEN   equ 776    ; dd, the number of modules. Always 0, stage2
+                                ; loads no modules, see kernel/multiboot.c.
+
+BOOT_INFO_MMAP_MAX   equ 32
+E820_ENTRY_SIZE      equ 24     ; dq base, dq length, dd type, dd ACPI 3.0
+                                ; extended attributes.
+E820_SMAP            equ 0x534d4150 ; "SMAP".
@@ -1,12 +1,10 @@
 ;!
 ; @header The boot sector program.
 ; The BIOS transfers control to this program, this program transfers control to
-; the kernel.
+; the second stage boot loader, stage2, which loads the kernel.
 ; The steps taken by this program are:
-; 1. Loads the kernel from the floppy a: drive into memory.
-; 2. Switches the CPU mode from real-mode to protected-mode. This is necessary
-;    because the kernel is compiled in 32-bit code.
-; 3. Transfers control to the kernel.
+; 1. Loads stage2 from the floppy a: drive into memory.
+; 2. Transfers control to stage2, see stage2.s.
 ;
 ; @discussion
 ; Initially, the machine is under the control of the BIOS. Towards the end of
@@ -25,18 +23,23 @@
              ; @doc [BIOS Boot Spec.]
              ; @doc [NASM manual chapter 8.1.1]
 
-SECTOR_READ_COUNT equ 32 ; The number of sectors to read from the boot drive as
-                         ; part of loading the kernel into memory.
-                         ; @IMPORTANT:
-                         ; The size of kernel.bin <= SECTOR_READ_COUNT * 512.
+%include "stage2_size.s" ; Defines STAGE2_SECTOR_COUNT, the number of sectors
+                         ; occupied by stage2.bin on the boot drive. This file
+                         ; is generated by the Makefile from the size of
+                         ; stage2.bin at build time.
+
+%include "boot_timeline.s"
 
 STACK_ADDR    equ 0x9000 ; Initial address of the frame pointer (BP) and stack
                          ; pointer (SP) registers. The value has been chosen
                          ; arbitrarily.
 
-KERNEL_OFFSET equ 0x1000 ; This is the address at which we intend to load our
-                         ; kernel. The specific value has been chosen
+STAGE2_OFFSET equ 0x1000 ; This is the address at which we intend to load
+                         ; stage2. The specific value has been chosen
                          ; arbitrarily.
+                         ; @IMPORTANT stage2 is loaded below this boot sector,
+                         ; hence the size of stage2.bin must be <=
+                         ; 0x7c00 - STAGE2_OFFSET bytes.
 
 mov [BOOT_DRIVE], dl  ; By convention, the BIOS stores the boot drive number in
                       ; the DL register. Here, we are storing the boot driver
@@ -46,49 +49,35 @@ mov [BOOT_DRIVE], dl  ; By convention, the BIOS stores the boot drive number in
 mov bp, STACK_ADDR    ; Initialize frame pointer and stack pointer registers.
 mov sp, bp
 
+mov di, BOOT_TIMELINE_ADDR + BT_BOOT_SECT * 8
+call boot_tsc         ; Boot timeline, BT_BOOT_SECT.
+
 mov bx, STR_REAL_MODE ; print_string(STR_REAL_MODE).
 call print_string
+call boot_tsc         ; Boot timeline, BT_PRINT.
 
-call load_kernel      ; Load our kernel from disk to memory.
-
-call switch_to_pm     ; Switch from 16-bit real mode to 32-bit protected mode.
-                      ; If successful, this function will not return here, but
-                      ; will jump instead to BEGIN_PM below.
+call load_stage2      ; Load stage2 from disk to memory.
+call boot_tsc         ; Boot timeline, BT_STAGE2_LOAD.
 
-jmp $                 ; Infinite loop.
+mov dl, [BOOT_DRIVE]  ; stage2 expects the boot drive number in DL, like this
+jmp STAGE2_OFFSET     ; program. It does not return.
 
 ;
 ; Include any data and procedures we intend to use.
 ;
 %include "print_string.s"
 %include "disk_load.s"
-%include "gdt.s"
-%include "print_string_pm.s" ; FYI: Includes a [bits 32] directive.
-%include "switch_to_pm.s"    ; FYI: Includes a [bits 32] directive.
-
-[bits 16] ; NASM assembler directive - generate code to be executed in 16-bit
-          ; mode. This directive is necessary because some of the includes above
-          ; contain the [bits 32] assembler directive.
-          ; @doc [NASM bits assembler directive](NASM manual ch.7.1).
 
 ;!
-; @procedure    load_kernel    Loads the kernel from BOOT_DRIVE into memory at
-;                              address KERNEL_OFFSET. It is assumed that the
-;                              kernel is stored in the second sector of the
-;                              drive. It is also assumed that the size of the
-;                              kernel is less than or equal to SECTOR_READ_COUNT
-;                              * 512 bytes.
-load_kernel:
-    mov bx, STR_LOADING_KERNEL ; print_string(STR_LOADING_KERNEL).
-    call print_string
-
-    mov bx, 0                  ; The BIOS int 0x13 ISR reads into address ES:BX.
-    mov es, bx                 ; ES := 0.
-    mov bx, KERNEL_OFFSET      ; BX := KERNEL_OFFSET.
-
-    mov dh, SECTOR_READ_COUNT  ; DH := SECTOR_READ_COUNT. Number of sectors to
-                               ; read @IMPORTANT: See note on SECTOR_READ_COUNT
-                               ; above.
+; @procedure    load_stage2    Loads stage2 from BOOT_DRIVE into memory at
+;                              address STAGE2_OFFSET. It is assumed that stage2
+;                              is stored starting at the second sector (LBA 1)
+;                              of the drive, and that it occupies
+;                              STAGE2_SECTOR_COUNT sectors.
+load_stage2:
+    mov word [disk_sectors_left], STAGE2_SECTOR_COUNT
+    mov word [dap_lba], 1                          ; LBA 0 is this program.
+    mov word [dap_segment], STAGE2_OFFSET >> 4     ; Destination := STAGE2_OFFSET.
 
     mov dl, [BOOT_DRIVE]       ; DL := [BOOT_DRIVE]. Drive number to read from.
 
@@ -96,19 +85,19 @@ load_kernel:
 
     ret
 
-[bits 32] ; NASM assembler directive - generate code to be executed in 32-bit
-          ; mode.
-
 ;!
-; @procedure    BEGIN_PM    We jump here if we successfully switch into 32-bit
-;                           protected mode.
-BEGIN_PM:
-    mov ebx, STR_PROTECTED_MODE
-    call print_string_pm
-
-    call KERNEL_OFFSET ; Jump to the kernel's entry point.
-
-    jmp $              ; Infinite loop. In case the kernel returns.
+; @procedure    boot_tsc    Stores the time stamp counter (TSC) in the boot
+;                           timeline slot at address DI and advances DI to the
+;                           next slot. Overwrites EAX and EDX. This is the
+;                           compact 16-bit form of the BOOT_TSC macro.
+;
+; @register    DI    The address of a boot timeline slot.
+boot_tsc:
+    rdtsc              ; EDX:EAX := TSC.
+    mov [di], eax
+    mov [di + 4], edx
+    add di, 8
+    ret
 
 ;
 ; Global variables - Misc.
@@ -118,11 +107,7 @@ BOOT_DRIVE         db 0
 ;
 ; Global variables - Strings.
 ;
-STR_REAL_MODE      db "Executing in 16-bit real-address mode.", 0xa, 0x0d, 0
-STR_LOADING_KERNEL db "Loading the kernel.", 0xa, 0x0d, 0
-
-; @remark print_string_pm() does not support printing new-line characters.
-STR_PROTECTED_MODE db "Executing in 32-bit protected mode. Calling kernel.", 0
+STR_REAL_MODE      db "Executing in real mode.", 0xa, 0x0d, 0
 
 ; Boot sector zero-padding and BIOS magic number.
 ;
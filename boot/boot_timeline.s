@@ -0,0 +1,34 @@
+;!
+; @header Boot timeline definitions.
+; Each boot stage records the time stamp counter (TSC) in a fixed slot of the
+; boot timeline, an array of 64-bit values at BOOT_TIMELINE_ADDR. The kernel
+; prints the timeline, see kernel/boot_timeline.c.
+;
+; @IMPORTANT The slot indices and BOOT_TIMELINE_ADDR must match
+; kernel/boot_timeline.h.
+;
+; @doc [RDTSC](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
+
+BOOT_TIMELINE_ADDR   equ 0x0500 ; Start of the free memory right above the BIOS
+                                ; data area. 256 bytes are free until 0x0600.
+
+BT_BOOT_SECT         equ 0      ; The boot sector is entered.
+BT_PRINT             equ 1      ; The real-mode print is done.
+BT_STAGE2_LOAD       equ 2      ; stage2 is loaded from disk.
+BT_DISK_LOAD         equ 3      ; The kernel image is loaded from disk.
+BT_SWITCH_TO_PM      equ 4      ; switch_to_pm/init_pm are done, BEGIN_PM.
+BT_ELF_LOAD          equ 5      ; The kernel's ELF segments are in place.
+                                ; Includes the decompression, if any.
+BT_KERNEL_ENTRY      equ 6      ; kernel_entry.s is entered.
+
+;!
+; @macro    BOOT_TSC    Stores the TSC in the given boot timeline slot.
+;                       Overwrites EAX and EDX. Works in 16-bit and 32-bit
+;                       mode.
+;
+; @param    %1    The boot timeline slot index, one of BT_*.
+%macro BOOT_TSC 1
+    rdtsc                                      ; EDX:EAX := TSC.
+    mov [BOOT_TIMELINE_ADDR + %1 * 8], eax
+    mov [BOOT_TIMELINE_ADDR + %1 * 8 + 4], edx
+%endmacro
@@ -1,76 +1,178 @@
 ;!
-; @procedure    disk_load    Procedure to read DH number of sectors from a drive
-;                            DL into memory at address ES:BX. Uses the int 0x13
-;                            BIOS ISR.
+; @procedure    disk_load    Procedure to read [disk_sectors_left] sectors,
+;                            starting at logical block address (LBA)
+;                            [dap_lba], from drive DL into memory at address
+;                            [dap_segment]:0000. Uses the int 0x13 BIOS ISR.
 ;
 ; @register    DL    The drive number identifying the drive from which sectors
 ;                    will be read.
 ;
-; @register    DH    The requested number of sectors to read from the drive.
+; @label    disk_sectors_left    The number of sectors to read. Counts down to
+;                                0 as the sectors are read.
 ;
-; @register    ES    The segment base address value to use when reading sectors
-;                    into memory at ES:BX.
+; @label    dap_lba              The LBA of the first sector to read (0 based
+;                                index, LBA 0 is the boot sector). Advanced as
+;                                the sectors are read.
 ;
-; @register    BX    The segment offset value to use when reading sectors into
-;                    memory at ES:BX.
+; @label    dap_segment          The segment of the destination buffer. The
+;                                offset is always 0. Advanced by 512 / 16 = 32
+;                                per sector read.
 ;
 ; @discussion
+; If the BIOS supports the int 0x13 extensions (int 0x13 AH = 0x41), sectors
+; are read with the "extended read" function (AH = 0x42), which takes an LBA
+; through a disk address packet (DAP). Otherwise, e.g. for floppy drives, we
+; fall back to the original cylinder-head-sector (CHS) read function
+; (AH = 0x02). The drive geometry for the CHS conversion is queried with the
+; "get drive parameters" function (AH = 0x08).
+;
+; Sectors are read in the largest chunks the BIOS accepts, instead of 1 sector
+; per int 0x13. An extended read is limited to 127 sectors (Phoenix EDD limit),
+; a CHS read is limited to the sectors left on the current track (head). The
+; next chunk continues on the next head or cylinder.
+;
+; @IMPORTANT The destination buffer must not cross a 64 KiB physical address
+; boundary. The floppy controller's ISA DMA channel can't cross one.
+;
 ; @doc [Writing a Simple Operating System - from Scratch by Nick Blundell,
 ; Chapter 3.6.4]
+; @doc [INT 13h](https://en.wikipedia.org/wiki/INT_13H)
 disk_load:
-    push dx      ; Push DX on the stack so we can use DH for error checking
-                 ; after int 0x13 returns.
+    pusha
+
+    mov [disk_drive], dl     ; Save the drive number, int 0x13 AH = 0x08
+                             ; overwrites DL.
+
+    mov ah, 0x41             ; AH := 0x41, check extensions present.
+    mov bx, 0x55aa           ; BIOS ISR usage convention.
+    int 0x13
+    jc disk_chs_geometry     ; CF set, extensions not supported.
+    cmp bx, 0xaa55           ; BX := 0xaa55 if extensions are installed.
+    jne disk_chs_geometry
+    test cl, 1               ; CX[bit 0] := 1 if the DAP functions (AH = 0x42)
+    jz disk_chs_geometry     ; are supported.
+
+    mov byte [disk_use_lba], 1
+    jmp short disk_load_next
+
+disk_chs_geometry:
+    mov ah, 0x08             ; AH := 0x08, get drive parameters.
+    mov dl, [disk_drive]
+    int 0x13                 ; @IMPORTANT Overwrites ES:DI on floppy drives.
+    jc near disk_error       ; Too far for a short jump.
+
+    and cx, 0x3f             ; CL[bit 5:0] := sectors per track (1 based).
+    mov [disk_spt], cx
+
+    movzx ax, dh             ; DH := index of the last head.
+    inc ax
+    mov [disk_heads], ax
+
+disk_load_next:
+    mov ax, [disk_sectors_left]
+    test ax, ax
+    jz disk_load_done        ; DONE!
+
+    cmp ax, 127              ; Never request more than 127 sectors at once.
+    jbe disk_load_chunk
+    mov ax, 127
 
-    mov ah, 0x02 ; BIOS ISR usage convention. AH := 2, means we want to use the
-                 ; BIOS read sector function.
+disk_load_chunk:
+    cmp byte [disk_use_lba], 0
+    je disk_load_chs
 
-    mov al, dh   ; BIOS ISR usage convention. AL specifies the number of sectors
-                 ; to read.
+    ; Extended read. The DAP holds the sector count, buffer and LBA.
+    mov [dap_count], ax
+    mov si, dap              ; DS:SI := address of the DAP. DS == 0.
+    mov ah, 0x42             ; AH := 0x42, extended read.
+    mov dl, [disk_drive]
+    int 0x13
+    jc disk_error
+
+    mov ax, [dap_count]      ; The BIOS updates the count to the number of
+                             ; sectors actually read.
+    jmp short disk_load_advance
+
+disk_load_chs:
+    push ax                  ; Save the chunk size.
 
     ;
-    ; BIOS ISR usage convention. Specifying the starting cylinder-head-sector
-    ; address for the read operation.
-    ; CH := cylinder (a.k.a. track) number (0 based index).
-    ; DH := head number (0 based index).
-    ; CL := sector number (1 based index).
+    ; Convert the LBA to CHS.
+    ; sector   = (LBA % sectors per track) + 1
+    ; head     = (LBA / sectors per track) % heads
+    ; cylinder = (LBA / sectors per track) / heads
     ;
-    mov ch, 0x00             ; Select cylinder 0.
-    mov dh, 0x00             ; Select head 0.
-    mov cl, 0x02             ; Select sector 2, since sector 1 contains this
-                             ; boot program. (This is a 1 based index).
-
-    int 0x13                 ; BIOS ISR for disk device access.
+    mov ax, [dap_lba]
+    xor dx, dx
+    div word [disk_spt]      ; AX := LBA / spt, DX := LBA % spt.
+    mov bx, [disk_spt]
+    sub bx, dx               ; BX := sectors left on this track.
+    mov cx, dx
+    inc cx                   ; CL := sector number (1 based index).
+    xor dx, dx
+    div word [disk_heads]    ; AX := cylinder, DX := head.
+    mov dh, dl               ; DH := head number.
+    mov ch, al               ; CH := cylinder number. Cylinders >= 256 are not
+                             ; supported, fine for floppy drives.
 
-    jc disk_error_1          ; If the carry flag is set it means a general fault
-                             ; (a.k.a. error) occurred.
+    pop ax
+    cmp ax, bx               ; A CHS read can't cross a track.
+    jbe disk_load_chs_read
+    mov ax, bx
 
-    pop dx                   ; Restore DX register value.
+disk_load_chs_read:
+    mov ah, 0x02             ; AH := 0x02, read sectors. AL := sector count.
+    mov bx, [dap_segment]
+    mov es, bx
+    xor bx, bx               ; ES:BX := destination buffer.
+    mov dl, [disk_drive]
+    push ax
+    int 0x13
+    pop ax
+    jc disk_error
 
-    cmp dh, al               ; BIOS ISR usage convention. AL = number of sectors
-                             ; actually read. If DH != AL, an has error
-                             ; occurred.
-    jne disk_error_2
+    xor ah, ah               ; AX := number of sectors requested, which is
+                             ; the number read when CF is clear.
 
-    ret                      ; DONE!
+disk_load_advance:
+    add [dap_lba], ax
+    sub [disk_sectors_left], ax
+    shl ax, 5                ; 512 bytes per sector == 32 paragraphs.
+    add [dap_segment], ax
+    jmp short disk_load_next
 
-disk_error_1:
-    mov bx, STR_DISK_ERROR_1
-    call print_string
-    jmp $                    ; Infinite loop.
+disk_load_done:
+    popa
+    ret
 
-disk_error_2:
-    mov bx, STR_DISK_ERROR_2
+disk_error:
+    mov bx, STR_DISK_ERROR
     call print_string
     jmp $                    ; Infinite loop.
 
 ;
-; Global variables - strings.
+; Global variables - Misc.
 ;
-; @remark Is the colon needed here? ANS: No. Works the same. Assembler doesn't
-; report an error and the runtime behavior is the same.
-;
-STR_DISK_ERROR_1: db "Carry flag (CF) set. Disk read error!", 0xa, 0x0d, 0
 
-STR_DISK_ERROR_2: db "Sector read count mismatch. Requested != Actual. DH != AL. Disk read error!", 0xa, 0x0d, 0
+;!
+; @struct    dap    Disk address packet for the int 0x13 AH = 0x42 extended
+;                   read.
+dap:
+                   db 0x10             ; Size of the DAP.
+                   db 0                ; Reserved.
+dap_count:         dw 0                ; Number of sectors to read.
+dap_offset:        dw 0                ; Destination buffer, offset.
+dap_segment:       dw 0                ; Destination buffer, segment.
+dap_lba:           dd 0                ; LBA of the first sector, low dword.
+                   dd 0                ; LBA of the first sector, high dword.
 
+disk_sectors_left: dw 0
+disk_spt:          dw 0                ; Sectors per track.
+disk_heads:        dw 0                ; Number of heads.
+disk_drive:        db 0
+disk_use_lba:      db 0                ; 1 if the extended read is used.
 
+;
+; Global variables - strings.
+;
+STR_DISK_ERROR: db "Disk read error!", 0xa, 0x0d, 0
@@ -0,0 +1,112 @@
+;!
+; @header LZ4 decompressor.
+; Decompresses data in the LZ4 "legacy frame" format, which is the format
+; produced by `lz4 -l`. Runs in 32-bit protected mode.
+;
+; @discussion
+; A legacy frame is the 4-byte magic number 0x184C2102 followed by blocks. Each
+; block is a 4-byte compressed size followed by that many bytes of compressed
+; data in the LZ4 block format. A block is a list of sequences, each sequence
+; is:
+;
+; | token | [literal length bytes] | literals | offset | [match length bytes] |
+;
+; token[bit 7:4] = literal length, token[bit 3:0] = match length - 4. A length
+; of 15 is followed by extra length bytes which are added to it, until a byte
+; != 255. The match is a copy of (match length) bytes starting (offset) bytes
+; behind the current output position. The last sequence of a block has only
+; literals.
+;
+; @doc [LZ4 block format](https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+; @doc [LZ4 legacy frame](https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md#legacy-frame)
+
+LZ4_LEGACY_MAGIC equ 0x184c2102
+
+[bits 32] ; NASM assembler directive - generate code to be executed in 32-bit
+          ; mode.
+
+;!
+; @procedure    lz4_decompress    Decompresses an LZ4 legacy frame.
+;
+; @register    ESI    Address of the first byte of the frame.
+; @register    EBX    Address one past the last byte of the frame.
+; @register    EDI    Address of the destination buffer.
+;
+; @remark print_string_pm.s must be included, for the error message.
+;
+; @discussion
+; The match copy uses `rep movsb`, which is defined to behave as a byte by byte
+; copy. Hence an overlapping match (offset < match length), which repeats the
+; last (offset) bytes, is copied correctly.
+lz4_decompress:
+    pushad
+    cld                       ; movsb increments ESI and EDI.
+
+    cmp dword [esi], LZ4_LEGACY_MAGIC
+    jne lz4_error
+    add esi, 4
+
+lz4_next_block:
+    cmp esi, ebx
+    jae lz4_done              ; DONE!
+
+    mov edx, [esi]            ; EDX := compressed block size.
+    add esi, 4
+    add edx, esi              ; EDX := one past the end of the block.
+
+lz4_next_sequence:
+    movzx eax, byte [esi]     ; EAX := token.
+    inc esi
+
+    mov ecx, eax
+    shr ecx, 4                ; ECX := literal length.
+    cmp ecx, 15
+    jne lz4_copy_literals
+
+lz4_literal_length:
+    movzx ebp, byte [esi]
+    inc esi
+    add ecx, ebp
+    cmp ebp, 255
+    je lz4_literal_length
+
+lz4_copy_literals:
+    rep movsb
+
+    cmp esi, edx              ; The last sequence of a block has no match.
+    jae lz4_next_block
+
+    movzx ebp, word [esi]     ; EBP := match offset.
+    add esi, 2
+
+    mov ecx, eax
+    and ecx, 0x0f             ; ECX := match length - 4.
+    cmp ecx, 15
+    jne lz4_copy_match
+
+lz4_match_length:
+    movzx eax, byte [esi]
+    inc esi
+    add ecx, eax
+    cmp eax, 255
+    je lz4_match_length
+
+lz4_copy_match:
+    add ecx, 4                ; The minimum match length is 4.
+    push esi
+    mov esi, edi
+    sub esi, ebp              ; ESI := start of the match.
+    rep movsb
+    pop esi
+    jmp lz4_next_sequence
+
+lz4_done:
+    popad
+    ret
+
+lz4_error:
+    mov ebx, STR_LZ4_ERROR    ; Not an LZ4 legacy frame.
+    call print_string_pm
+    jmp $                     ; Infinite loop.
+
+STR_LZ4_ERROR db "Kernel LZ4 error!", 0
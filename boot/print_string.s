@@ -23,7 +23,7 @@ next_char:
     int 0x10     ; print(AL).
 
 
-    add bx, 1    ; Move on to the next character. BX++.
+    inc bx       ; Move on to the next character. BX++.
     jmp next_char
 done:
     popa         ; Pop all register value off the stack.
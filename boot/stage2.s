@@ -0,0 +1,404 @@
+;!
+; @header The second stage boot loader.
+; The boot sector loads this program at STAGE2_OFFSET and jumps to it. This
+; program loads the kernel, an ELF executable, above 1 MiB and transfers control
+; to it.
+; The steps taken by this program are:
+; 1. Enables the A20 address line, otherwise every odd MiB of memory is
+;    unreachable.
+; 2. Collects the BIOS memory map and the boot drive number into the boot info
+;    structure, see boot_info.s.
+; 3. Reads the kernel image from the boot drive into KERNEL_LOAD_ADDR. The BIOS
+;    can only read into the first MiB, hence the sectors are read into a bounce
+;    buffer and copied up in "unreal mode", i.e. real mode with a 4 GiB data
+;    segment limit.
+; 4. Switches the CPU mode from real-mode to protected-mode.
+; 5. If the kernel image is compressed (`make COMPRESS=1`), decompresses it to
+;    KERNEL_STAGING_ADDR.
+; 6. Copies the ELF PT_LOAD segments from KERNEL_STAGING_ADDR to their physical
+;    addresses, and zeroes their uninitialized part (.bss).
+; 7. Transfers control to the kernel's ELF entry point, with EAX =
+;    BOOT_INFO_MAGIC and EBX = BOOT_INFO_ADDR.
+;
+; @discussion
+; The kernel's memory layout is set by the linker script, kernel/linker.ld. The
+; only constraint this program places on it is that every segment lies in
+; [KERNEL_MIN_ADDR, KERNEL_STAGING_ADDR), see elf_load.
+;
+; The disk layout is: the boot sector at LBA 0, this program at LBA 1, padded to
+; a whole number of sectors, then the kernel image.
+;
+; @doc [ELF](Tool Interface Standard (TIS) Executable and Linking Format (ELF)
+; Specification Version 1.2, Book I, Ch.1-2)
+; @doc [A20](https://wiki.osdev.org/A20_Line#Fast_A20_Gate)
+; @doc [Unreal mode](https://wiki.osdev.org/Unreal_Mode)
+; @doc [E820](ACPI Spec. 6.4, Ch.15.1 INT 15H, E820H - Query System Address Map)
+
+%include "kernel_size.s" ; Defines KERNEL_IMAGE_SIZE and KERNEL_SECTOR_COUNT,
+                         ; the size of the kernel image in bytes and in sectors
+                         ; on the boot drive. This file is generated by the
+                         ; Makefile from the size of the kernel image at build
+                         ; time.
+
+%include "boot_timeline.s"
+%include "boot_info.s"
+
+STAGE2_OFFSET       equ 0x1000     ; Must match boot_sect.s.
+
+BOUNCE_ADDR         equ 0x10000    ; Disk read bounce buffer, 64 KiB aligned.
+BOUNCE_SECTORS      equ 127        ; Size of the bounce buffer in sectors. 127
+                                   ; is the largest extended read, see
+                                   ; disk_load. 127 * 512 bytes do not cross a
+                                   ; 64 KiB boundary.
+
+KERNEL_MIN_ADDR     equ 0x100000   ; 1 MiB. The kernel's segments must not
+                                   ; overwrite anything below.
+
+KERNEL_STAGING_ADDR equ 0x400000   ; 4 MiB. The ELF file is read (or
+                                   ; decompressed) here. The kernel's segments
+                                   ; must end below this address.
+
+%ifdef COMPRESS
+KERNEL_LOAD_ADDR    equ 0x600000   ; 6 MiB. The compressed image is read here.
+%else
+KERNEL_LOAD_ADDR    equ KERNEL_STAGING_ADDR
+%endif
+
+KERNEL_MAX_SIZE     equ 0x200000   ; The kernel image, and in compressed mode
+                                   ; the ELF file, must be <= 2 MiB. See
+                                   ; testksize.sh.
+
+; The image is read, and decompressed, above KERNEL_MIN_ADDR. Below it are this
+; program and its GDT, which GDTR points to until the kernel loads its own: an
+; interrupt or a segment load would reload the descriptors from memory.
+%if KERNEL_STAGING_ADDR < KERNEL_MIN_ADDR || KERNEL_LOAD_ADDR < KERNEL_MIN_ADDR
+%error "The kernel image must be loaded above KERNEL_MIN_ADDR."
+%endif
+%ifdef COMPRESS
+%if KERNEL_LOAD_ADDR < KERNEL_STAGING_ADDR + KERNEL_MAX_SIZE
+%error "The compressed image would be overwritten by the decompressed one."
+%endif
+%endif
+%if KERNEL_IMAGE_SIZE > KERNEL_MAX_SIZE
+%error "The kernel image is larger than KERNEL_MAX_SIZE."
+%endif
+
+; ELF file offsets, see the ELF spec. Fig.1-3 and Fig.2-1.
+ELF_MAGIC           equ 0x464c457f ; "\x7fELF", e_ident[EI_MAG0..3].
+ELF_E_ENTRY         equ 24
+ELF_E_PHOFF         equ 28
+ELF_E_PHENTSIZE     equ 42
+ELF_E_PHNUM         equ 44
+ELF_P_TYPE          equ 0
+ELF_P_OFFSET        equ 4
+ELF_P_PADDR         equ 12
+ELF_P_FILESZ        equ 16
+ELF_P_MEMSZ         equ 20
+PT_LOAD             equ 1
+
+[org STAGE2_OFFSET]
+[bits 16]
+
+;!
+; @procedure    stage2    Entry point, jumped to by the boot sector.
+;
+; @register    DL    The boot drive number.
+stage2:
+    mov [BOOT_DRIVE], dl
+
+    mov bx, STR_LOADING_KERNEL ; print_string(STR_LOADING_KERNEL).
+    call print_string
+
+    call enable_a20
+    call detect_memory
+    call load_kernel
+    BOOT_TSC BT_DISK_LOAD
+
+    call switch_to_pm  ; Switch from 16-bit real mode to 32-bit protected mode.
+                       ; If successful, this function will not return here,
+                       ; but will jump instead to BEGIN_PM below.
+
+    jmp $              ; Infinite loop.
+
+;
+; Include any data and procedures we intend to use.
+;
+%include "print_string.s"
+%include "disk_load.s"
+%include "gdt.s"
+%include "switch_to_pm.s"    ; FYI: Includes a [bits 32] directive.
+%include "print_string_pm.s"
+%ifdef COMPRESS
+%include "lz4.s"
+%endif
+
+[bits 16] ; NASM assembler directive - generate code to be executed in 16-bit
+          ; mode. This directive is necessary because some of the includes above
+          ; contain the [bits 32] assembler directive.
+
+;!
+; @procedure    enable_a20    Enables the A20 address line through the "fast
+;                             A20 gate", bit 1 of the system control port A.
+;
+; @discussion Bit 0 of port 0x92 resets the CPU, it must be written as 0.
+enable_a20:
+    in al, 0x92
+    test al, 2
+    jnz enable_a20_done      ; Already enabled.
+    or al, 2
+    and al, 0xfe
+    out 0x92, al
+enable_a20_done:
+    ret
+
+;!
+; @procedure    detect_memory    Stores the boot drive number and the BIOS
+;                                memory map, int 0x15 EAX = 0xe820, in the boot
+;                                info structure. Fills in the whole structure.
+;
+; @discussion Each int 0x15 call returns one entry and a continuation value in
+; EBX, 0 after the last entry. Entries with a zero length are dropped. Up to
+; BOOT_INFO_MMAP_MAX entries are kept. If the BIOS does not support E820 the
+; map is empty. The ACPI 3.0 extended attributes are preset to 1 (entry valid),
+; in case the BIOS returns 20 byte entries.
+detect_memory:
+    pushad
+    push es
+
+    movzx eax, byte [BOOT_DRIVE]
+    mov [BOOT_INFO_ADDR + BOOT_INFO_BOOT_DRIVE], eax
+
+    xor ax, ax
+    mov es, ax               ; ES:DI := next entry. disk_load may change ES.
+    mov di, BOOT_INFO_ADDR + BOOT_INFO_MMAP
+    xor ebx, ebx             ; EBX := 0, start at the first entry.
+    xor bp, bp               ; BP := number of entries.
+
+detect_memory_next:
+    mov dword [di + 20], 1
+    mov eax, 0xe820
+    mov ecx, E820_ENTRY_SIZE
+    mov edx, E820_SMAP
+    int 0x15
+    jc detect_memory_done    ; CF set, not supported or past the last entry.
+    cmp eax, E820_SMAP
+    jne detect_memory_done
+
+    mov eax, [di + 8]
+    or eax, [di + 12]
+    jz detect_memory_skip    ; Zero length.
+
+    add di, E820_ENTRY_SIZE
+    inc bp
+    cmp bp, BOOT_INFO_MMAP_MAX
+    je detect_memory_done    ; The map is full.
+
+detect_memory_skip:
+    test ebx, ebx
+    jnz detect_memory_next
+
+detect_memory_done:
+    movzx ebp, bp
+    mov [BOOT_INFO_ADDR + BOOT_INFO_MMAP_LEN], ebp
+    mov dword [BOOT_INFO_ADDR + BOOT_INFO_MODS_LEN], 0
+
+    pop es
+    popad
+    ret
+
+;!
+; @procedure    enter_unreal    Sets the DS and ES segment limits to 4 GiB,
+;                               while staying in real mode.
+;
+; @discussion The CPU caches a segment's base and limit when the segment
+; register is loaded. Loading DS and ES with DATA_SEG in protected mode caches
+; its 4 GiB limit. Back in real mode, loading DS and ES only changes the cached
+; base, so 32-bit offsets can be used with them.
+;
+; @IMPORTANT Must be called again after each BIOS call. Some BIOSes, e.g.
+; SeaBIOS, switch to protected mode internally and restore the 64 KiB limits.
+enter_unreal:
+    pushad
+    push ds
+    push es
+    cli
+
+    lgdt [gdt_descriptor]
+    mov eax, cr0
+    or al, 1
+    mov cr0, eax            ; Protected mode. CS keeps its real mode cache, so
+                            ; this 16-bit code keeps executing.
+    mov bx, DATA_SEG
+    mov ds, bx
+    mov es, bx
+    and al, 0xfe
+    mov cr0, eax            ; Back to real mode.
+
+    pop es                  ; Restore the real mode bases, the limits stay.
+    pop ds
+    sti
+    popad
+    ret
+
+;!
+; @procedure    load_kernel    Loads the kernel image from BOOT_DRIVE into
+;                              memory at address KERNEL_LOAD_ADDR. The image is
+;                              stored on the drive right after this program,
+;                              and occupies KERNEL_SECTOR_COUNT sectors.
+;
+; @discussion The image is read BOUNCE_SECTORS at a time into the bounce buffer,
+; and each chunk is copied to [load_addr] with a 32-bit `rep movsd`.
+load_kernel:
+    pushad
+
+    mov word [dap_lba], (stage2_end - stage2) / 512 + 1
+    mov dword [load_addr], KERNEL_LOAD_ADDR
+    mov bp, KERNEL_SECTOR_COUNT ; BP := sectors left.
+
+load_kernel_next:
+    test bp, bp
+    jz load_kernel_done         ; DONE!
+
+    mov ax, bp
+    cmp ax, BOUNCE_SECTORS
+    jbe load_kernel_chunk
+    mov ax, BOUNCE_SECTORS
+
+load_kernel_chunk:
+    sub bp, ax
+    mov [disk_sectors_left], ax
+    mov word [dap_segment], BOUNCE_ADDR >> 4
+    mov dl, [BOOT_DRIVE]
+    call disk_load              ; Advances [dap_lba].
+
+    xor bx, bx
+    mov es, bx                  ; ES base := 0, disk_load may change ES and
+                                ; `rep movsd` writes to ES:EDI.
+    call enter_unreal
+    movzx ecx, ax
+    shl ecx, 7                  ; ECX := number of dwords, 128 per sector.
+    mov esi, BOUNCE_ADDR
+    mov edi, [load_addr]
+    cld
+    a32 rep movsd               ; 32-bit addresses, ESI and EDI.
+    mov [load_addr], edi
+    jmp load_kernel_next
+
+load_kernel_done:
+    popad
+    ret
+
+[bits 32] ; NASM assembler directive - generate code to be executed in 32-bit
+          ; mode.
+
+;!
+; @procedure    BEGIN_PM    We jump here if we successfully switch into 32-bit
+;                           protected mode.
+BEGIN_PM:
+    BOOT_TSC BT_SWITCH_TO_PM
+
+%ifdef COMPRESS
+    mov esi, KERNEL_LOAD_ADDR
+    mov ebx, KERNEL_LOAD_ADDR + KERNEL_IMAGE_SIZE
+    mov edi, KERNEL_STAGING_ADDR
+    call lz4_decompress
+%endif
+
+    call elf_load
+    BOOT_TSC BT_ELF_LOAD
+
+    mov ecx, [KERNEL_STAGING_ADDR + ELF_E_ENTRY]
+    mov eax, BOOT_INFO_MAGIC
+    mov ebx, BOOT_INFO_ADDR
+    call ecx           ; Jump to the kernel's entry point.
+
+    jmp $              ; Infinite loop. In case the kernel returns.
+
+;!
+; @procedure    elf_load    Loads the ELF executable at KERNEL_STAGING_ADDR.
+;                           Copies the file image of each PT_LOAD segment to
+;                           the segment's physical address, and zeroes the
+;                           rest of the segment, i.e. p_memsz - p_filesz bytes
+;                           (.bss).
+;
+; @discussion Every segment must lie in [KERNEL_MIN_ADDR, KERNEL_STAGING_ADDR),
+; otherwise it would overwrite this program or the ELF file. The program
+; headers are read in place.
+elf_load:
+    pushad
+    cld
+    mov ebp, KERNEL_STAGING_ADDR
+
+    cmp dword [ebp], ELF_MAGIC
+    jne elf_error
+
+    mov ebx, [ebp + ELF_E_PHOFF]
+    add ebx, ebp                          ; EBX := first program header.
+    movzx edx, word [ebp + ELF_E_PHNUM]   ; EDX := number of program headers.
+
+elf_load_next:
+    test edx, edx
+    jz elf_load_done                      ; DONE!
+
+    cmp dword [ebx + ELF_P_TYPE], PT_LOAD
+    jne elf_load_skip
+
+    mov edi, [ebx + ELF_P_PADDR]          ; EDI := segment destination.
+    cmp edi, KERNEL_MIN_ADDR
+    jb elf_error
+    mov eax, edi
+    add eax, [ebx + ELF_P_MEMSZ]
+    jc elf_error
+    cmp eax, KERNEL_STAGING_ADDR
+    ja elf_error
+
+    mov esi, [ebx + ELF_P_OFFSET]
+    add esi, ebp                          ; ESI := segment file image.
+    mov eax, [ebx + ELF_P_FILESZ]
+    mov ecx, eax
+    shr ecx, 2
+    rep movsd
+    mov ecx, eax
+    and ecx, 3
+    rep movsb
+
+    mov ecx, [ebx + ELF_P_MEMSZ]
+    sub ecx, eax                          ; ECX := bytes to zero.
+    mov esi, ecx
+    xor eax, eax
+    shr ecx, 2
+    rep stosd
+    mov ecx, esi
+    and ecx, 3
+    rep stosb
+
+elf_load_skip:
+    movzx eax, word [ebp + ELF_E_PHENTSIZE]
+    add ebx, eax
+    dec edx
+    jmp elf_load_next
+
+elf_load_done:
+    popad
+    ret
+
+elf_error:
+    mov ebx, STR_ELF_ERROR
+    call print_string_pm
+    jmp $              ; Infinite loop.
+
+;
+; Global variables - Misc.
+;
+BOOT_DRIVE         db 0
+load_addr          dd 0 ; Where load_kernel copies the next chunk.
+
+;
+; Global variables - Strings.
+;
+STR_LOADING_KERNEL db "Loading the kernel.", 0xa, 0x0d, 0
+STR_ELF_ERROR      db "Kernel ELF error!", 0
+
+; Pad to a whole number of sectors, the kernel image starts at the next sector.
+times (512 - ($ - $$) % 512) % 512 db 0
+stage2_end:
@@ -8,10 +8,12 @@
 ; The initial steps consist in setting up the global descriptor table (GDT)
 ; which is currently done in gdt.asm.
 
-STACK_ADDR_PM equ 0x900000 ; Address used to initialize the frame pointer (EBP)
+STACK_ADDR_PM equ 0x9000   ; Address used to initialize the frame pointer (EBP)
                            ; and stack pointer (ESP) registers after switching
-                           ; the CPU mode to 32-bit protected-mode.
-                           ; @remark Bochs physical mem. = 32 MB = 0x1ffffff
+                           ; the CPU mode to 32-bit protected-mode. The same
+                           ; stack as in real mode, it is only used by stage2.
+                           ; The kernel sets up its own stack, see
+                           ; kernel/kernel_entry.s.
 
 [bits 16] ; NASM assembler directive - generate code to be executed in 16-bit
           ; mode.
@@ -33,9 +33,12 @@
 #include "ps_2_ctlr.h"
 #include "keyboard.h"
 #include "screen.h"
-#include "../kernel/i8259a_pic.h"
+#include "../kernel/klog.h"
+#include "../kernel/idt.h"
 #include "../kernel/low_level.h"
+#include "../kernel/softirq.h"
 #include "../include/assert.h"
+#include "../include/stddef.h"
 
 /*!
     @defined    KEY_CODE_TO_ASCII_ROWS
@@ -138,6 +141,23 @@ const char shift_kc_rc_to_ascii[KEY_CODE_TO_ASCII_ROWS][KEY_CODE_TO_ASCII_COLS]
 #define SCAN_CODE_ERR 0xFD // row = 7 // col = 29
 #define SCAN_CODE_IGNORE 0xFC // row = 7 // col = 28
 
+/*!
+    @defined    KEY_CODE_PG_UP, KEY_CODE_PG_DOWN
+
+    @discussion The key codes of <pg-up> and <pg-down>, which page the screen's
+    scrollback.
+*/
+#define KEY_CODE_PG_UP KEY_CODE_FROM_ROW_COL(1, 16)
+#define KEY_CODE_PG_DOWN KEY_CODE_FROM_ROW_COL(2, 16)
+
+/*!
+    @defined    SCROLLBACK_PAGE
+
+    @discussion The number of rows <pg-up> and <pg-down> scroll, a screen less
+    a row of context.
+*/
+#define SCROLLBACK_PAGE 24
+
 /*!
     @defined    KEY_CODE_TO_ROW(kc)
 
@@ -719,7 +739,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case S2B1P_F:
-        print("2-Byte Scan Code Pressed\n");
+        klog(KLOG_DEBUG, "2-Byte Scan Code Pressed");
         i = sc_to_kc_index(sc, 2);
         if (i == 0xFF) {
             assert(0); // Should not occur for valid scan codes.
@@ -730,7 +750,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case S2B1R_F:
-        print("2-Byte Scan Code Released\n");
+        klog(KLOG_DEBUG, "2-Byte Scan Code Released");
         i = sc_to_kc_index(sc, 2);
         if (i == 0xFF) {
             assert(0); // Should not occur for valid scan codes.
@@ -741,7 +761,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case S4B3P_F:
-        print("4-Byte Scan Code Pressed\n");
+        klog(KLOG_DEBUG, "4-Byte Scan Code Pressed");
         i = sc_to_kc_index(sc, 4);
         if (i == 0xFF) {
             assert(0); // Should not occur for valid scan codes.
@@ -752,7 +772,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case S4B3R_F:
-        print("4-Byte Scan Code Released\n");
+        klog(KLOG_DEBUG, "4-Byte Scan Code Released");
         i = sc_to_kc_index(sc, 4);
         if (i == 0xFF) {
             assert(0); // Should not occur for valid scan codes.
@@ -763,7 +783,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case S6B5P_F:
-        print("6-Byte Scan Code Pressed\n");
+        klog(KLOG_DEBUG, "6-Byte Scan Code Pressed");
         i = sc_to_kc_index(sc, 6);
         if (i == 0xFF) {
             assert(0); // Should not occur for valid scan codes.
@@ -775,7 +795,7 @@ static int sc_sm_is_final_state(sc_state_t s, uint8_t sc, uint8_t *kc) {
         return 1;
         break;
     case SSC_ERR:
-        print("Scan Code Error State!\n");
+        klog(KLOG_WARN, "Scan Code Error State!");
         return 1;
         break;
     default:
@@ -809,42 +829,123 @@ uint8_t sc_sm_update(uint8_t sc) {
     return kc;
 }
 
+/*!
+    @defined SC_RING_SIZE
+
+    @discussion The size of the scan code ring, a power of 2.
+*/
+#define SC_RING_SIZE 64
+
+/*!
+    @var sc_ring
+
+    @discussion The scan codes received by v33_handler and not yet processed
+    by keyboard_work. The handler only writes sc_head, the tasklet only
+    sc_tail, hence no lock is needed.
+*/
+static uint8_t sc_ring[SC_RING_SIZE];
+static volatile uint32_t sc_head, sc_tail;
+
+/*!
+    @var sc_dropped
+
+    @discussion The number of scan codes received while sc_ring was full.
+*/
+static volatile uint32_t sc_dropped;
+
+/*!
+    @function keyboard_work
+
+    @discussion The keyboard tasklet. Decodes the received scan codes and
+    prints the keys, with a single screen_flush() for the batch.
+
+    @param ctx NULL
+*/
+static void keyboard_work(void *ctx) {
+    static uint32_t sc_reported;
+    uint8_t sc, kc;
+    int flush = 0;
+    char c;
+
+    if (ctx) { // Suppress warning.
+        ;
+    }
+
+    while (sc_tail != sc_head) {
+        sc = sc_ring[sc_tail & (SC_RING_SIZE - 1)];
+        sc_tail++;
+        klog(KLOG_DEBUG, "scan code %02x", sc);
+
+        kc = sc_sm_update(sc);
+        if (kc == KEY_CODE_PG_UP) {
+            screen_scrollback(SCROLLBACK_PAGE);
+        } else if (kc == KEY_CODE_PG_DOWN) {
+            screen_scrollback(-SCROLLBACK_PAGE);
+        } else if(kc != SCAN_CODE_ERR && kc != SCAN_CODE_IGNORE) {
+            // Print something
+            c = kc_to_ascii(kc);
+            print_ch_at(c, 0, -1, -1);
+            flush = 1;
+        }
+    }
+
+    if (sc_dropped != sc_reported) {
+        sc_reported = sc_dropped;
+        klog(KLOG_WARN, "%u scan codes dropped", sc_reported);
+    }
+    if (flush)
+        screen_flush();
+}
+
+/*!
+    @var keyboard_tasklet
+
+    @discussion The deferred work of v33_handler, see keyboard_work.
+*/
+tasklet_t keyboard_tasklet = {
+    keyboard_work, NULL, 0, 0, 0, NULL
+};
+
 /*!
     @function v33_handler
 
-    @discussion Keyboard interrupt handler.
+    @discussion Keyboard interrupt handler. Reads the scan code, acknowledges
+    the interrupt and defers the rest to keyboard_tasklet, which runs with
+    interrupts enabled.
 
     @param vn Vector number
 
     @param err_code Error code
+
+    @param ctx NULL
 */
-void v33_handler(uint32_t vn, uint32_t err_code) {
-    uint8_t sc , kc;
-    char c;
+void v33_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    uint8_t sc;
 
-    if (vn || err_code) { // Suppress warning.
+    if (vn || err_code || ctx) { // Suppress warning.
         ;
     }
 
     sc = inb (0x0060); // Read keyboard output buffer.
-    pic_eoi(vn);
-    print_x32(sc);
-    print("\n");
-
-    kc = sc_sm_update(sc);
-    if(kc != SCAN_CODE_ERR && kc != SCAN_CODE_IGNORE) {
-        // Print something
-        c = kc_to_ascii(kc);
-        print_ch_at(c, 0, -1, -1);
+    irq_eoi(vn);
+
+    if (sc_head - sc_tail < SC_RING_SIZE) {
+        sc_ring[sc_head & (SC_RING_SIZE - 1)] = sc;
+        sc_head++;
+    } else {
+        sc_dropped++;
     }
+    tasklet_schedule(&keyboard_tasklet);
 }
 
-#if 0
-// TODO: Thoughts on how to implement <stdarg.h>
-void foo(int v, ...) {
-    // &v + 4 // call stack
-    if(v) {
-        ;
-    }
+/*!
+    @function keyboard_init
+
+    @discussion Installs the keyboard interrupt handler, v33_handler.
+*/
+void keyboard_init(void) {
+    int err;
+
+    err = request_irq(KEYBOARD_IRQ, v33_handler, NULL);
+    assert(err == 0);
 }
-#endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define __KEYBOARD_H__
 
 #include "../include/stdint.h"
+#include "../kernel/softirq.h"
 
 /*!
     @typedef    ps2_kbd_cmd_t
@@ -123,6 +124,20 @@ char scan_code_to_ascii (uint8_t sc);
 /*! See .c */
 int get_scan_code2(uint8_t *sc);
 
-void v33_handler(uint32_t vn, uint32_t err_code);
+/*!
+    @defined    KEYBOARD_IRQ
+
+    @discussion The IRQ line of the PS/2 keyboard.
+*/
+#define KEYBOARD_IRQ (1)
+
+/*! See .c */
+extern tasklet_t keyboard_tasklet;
+
+/*! See .c */
+void keyboard_init(void);
+
+/*! See .c */
+void v33_handler(uint32_t vn, uint32_t err_code, void *ctx);
 
 #endif
\ No newline at end of file
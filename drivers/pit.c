@@ -0,0 +1,251 @@
+/*!
+    @header 8254 Programmable Interval Timer driver.
+    Counter 0 of the PIT, wired to IRQ0, as the kernel's clock event device,
+    pit_clock_event, and its tick, jiffies.
+
+    @discussion Periodic mode is the counter's mode 2, rate generator: the
+    counter reloads itself and interrupts every count clocks, without
+    software. jiffies counts these interrupts, the ticks.
+
+    One-shot mode is the counter's mode 0, interrupt on terminal count: the
+    output goes low when the control word is written and high when the count
+    runs out, once. The counter then wraps around and keeps counting, but the
+    output stays high until the next control word. No tick while in one-shot
+    mode, jiffies stand still.
+
+    Switching modes may leave the edge of the previous mode pending at the
+    interrupt controller. v32_handler() tells it from an event with the
+    counter's status: the output of a counter in one-shot mode is only high
+    after its count ran out.
+
+    Counter 0 is programmed in binary, low byte then high byte. A count of 0
+    is 65536.
+
+    @doc [82C54 CHMOS Programmable Interval Timer]
+         (../kernel/docs/interrupts/intel-82c54-timer.pdf)
+*/
+
+#include "pit.h"
+#include "../include/stddef.h"
+#include "../kernel/idt.h"
+#include "../kernel/low_level.h"
+
+/*!
+    @defined    CW_PERIODIC, CW_ONESHOT
+
+    @discussion Control words of counter 0: read/write the low then the high
+    byte, binary, in mode 2 (rate generator) or mode 0 (interrupt on terminal
+    count).
+*/
+#define CW_PERIODIC (0x34)
+#define CW_ONESHOT (0x30)
+
+/*!
+    @defined    CW_READ_STATUS, STATUS_OUT
+
+    @discussion The read-back command latching the status of counter 0, but
+    not its count, and the status bit of the counter's output pin. The status
+    is then read from PIT_CH0.
+*/
+#define CW_READ_STATUS (0xE2)
+#define STATUS_OUT (0x80)
+
+/*!
+    @defined    PIT_MAX_DELTA_US
+
+    @discussion The longest one-shot delay, 65535 clocks.
+*/
+#define PIT_MAX_DELTA_US (54925U)
+
+/*!
+    @typedef    pit_mode_t
+
+    @discussion The mode counter 0 was programmed in.
+
+    @constant    PIT_OFF         No interrupt.
+    @constant    PIT_PERIODIC    Interrupts every tick.
+    @constant    PIT_ONESHOT     Interrupts once, then PIT_OFF.
+*/
+typedef enum _pit_mode_t {
+    PIT_OFF,
+    PIT_PERIODIC,
+    PIT_ONESHOT
+} pit_mode_t;
+
+/*!
+    @var    jiffies
+
+    @discussion The number of ticks since pit_init(). Wraps around, compare
+    with (int32_t) (a - b) < 0.
+*/
+volatile uint32_t jiffies;
+
+/*!
+    @var    mode, hz
+
+    @discussion The mode of counter 0 and, in periodic mode, the tick rate.
+    Both change with interrupts disabled.
+*/
+static volatile pit_mode_t mode;
+static uint32_t hz;
+
+/*!
+    @function    load
+
+    @discussion Writes control word cw and count to counter 0. Interrupts
+    must be disabled, a read-back in between would be taken for the count.
+*/
+static void load(uint8_t cw, uint32_t count) {
+    outb(PIT_CMD, cw);
+    outb(PIT_CH0, count & 0xFF);
+    outb(PIT_CH0, (count >> 8) & 0xFF);
+}
+
+/*!
+    @function    pit_set_periodic
+
+    @discussion Interrupts rate times per second. The count is rounded to the
+    nearest, e.g. 100 Hz is 11932 clocks, 100.0 Hz.
+
+    @result 0, -1 if rate isn't within PIT_MIN_HZ and PIT_MAX_HZ.
+*/
+static int pit_set_periodic(uint32_t rate) {
+    uint32_t flags;
+
+    if (rate < PIT_MIN_HZ || rate > PIT_MAX_HZ)
+        return -1;
+
+    flags = irq_save();
+    load(CW_PERIODIC, (PIT_FREQ + rate / 2) / rate);
+    mode = PIT_PERIODIC;
+    hz = rate;
+    irq_restore(flags);
+
+    return 0;
+}
+
+/*!
+    @function    pit_set_next_event
+
+    @discussion Interrupts once, in us microseconds, rounded down to whole
+    clocks of 838 ns. Reprogramming before the event replaces it.
+
+    @result 0, -1 if us is 0 or longer than PIT_MAX_DELTA_US.
+*/
+static int pit_set_next_event(uint32_t us) {
+    uint32_t flags, count;
+
+    if (us == 0 || us > PIT_MAX_DELTA_US)
+        return -1;
+
+    count = (uint64_t) us * PIT_FREQ / 1000000;
+    if (count == 0)
+        count = 1;
+
+    flags = irq_save();
+    load(CW_ONESHOT, count);
+    mode = PIT_ONESHOT;
+    hz = 0;
+    irq_restore(flags);
+
+    return 0;
+}
+
+/*!
+    @function    pit_shutdown
+
+    @discussion Stops the interrupts. The control word of mode 0 without a
+    count holds the output low.
+*/
+static void pit_shutdown(void) {
+    uint32_t flags;
+
+    flags = irq_save();
+    outb(PIT_CMD, CW_ONESHOT);
+    mode = PIT_OFF;
+    hz = 0;
+    irq_restore(flags);
+}
+
+/*!
+    @var    pit_clock_event
+
+    @discussion Counter 0 as a clock event device. Programmed periodic at
+    the rate of pit_init(), set handler to run code on each tick.
+*/
+clock_event_t pit_clock_event = {
+    "PIT", CLOCK_EVT_FEAT_PERIODIC | CLOCK_EVT_FEAT_ONESHOT,
+    1, PIT_MAX_DELTA_US,
+    pit_set_periodic, pit_set_next_event, pit_shutdown,
+    NULL, NULL
+};
+
+/*!
+    @function    pit_init
+
+    @discussion Installs v32_handler on IRQ0 and starts the tick. Until
+    init_interrupts() no tick is delivered.
+
+    @param    rate    The tick rate in Hz, e.g. PIT_HZ.
+
+    @result 0, -1 if rate is out of range, see pit_set_periodic().
+*/
+int pit_init(uint32_t rate) {
+    int err;
+
+    if (rate < PIT_MIN_HZ || rate > PIT_MAX_HZ)
+        return -1;
+
+    jiffies = 0;
+    pit_shutdown();
+    err = request_irq(PIT_IRQ, v32_handler, NULL);
+    if (err)
+        return err;
+
+    return pit_set_periodic(rate);
+}
+
+/*!
+    @function    pit_get_hz
+
+    @result The tick rate, 0 if counter 0 isn't in periodic mode.
+*/
+uint32_t pit_get_hz(void) {
+    return hz;
+}
+
+/*!
+    @function    v32_handler
+
+    @discussion PIT interrupt handler, IRQ0. Advances jiffies in periodic
+    mode, acknowledges the interrupt controller, then calls the clock event
+    handler. The edges left by a previous mode are ignored, see the header.
+
+    @param    vn          Vector number
+    @param    err_code    Error code
+    @param    ctx         NULL
+*/
+void v32_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    clock_event_handler_t handler;
+    uint32_t event = 0;
+
+    if (err_code || ctx) { // Suppress warning.
+        ;
+    }
+
+    if (mode == PIT_PERIODIC) {
+        jiffies++;
+        event = 1;
+    } else if (mode == PIT_ONESHOT) {
+        outb(PIT_CMD, CW_READ_STATUS);
+        if (inb(PIT_CH0) & STATUS_OUT) {
+            mode = PIT_OFF;
+            event = 1;
+        }
+    }
+    irq_eoi(vn);
+
+    handler = pit_clock_event.handler;
+    if (event && handler != NULL)
+        handler(pit_clock_event.ctx);
+}
@@ -0,0 +1,63 @@
+#ifndef __PIT_H__
+#define __PIT_H__
+
+#include "../include/stdint.h"
+#include "../kernel/clock_event.h"
+
+/*!
+    @defined    PIT_FREQ
+
+    @discussion The input clock of the 8254's counters, in Hz. A counter
+    loaded with n divides it by n.
+*/
+#define PIT_FREQ (1193182U)
+
+/*!
+    @defined    PIT_CH0, PIT_CMD
+
+    @discussion I/O ports of counter 0, wired to IRQ0, and of the control
+    word register.
+*/
+#define PIT_CH0 (0x40)
+#define PIT_CMD (0x43)
+
+/*!
+    @defined    PIT_IRQ
+
+    @discussion The IRQ line of counter 0.
+*/
+#define PIT_IRQ (0)
+
+/*!
+    @defined    PIT_HZ
+
+    @discussion The default tick rate, the rate jiffies advance at.
+*/
+#define PIT_HZ (100)
+
+/*!
+    @defined    PIT_MIN_HZ, PIT_MAX_HZ
+
+    @discussion The range of the periodic rate. The slowest divides PIT_FREQ
+    by 65536, the largest count. The fastest is capped well below PIT_FREQ / 2
+    to leave the CPU some time between interrupts.
+*/
+#define PIT_MIN_HZ (19)
+#define PIT_MAX_HZ (10000)
+
+/*! See .c */
+extern volatile uint32_t jiffies;
+
+/*! See .c */
+extern clock_event_t pit_clock_event;
+
+/*! See .c */
+int pit_init(uint32_t hz);
+
+/*! See .c */
+uint32_t pit_get_hz(void);
+
+/*! See .c */
+void v32_handler(uint32_t vn, uint32_t err_code, void *ctx);
+
+#endif
@@ -15,6 +15,7 @@
     @constant   DISABLE_DEV
     @constant   ENABLE_DEV
     @constant   R_OUTPUT_PORT
+    @constant   W_KBD_OUTPUT_BUF
     @constant   PULSE_OUTPUT_PORT_BIT0
 */
 typedef
@@ -29,6 +30,7 @@ enum _ctlr_cmd_t {
   //R_INPUT_PORT           = 0xC0, // Will not use.                               //
     R_OUTPUT_PORT          = 0xD0, // [] Test.                                    // Writes "controller output port." See osdev/8042 def.
   //W_OUTPUT_PORT          = 0xD1, // Will not use.                               //
+    W_KBD_OUTPUT_BUF       = 0xD2, // [] Test.                                    // The next data byte is put in the output buffer, as if received from the keyboard. Raises IRQ1.
   //R_TEST_INPUTS          = 0xE0, // Will not use.                               //
     PULSE_OUTPUT_PORT_BIT0 = 0xFE, // 0=pulse, 1=don't pulse.                     // Note: Pulses **LOW** for 6 microseconds (us), triggers "system reset".
   //PULSE_OUTPUT_PORT_BIT1 = 0xFD  // Will not use.                               // "Gate A20".
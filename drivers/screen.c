@@ -2,12 +2,38 @@
     @header A VGA screen driver.
     Implements functions for printing text to the screen. The underlying screen
     device is IBM VGA. @doc [IBM VGA docs](./docs/screen/screen.md).
+
+    @discussion Characters are rendered into a shadow buffer in RAM, the video
+    memory is only written by screen_flush(). A bit per row tracks the rows
+    changed since the last flush, hence a flush copies only those, 32 bits at a
+    time. Writing the uncached video memory a character or a scroll at a time
+    is what makes printing slow. print() and print_at() flush when done, unless
+    screen_set_autoflush(0) leaves the flushing to the caller, e.g. a periodic
+    tick. The cursor position is kept in a variable too, the flush moves the
+    hardware cursor.
+
+    The shadow buffer is a ring of SCROLLBACK_ROWS rows, the screen shows
+    MAX_ROWS consecutive rows of it. Scrolling advances the ring's top row and
+    clears one row, nothing is copied. Likewise the video memory is used as a
+    ring of VIDEO_ROWS rows: the CRTC start address selects the video memory
+    row displayed at the top of the screen, hence scrolling moves the start
+    address down a row and the flush only writes the new bottom row. Only when
+    the screen would run past the end of the video memory the start address
+    wraps to 0 and the whole screen is written.
+
+    The rows above the screen form the scrollback. screen_scrollback() pages
+    the view back through them, PgUp and PgDn on the keyboard.
+
+    @doc [CRTC Registers - Start Address High/Low Register]
+    (http://www.osdever.net/FreeVGA/vga/crtcreg.htm#0C)
 */
 
 #include "../include/mylibc.h"
 #include "../include/stdio.h" // NULL
+#include "../include/string.h" // memset()
 #include "screen.h"
 #include "../kernel/low_level.h"
+#include "../kernel/ioremap.h"
 
 
 /*!
@@ -20,6 +46,29 @@
 */
 #define VIDEO_ADDRESS 0xB8000
 
+/*!
+    @defined VIDEO_SIZE
+
+    @discussion The size of the video memory window of the text modes, 32 KiB
+    from VIDEO_ADDRESS.
+*/
+#define VIDEO_SIZE 0x8000
+
+/*!
+    @defined VIDEO_ROWS
+
+    @discussion The number of whole rows in the video memory window.
+*/
+#define VIDEO_ROWS (VIDEO_SIZE / (MAX_COLS * 2))
+
+/*!
+    @defined SCROLLBACK_ROWS
+
+    @discussion The number of rows of the shadow buffer, 8 screens. Those not
+    on screen are the scrollback.
+*/
+#define SCROLLBACK_ROWS (8 * MAX_ROWS)
+
 /*!
     @defined MAX_ROWS
 
@@ -72,6 +121,124 @@
 */
 #define CURSOR_LOCATION_LOW_BYTE 0x0F
 
+/*!
+    @defined START_ADDRESS_HIGH_BYTE
+
+    @discussion CRTC Registers - Start Address High 0xC. The character offset
+    of the top left character on screen.
+*/
+#define START_ADDRESS_HIGH_BYTE 0x0C
+
+/*!
+    @defined START_ADDRESS_LOW_BYTE
+
+    @discussion CRTC Registers - Start Address Low 0xD.
+*/
+#define START_ADDRESS_LOW_BYTE 0x0D
+
+/*!
+    @var video_base
+
+    @discussion The address through which the video memory is written.
+    VIDEO_ADDRESS, i.e. the identity map or no paging, until screen_map_wc()
+    or screen_set_base() change it.
+*/
+static uint8_t *video_base = (uint8_t *) VIDEO_ADDRESS;
+
+/*!
+    @var shadow
+
+    @discussion The shadow buffer, a ring of rows laid out like the video
+    memory. Aligned for the 32-bit copies of screen_flush().
+*/
+static uint16_t shadow[SCROLLBACK_ROWS * MAX_COLS] __attribute__((aligned(4)));
+
+/*!
+    @var shadow_top
+
+    @discussion The shadow buffer row at the top of the screen.
+*/
+static uint32_t shadow_top;
+
+/*!
+    @var history
+
+    @discussion The number of rows scrolled off the screen that are kept, up to
+    SCROLLBACK_ROWS - MAX_ROWS.
+*/
+static uint32_t history;
+
+/*!
+    @var view_back
+
+    @discussion The number of rows the view is scrolled back, 0 for the live
+    screen. See screen_scrollback().
+*/
+static uint32_t view_back;
+
+/*!
+    @var video_top
+
+    @discussion The video memory row displayed at the top of the screen. The
+    CRTC start address is video_top * MAX_COLS after a flush.
+*/
+static uint32_t video_top;
+
+/*!
+    @var crtc_start
+
+    @discussion The CRTC start address last programmed.
+*/
+static uint32_t crtc_start;
+
+/*!
+    @var cursor
+
+    @discussion The cursor position, a video memory offset on screen. Reading
+    and writing the CRTC cursor location for every character costs 8 port I/O
+    operations, hence the hardware cursor is only updated by screen_flush().
+*/
+static int cursor;
+
+/*!
+    @var cursor_hw
+
+    @discussion The character offset last written to the CRTC cursor location
+    registers, 0xFFFFFFFF if none.
+*/
+static uint32_t cursor_hw = 0xFFFFFFFF;
+
+/*!
+    @var cursor_suppressed
+
+    @discussion 1 if the hardware cursor is not updated, see
+    screen_suppress_cursor().
+*/
+static uint32_t cursor_suppressed;
+
+/*!
+    @var dirty_rows
+
+    @discussion Bit row is set if screen row row changed since the last
+    screen_flush().
+*/
+static uint32_t dirty_rows;
+
+/*!
+    @var autoflush
+
+    @discussion 1 if print() and print_at() flush when done. See
+    screen_set_autoflush().
+*/
+static uint32_t autoflush = 1;
+
+/*!
+    @defined ALL_ROWS
+
+    @discussion The dirty_rows value with every row dirty.
+*/
+#define ALL_ROWS ((1U << MAX_ROWS) - 1)
+
 /*!
     @function row_col_to_screen_video_mem_offset
 
@@ -102,6 +269,22 @@ static inline int vid_mem_offset_to_row (int vid_mem_offset) {
     return vid_mem_offset / (MAX_COLS * 2);
 }
 
+/*!
+    @function shadow_row
+
+    @discussion Returns screen row row of the shadow buffer, for a view
+    scrolled back by back rows.
+
+    @param    row     The screen row.
+    @param    back    The number of rows scrolled back.
+
+    @result The first cell of the row.
+*/
+static inline uint16_t *shadow_row(uint32_t row, uint32_t back) {
+    return &shadow[((shadow_top + SCROLLBACK_ROWS - back + row) %
+                    SCROLLBACK_ROWS) * MAX_COLS];
+}
+
 /*!
     @function get_cursor
 
@@ -112,76 +295,51 @@ static inline int vid_mem_offset_to_row (int vid_mem_offset) {
     position.
 */
 static inline int get_cursor(void) {
-    int vid_mem_offset;
-
-    /* The cursor position is stored in the VGA's internal registers in the
-    form of a character cell offset, as opposed to a video memory offset. A
-    character cell offset is = `row * MAX_COLS + col` while the video memory
-    offset is = `(row * MAX_COLS + col) * 2` since in video memory space
-    each character cell gets 2 bytes: viz. <ASCII CODE> and <ATTRIBUTES>. */
-    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_HIGH_BYTE);
-    vid_mem_offset = inb(REG_SCREEN_DATA_IO_PORT) << 8; // High byte.
-    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_LOW_BYTE);
-    vid_mem_offset += inb(REG_SCREEN_DATA_IO_PORT); // Low byte.
-
-    return vid_mem_offset * 2;
+    return cursor;
 }
 
 /*!
     @function set_cursor
 
-    @discussion Takes a cursor position in the form of a video memory offset,
-    converts that into a character offset, and finally writes that character
-    offset into the appropriate VGA internal registers.
+    @discussion Sets the cursor position. The hardware cursor follows on the
+    next screen_flush(), see update_cursor().
 
     @param    vid_mem_offset    The desired position of the cursor in the form
                                 of a video memory offset.
 */
 static inline void set_cursor(int vid_mem_offset) {
-
-    /* The algebra is: character offset = `(row * MAX_COLS + col) * 2` / `2` ==
-    `(row * MAX_COLS + col)`. */
-    vid_mem_offset /= 2;
-
-    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_HIGH_BYTE);
-    outb(REG_SCREEN_DATA_IO_PORT, (uint8_t) (vid_mem_offset >> 8) );
-    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_LOW_BYTE);
-    outb(REG_SCREEN_DATA_IO_PORT, (vid_mem_offset & 0x00FF));
-
+    cursor = vid_mem_offset;
 }
 
 /*!
-    @TODO Replace with to string.h->memcpy().
-    FYI: size_t is defined in stddef.h. On my mac is is a typedef of unsigned
-    long.
-*/
-static void memory_copy (void *dst, void *src, int n) {
-    uint8_t *d, *s;
-
-    if (dst == NULL || src == NULL || n == 0)
-        return;
-
-    d = dst;
-    s = src;
+    @function update_cursor
 
-    for (int i = 0; i < n; i++) {
-        d[i] = s[i];
-    }
-}
-
-/*!
-    @TODO Replace with to string.h->memset().
+    @discussion Converts the cursor position into a character offset and
+    writes that character offset into the appropriate VGA internal registers,
+    unless they hold it already or cursor updates are suppressed.
 */
-static void zero_memory (void *dst, int n) {
-    uint8_t *d;
+static void update_cursor(void) {
+    uint32_t offset;
 
-    if (dst == NULL || n == 0)
+    if (cursor_suppressed)
         return;
 
-    d = dst;
+    /* The cursor position is stored in the VGA's internal registers in the
+    form of a character cell offset, as opposed to a video memory offset. A
+    character cell offset is = `row * MAX_COLS + col` while the video memory
+    offset is = `(row * MAX_COLS + col) * 2` since in video memory space
+    each character cell gets 2 bytes: viz. <ASCII CODE> and <ATTRIBUTES>.
+    The cursor location counts from the start of video memory, not from the
+    top left character on screen. */
+    offset = cursor / 2 + video_top * MAX_COLS;
+    if (offset == cursor_hw)
+        return;
+    cursor_hw = offset;
 
-    for (int i = 0; i < n; i++)
-        d[i] = 0;
+    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_HIGH_BYTE);
+    outb(REG_SCREEN_DATA_IO_PORT, (uint8_t) (offset >> 8) );
+    outb(REG_SCREEN_CTRL_IO_PORT, CURSOR_LOCATION_LOW_BYTE);
+    outb(REG_SCREEN_DATA_IO_PORT, (offset & 0x00FF));
 }
 
 /*!
@@ -189,8 +347,11 @@ static void zero_memory (void *dst, int n) {
 
     @discussion Performs a scrolling operation if the given video memory offset
     indicates that the cursor has fallen off the bottom of the
-    screen. Scrolling means copying every row upwards and clearing
-    the last row.
+    screen. Scrolling means advancing the top row of the shadow buffer ring and
+    clearing the new last row. On screen the rows move up with the CRTC start
+    address, see screen_flush(). O(1) per row, unless the start address wraps.
+
+    A view scrolled back stays on the rows it shows.
 
     @param    vid_mem_offset    The video memory offset of the current cursor
                                 position.
@@ -200,42 +361,35 @@ static void zero_memory (void *dst, int n) {
 */
 static int handle_scrolling(int vid_mem_offset) {
     int trow;
-    uint8_t *vid_mem;
-
-    /*
-        Steps:
-
-        Check if scrolling must be done.
-        if no, return vid_mem_offset unchanged.
-        if yes,
-            Copy row to row-1, starting at row == 1, ending at row == 24.
-            Clear row == 24.
-            Return video memory offset of row == 24, col == 0.
-
-    */
 
     trow = vid_mem_offset_to_row (vid_mem_offset);
 
-    if (trow < 25)
+    if (trow < MAX_ROWS)
         return vid_mem_offset;
 
-    vid_mem = (uint8_t *) VIDEO_ADDRESS;
-
-    /*!
-        @defined SCROLL_MEM_COPY_SIZE
-
-        @discussion The number of bytes that must be copied to perform a scroll
-        operation. Scrolling requires copying 24 out of the 25 rows.
-    */
-    #define SCROLL_MEM_COPY_SIZE (((MAX_ROWS - 1) * MAX_COLS) * 2)
-
-    /* Copy rows. */
-    memory_copy(vid_mem, vid_mem + MAX_COLS * 2, SCROLL_MEM_COPY_SIZE);
+    shadow_top = (shadow_top + 1) % SCROLLBACK_ROWS;
+    if (history < SCROLLBACK_ROWS - MAX_ROWS)
+        history++;
 
     /* Clear last row. */
-    zero_memory (vid_mem + SCROLL_MEM_COPY_SIZE, MAX_COLS * 2);
+    memset(shadow_row(MAX_ROWS - 1, 0), 0, MAX_COLS * 2);
+
+    if (view_back) {
+        /* Keep the view, unless its top row was just reused. */
+        if (view_back < history)
+            view_back++;
+        else
+            dirty_rows = ALL_ROWS;
+    } else if (++video_top + MAX_ROWS > VIDEO_ROWS) {
+        /* Wrap to the start of video memory, the whole screen is copied. */
+        video_top = 0;
+        dirty_rows = ALL_ROWS;
+    } else {
+        /* The rows on screen are in video memory already, one row up. */
+        dirty_rows = (dirty_rows >> 1) | (1U << (MAX_ROWS - 1));
+    }
 
-    vid_mem_offset = row_col_to_screen_video_mem_offset (24, 0);
+    vid_mem_offset = row_col_to_screen_video_mem_offset (MAX_ROWS - 1, 0);
 
     return vid_mem_offset;
 }
@@ -278,14 +432,14 @@ static int handle_scrolling(int vid_mem_offset) {
     c == '\n' is handled specially, it has the natural behavior: it moves the
     cursor position 1 row below the current row.
 
+    The character is written to the shadow buffer, it is on screen after the
+    next screen_flush().
 */
 void print_ch_at(char c, uint8_t cattr, int row, int col) {
-    uint8_t *vid_mem;
+    uint16_t *cell;
     int vid_mem_offset;
     int trow;
 
-    vid_mem = (uint8_t *) VIDEO_ADDRESS;
-
     if (cattr == 0)
         cattr = CHAR_ATTR_WHITE_ON_BLACK;
 
@@ -308,8 +462,11 @@ void print_ch_at(char c, uint8_t cattr, int row, int col) {
         vid_mem_offset = row_col_to_screen_video_mem_offset(trow, 79);
     } else {
         /* Print the given character. */
-        vid_mem[vid_mem_offset] = c;
-        vid_mem[vid_mem_offset + 1] = cattr;
+        trow = vid_mem_offset_to_row (vid_mem_offset);
+        cell = shadow_row(trow, 0) + (vid_mem_offset / 2) % MAX_COLS;
+        *cell = (uint16_t) (cattr << 8 | (uint8_t) c);
+        if (view_back == 0)
+            dirty_rows |= 1U << trow;
     }
 
 
@@ -329,19 +486,160 @@ void print_ch_at(char c, uint8_t cattr, int row, int col) {
     @discussion Sets every character cell to the background color.
 */
 void clear_screen(void) {
-    uint8_t *vid_mem;
+    uint32_t row;
+
+    for (row = 0; row < MAX_ROWS; row++)
+        memset(shadow_row(row, 0), 0, MAX_COLS * 2);
+    view_back = 0;
+    dirty_rows = ALL_ROWS;
+    screen_flush();
+}
+
+/*!
+    @function screen_flush
+
+    @discussion Copies the dirty rows of the view to the video memory, with
+    32-bit stores, moves the CRTC start address to video_top and the hardware
+    cursor to the cursor position.
+*/
+void screen_flush(void) {
+    volatile uint32_t *dst;
+    const uint32_t *src;
+    uint32_t row, i;
+
+    if (dirty_rows) {
+        for (row = 0; row < MAX_ROWS; row++) {
+            if ((dirty_rows & (1U << row)) == 0)
+                continue;
+
+            src = (const uint32_t *) shadow_row(row, view_back);
+            dst = (volatile uint32_t *) (video_base +
+                                         (video_top + row) * MAX_COLS * 2);
+            for (i = 0; i < MAX_COLS / 2; i++)
+                dst[i] = src[i];
+        }
+
+        dirty_rows = 0;
+    }
+
+    /* After the rows are written, so the screen never shows stale rows. */
+    if (crtc_start != video_top * MAX_COLS) {
+        crtc_start = video_top * MAX_COLS;
+        outb(REG_SCREEN_CTRL_IO_PORT, START_ADDRESS_HIGH_BYTE);
+        outb(REG_SCREEN_DATA_IO_PORT, (uint8_t) (crtc_start >> 8));
+        outb(REG_SCREEN_CTRL_IO_PORT, START_ADDRESS_LOW_BYTE);
+        outb(REG_SCREEN_DATA_IO_PORT, (uint8_t) (crtc_start & 0x00FF));
+    }
+
+    update_cursor();
+}
+
+/*!
+    @function screen_suppress_cursor
+
+    @discussion Suppresses the hardware cursor updates, e.g. during bulk
+    output. The hardware cursor catches up when they are enabled again.
+
+    @param    suppress    1 to suppress the updates, 0 to enable them.
+*/
+void screen_suppress_cursor(uint32_t suppress) {
+    cursor_suppressed = suppress;
+    if (!suppress)
+        update_cursor();
+}
+
+/*!
+    @function screen_redraw
+
+    @discussion Writes the whole view to the video memory, e.g. after someone
+    else wrote to it.
+*/
+void screen_redraw(void) {
+    dirty_rows = ALL_ROWS;
+    screen_flush();
+}
+
+/*!
+    @function screen_scrollback
 
-    vid_mem = (uint8_t *) VIDEO_ADDRESS;
+    @discussion Scrolls the view back through the rows scrolled off the screen,
+    or forward towards the live screen. Output while scrolled back goes to the
+    live screen, the view stays on the rows it shows.
 
-    /*!
-        @defined CLEAR_SIZE
+    @param    lines    The number of rows to scroll back, negative to scroll
+                       forward. The view stops at the oldest row kept and at
+                       the live screen.
 
-        @discussion The number of bytes that must be zeroed to perform a clear
-        screen operation.
-    */
-    #define CLEAR_SIZE (MAX_ROWS * MAX_COLS * 2)
+    @result The number of rows the view is scrolled back, 0 if it shows the
+    live screen.
+*/
+uint32_t screen_scrollback(int lines) {
+    int back = (int) view_back + lines;
+
+    if (back < 0)
+        back = 0;
+    if (back > (int) history)
+        back = history;
 
-    zero_memory (vid_mem, CLEAR_SIZE);
+    if ((uint32_t) back != view_back) {
+        view_back = back;
+        screen_redraw();
+    }
+
+    return view_back;
+}
+
+/*!
+    @function screen_set_autoflush
+
+    @discussion Sets whether print() and print_at() flush when done. With
+    autoflush off the output is only visible after a screen_flush(), bulk
+    output then reaches the video memory in one batch.
+
+    @param    on    1 to flush on every print, 0 to leave it to the caller.
+*/
+void screen_set_autoflush(uint32_t on) {
+    autoflush = on;
+    if (on)
+        screen_flush();
+}
+
+/*!
+    @function screen_map_wc
+
+    @discussion Maps the video memory write combining, see ioremap_wc(), and
+    writes through the new mapping from now on. Glyph and scroll writes are
+    combined into bursts instead of one uncached bus write each. Call after
+    pat_init(). Keeps the identity mapping if ioremap_wc() fails.
+*/
+void screen_map_wc(void) {
+    void *base = ioremap_wc(VIDEO_ADDRESS, VIDEO_SIZE);
+
+    if (base != NULL)
+        video_base = base;
+}
+
+/*!
+    @function screen_get_base
+
+    @result The address through which the video memory is written.
+*/
+void *screen_get_base(void) {
+    return video_base;
+}
+
+/*!
+    @function screen_set_base
+
+    @discussion Sets the address through which the video memory is written,
+    e.g. to compare mappings. NULL for VIDEO_ADDRESS.
+
+    @param    base    A mapping of the VIDEO_SIZE bytes of video memory, or
+                      NULL.
+*/
+void screen_set_base(void *base) {
+    video_base = base != NULL ? base : (uint8_t *) VIDEO_ADDRESS;
+    dirty_rows = ALL_ROWS;
 }
 
 /*!
@@ -365,6 +663,9 @@ void print_at(const char *s, int row, int col) {
         print_ch_at(*s, 0, -1, -1);
         s++;
     }
+
+    if (autoflush)
+        screen_flush();
 }
 
 /*!
@@ -380,6 +681,9 @@ void print(const char *s) {
         print_ch_at(*s, 0, -1, -1);
         s++;
     }
+
+    if (autoflush)
+        screen_flush();
 }
 
 /*!
@@ -15,4 +15,20 @@ void clear_screen(void);
 void print_x32(uint32_t x);
 /*! See .c */
 void print_d(int d);
+/*! See .c */
+void screen_flush(void);
+/*! See .c */
+void screen_set_autoflush(uint32_t on);
+/*! See .c */
+void screen_suppress_cursor(uint32_t suppress);
+/*! See .c */
+void screen_redraw(void);
+/*! See .c */
+uint32_t screen_scrollback(int lines);
+/*! See .c */
+void screen_map_wc(void);
+/*! See .c */
+void *screen_get_base(void);
+/*! See .c */
+void screen_set_base(void *base);
 #endif
\ No newline at end of file
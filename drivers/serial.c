@@ -0,0 +1,444 @@
+/*!
+    @header 16550 UART serial driver.
+    COM1 output and input. With QEMU's `-serial stdio` the output is a fast,
+    machine readable channel for test results and benchmarks.
+
+    @discussion Output is interrupt driven. serial_write() copies the bytes to
+    the transmit ring and returns, the UART is fed from the ring by the
+    transmitter holding register empty (THRE) interrupt, IRQ4. With the FIFOs
+    enabled an interrupt writes up to SERIAL_FIFO_SIZE bytes, hence the UART
+    transmits back to back, at the line rate, for an interrupt every 16 bytes.
+    Only the first bytes of a burst are written by serial_write() itself, when
+    no THRE interrupt is expected.
+
+    If the ring is full, serial_write() waits for the UART by polling, with
+    interrupts disabled, hence it makes progress in any context, e.g. before
+    the interrupts are enabled or in an interrupt handler.
+
+    Input is received into the receive ring by the interrupt handler, on the
+    receiver data available and character timeout interrupts.
+    serial_getc() reads the ring.
+
+    The ring indices are free running, an index is taken modulo the ring size
+    when used. Both rings are only changed with interrupts disabled.
+
+    @doc [PC16550D Universal Asynchronous Receiver/Transmitter with FIFOs,
+          National Semiconductor]
+*/
+
+#include "serial.h"
+#include "../include/assert.h"
+#include "../include/mylibc.h"
+#include "../include/stdio.h"
+#include "../kernel/idt.h"
+#include "../kernel/low_level.h"
+
+/*!
+    @defined    LCR_8N1, LCR_DLAB
+
+    @discussion Line Control Register values: 8 data bits, no parity, 1 stop
+    bit; and the Divisor Latch Access Bit.
+*/
+#define LCR_8N1 (0x03)
+#define LCR_DLAB (BIT7)
+
+/*!
+    @defined    FCR_ENABLE
+
+    @discussion FIFO Control Register value: enable the FIFOs, clear both and
+    interrupt when the receive FIFO holds 14 bytes.
+*/
+#define FCR_ENABLE (0xC7)
+
+/*!
+    @defined    MCR_DTR_RTS_OUT2
+
+    @discussion Modem Control Register value: DTR and RTS asserted, OUT2 set.
+    OUT2 gates the UART interrupt output onto the IRQ line on the PC.
+*/
+#define MCR_DTR_RTS_OUT2 (0x0B)
+
+/*!
+    @defined    IER_RDA, IER_THRE, IER_RLS
+
+    @discussion Interrupt Enable Register bits: received data available,
+    transmitter holding register empty and receiver line status.
+*/
+#define IER_RDA (BIT0)
+#define IER_THRE (SERIAL_IER_THRE)
+#define IER_RLS (BIT2)
+
+/*!
+    @defined    IIR_NONE . . . IIR_MSR
+
+    @discussion Interrupt Identification Register, bits 3:0. IIR_NONE is set
+    when no interrupt is pending, otherwise the bits identify the highest
+    priority pending interrupt.
+*/
+#define IIR_ID_MASK (0x0F)
+#define IIR_NONE (0x01)
+#define IIR_RLS (0x06)      // Receiver line status. Cleared by reading LSR.
+#define IIR_RDA (0x04)      // Received data available. Cleared by reading RBR.
+#define IIR_TIMEOUT (0x0C)  // Character timeout. Cleared by reading RBR.
+#define IIR_THRE (0x02)     // THR empty. Cleared by reading IIR or writing THR.
+#define IIR_MSR (0x00)      // Modem status. Cleared by reading MSR.
+
+/*!
+    @defined    LSR_DR . . . LSR_TEMT
+
+    @discussion Line Status Register bits: data ready, overrun error,
+    transmitter holding register (and FIFO) empty, transmitter empty.
+*/
+#define LSR_DR (BIT0)
+#define LSR_OE (BIT1)
+#define LSR_THRE (SERIAL_LSR_THRE)
+#define LSR_TEMT (BIT6)
+
+/*!
+    @defined    EFLAGS_IF
+
+    @discussion The interrupt enable flag in EFLAGS, see irq_save().
+*/
+#define EFLAGS_IF (BITN(9))
+
+/*!
+    @defined    IIR_MAX_LOOPS
+
+    @discussion Bounds the interrupt handler's loop over the pending
+    interrupts, e.g. if the UART keeps reporting them.
+*/
+#define IIR_MAX_LOOPS (16)
+
+/*!
+    @var    tx_ring, tx_head, tx_tail
+
+    @discussion The transmit ring. Bytes are added at tx_head and written to
+    the UART from tx_tail.
+*/
+static char tx_ring[SERIAL_TX_RING];
+static volatile uint32_t tx_head, tx_tail;
+
+/*!
+    @var    tx_busy
+
+    @discussion Set while a THRE interrupt is expected, i.e. the UART was
+    given bytes and the interrupt handler will refill it. When clear, the
+    transmit FIFO is empty and serial_write() starts the transmission.
+*/
+static volatile uint32_t tx_busy;
+
+/*!
+    @var    rx_ring, rx_head, rx_tail
+
+    @discussion The receive ring. Bytes are added at rx_head and read from
+    rx_tail.
+*/
+static char rx_ring[SERIAL_RX_RING];
+static volatile uint32_t rx_head, rx_tail;
+
+/*!
+    @var    port
+
+    @discussion The I/O port base address of the UART, 0 if there is none.
+*/
+static uint16_t port;
+
+/*!
+    @var    stats
+
+    @discussion See serial_stats_t.
+*/
+static serial_stats_t stats;
+
+/*!
+    @function    tx_fill
+
+    @discussion Writes up to a FIFO's worth of bytes from the transmit ring to
+    the UART. Interrupts must be disabled and the transmit FIFO empty.
+*/
+static void tx_fill(void) {
+    uint32_t n;
+
+    for (n = 0; n < SERIAL_FIFO_SIZE && tx_tail != tx_head; n++) {
+        outb(port + SERIAL_THR, tx_ring[tx_tail & (SERIAL_TX_RING - 1)]);
+        tx_tail++;
+    }
+
+    stats.tx_bytes += n;
+    tx_busy = n != 0;
+}
+
+/*!
+    @function    rx_drain
+
+    @discussion Moves the received bytes from the UART to the receive ring.
+    Interrupts must be disabled.
+*/
+static void rx_drain(void) {
+    uint8_t lsr;
+    char c;
+
+    for (;;) {
+        lsr = inb(port + SERIAL_LSR);
+        if (lsr & LSR_OE)
+            stats.rx_overruns++;
+        if (!(lsr & LSR_DR))
+            break;
+        c = inb(port + SERIAL_RBR);
+        stats.rx_bytes++;
+        if (rx_head - rx_tail == SERIAL_RX_RING) {
+            stats.rx_dropped++;
+            continue;
+        }
+        rx_ring[rx_head & (SERIAL_RX_RING - 1)] = c;
+        rx_head++;
+    }
+}
+
+/*!
+    @function    klog_serial_write
+
+    @discussion Writes a record to the serial port, in the format of the VGA
+    console, with a "\r\n" line ending.
+*/
+static void klog_serial_write(const klog_record_t *r) {
+    char s[KLOG_MSG_MAX + 32]; // And the TSC and level.
+    int len;
+
+    len = snprintf(s, sizeof(s), "[%10llu] %c %s\r\n", r->tsc,
+                   "EWID"[r->level], r->msg);
+    if (len >= (int) sizeof(s))
+        len = sizeof(s) - 1;
+    serial_write(s, len);
+}
+
+/*!
+    @function    klog_serial_flush
+
+    @discussion Transmits the ring if interrupts are disabled, e.g. when an
+    exception handler or print_assert() drains the log. Only the 16 bytes
+    put in the FIFO by serial_write() would be sent otherwise. With
+    interrupts enabled the ring drains by itself.
+*/
+static void klog_serial_flush(void) {
+    uint32_t flags = irq_save();
+
+    irq_restore(flags);
+    if (!(flags & EFLAGS_IF))
+        serial_flush();
+}
+
+/*!
+    @var    klog_serial
+
+    @discussion The serial console, registered by serial_init().
+*/
+klog_consumer_t klog_serial = {
+    "serial", KLOG_DEBUG, klog_serial_write, klog_serial_flush, 0, 0, NULL
+};
+
+/*!
+    @function    serial_init
+
+    @discussion Initializes COM1: baud, 8N1, 16-byte FIFOs and the receive and
+    THRE interrupts, installs v36_handler on IRQ4 and registers the serial
+    console with klog. Until init_interrupts() the output is polled.
+
+    @param    baud    The baud rate, SERIAL_CLOCK divided by an integer.
+
+    @result 0, -1 if there is no UART at COM1.
+*/
+int serial_init(uint32_t baud) {
+    uint32_t divisor;
+    int err;
+
+    assert(baud > 0 && baud <= SERIAL_CLOCK && SERIAL_CLOCK % baud == 0);
+    divisor = SERIAL_CLOCK / baud;
+
+    // No UART if the scratch register doesn't keep a value.
+    outb(SERIAL_COM1 + SERIAL_SCR, 0xA5);
+    if (inb(SERIAL_COM1 + SERIAL_SCR) != 0xA5)
+        return -1;
+    port = SERIAL_COM1;
+
+    outb(port + SERIAL_IER, 0);
+    outb(port + SERIAL_LCR, LCR_DLAB);
+    outb(port + SERIAL_DLL, divisor & 0xFF);
+    outb(port + SERIAL_DLM, divisor >> 8);
+    outb(port + SERIAL_LCR, LCR_8N1);
+    outb(port + SERIAL_FCR, FCR_ENABLE);
+    outb(port + SERIAL_MCR, MCR_DTR_RTS_OUT2);
+
+    // Clear anything pending from before.
+    inb(port + SERIAL_LSR);
+    inb(port + SERIAL_RBR);
+    inb(port + SERIAL_IIR);
+    inb(port + SERIAL_MSR);
+
+    tx_head = tx_tail = 0;
+    tx_busy = 0;
+    rx_head = rx_tail = 0;
+    err = request_irq(SERIAL_COM1_IRQ, v36_handler, NULL);
+    assert(err == 0);
+    outb(port + SERIAL_IER, IER_RDA | IER_THRE | IER_RLS);
+
+    klog_register_consumer(&klog_serial);
+
+    return 0;
+}
+
+/*!
+    @function    serial_write
+
+    @discussion Writes n bytes to the serial port. Returns once the bytes are
+    in the transmit ring, unless the ring is full: then waits for the UART by
+    polling. Callable from interrupt handlers. Does nothing if there is no
+    UART.
+
+    @param    buf    The bytes.
+    @param    n      The number of bytes.
+*/
+void serial_write(const char *buf, uint32_t n) {
+    uint32_t flags, room;
+
+    if (port == 0)
+        return;
+
+    while (n) {
+        flags = irq_save();
+
+        room = SERIAL_TX_RING - (tx_head - tx_tail);
+        if (room == 0) {
+            // Full. Wait for the FIFO to empty, the pending THRE interrupt,
+            // if any, finds an empty IIR or the FIFO empty again.
+            stats.tx_polls++;
+            while (!(inb(port + SERIAL_LSR) & LSR_THRE))
+                ;
+            tx_fill();
+        }
+        for (; room && n; room--, n--) {
+            tx_ring[tx_head & (SERIAL_TX_RING - 1)] = *buf++;
+            tx_head++;
+        }
+        if (!tx_busy)
+            tx_fill();
+
+        irq_restore(flags);
+    }
+}
+
+/*!
+    @function    serial_puts
+
+    @discussion Writes the '\0' terminated string s to the serial port. No
+    '\n' translation.
+*/
+void serial_puts(const char *s) {
+    uint32_t n;
+
+    for (n = 0; s[n]; n++)
+        ;
+    serial_write(s, n);
+}
+
+/*!
+    @function    serial_getc
+
+    @discussion Reads a received byte. Also polls the UART, hence works with
+    interrupts disabled.
+
+    @result The byte, -1 if none was received.
+*/
+int serial_getc(void) {
+    uint32_t flags;
+    int c = -1;
+
+    if (port == 0)
+        return -1;
+
+    flags = irq_save();
+    rx_drain();
+    if (rx_tail != rx_head) {
+        c = (uint8_t) rx_ring[rx_tail & (SERIAL_RX_RING - 1)];
+        rx_tail++;
+    }
+    irq_restore(flags);
+
+    return c;
+}
+
+/*!
+    @function    serial_flush
+
+    @discussion Waits until every byte written was transmitted, e.g. before
+    QEMU is exited or the port is reconfigured. With interrupts enabled the
+    ring is drained by the interrupt handler, otherwise by polling.
+*/
+void serial_flush(void) {
+    uint32_t flags;
+    uint8_t lsr;
+
+    if (port == 0)
+        return;
+
+    do {
+        flags = irq_save();
+        lsr = inb(port + SERIAL_LSR);
+        if (!(flags & EFLAGS_IF) && (lsr & LSR_THRE) && tx_tail != tx_head)
+            tx_fill();
+        irq_restore(flags);
+    } while (tx_tail != tx_head || !(lsr & LSR_TEMT));
+}
+
+/*!
+    @function    serial_get_stats
+
+    @result The driver statistics, see serial_stats_t.
+*/
+const serial_stats_t *serial_get_stats(void) {
+    return &stats;
+}
+
+/*!
+    @function    v36_handler
+
+    @discussion COM1 interrupt handler, IRQ4. Serves every pending interrupt
+    of the UART, highest priority first, then acknowledges the interrupt
+    controller.
+
+    @param    vn          Vector number
+    @param    err_code    Error code
+    @param    ctx         NULL
+*/
+void v36_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    uint8_t iir;
+    int i;
+
+    if (err_code || ctx) { // Suppress warning.
+        ;
+    }
+
+    for (i = 0; port && i < IIR_MAX_LOOPS; i++) {
+        iir = inb(port + SERIAL_IIR) & IIR_ID_MASK;
+        if (iir & IIR_NONE)
+            break;
+
+        switch (iir) {
+        case IIR_THRE:
+            stats.tx_irqs++;
+            tx_fill();
+            break;
+        case IIR_RDA:
+        case IIR_TIMEOUT:
+        case IIR_RLS:
+            rx_drain();
+            break;
+        case IIR_MSR:
+        default:
+            inb(port + SERIAL_MSR);
+            break;
+        }
+    }
+
+    irq_eoi(vn);
+}
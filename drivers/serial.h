@@ -0,0 +1,134 @@
+#ifndef __SERIAL_H__
+#define __SERIAL_H__
+
+#include "../include/stdint.h"
+#include "../kernel/klog.h"
+
+/*!
+    @defined    SERIAL_COM1
+
+    @discussion I/O port base address of the COM1 UART.
+*/
+#define SERIAL_COM1 (0x3F8)
+
+/*!
+    @defined    SERIAL_COM1_IRQ
+
+    @discussion The IRQ line of COM1.
+*/
+#define SERIAL_COM1_IRQ (4)
+
+/*!
+    @defined    SERIAL_THR . . . SERIAL_SCR
+
+    @discussion 16550 register offsets from the port base address. DLL and DLM
+    replace THR/RBR and IER while LCR.DLAB is set.
+
+    @doc [PC16550D UART with FIFOs, Table II. Register Addresses]
+*/
+#define SERIAL_THR (0) // Transmitter Holding Register (write).
+#define SERIAL_RBR (0) // Receiver Buffer Register (read).
+#define SERIAL_DLL (0) // Divisor Latch, low byte (DLAB = 1).
+#define SERIAL_IER (1) // Interrupt Enable Register.
+#define SERIAL_DLM (1) // Divisor Latch, high byte (DLAB = 1).
+#define SERIAL_IIR (2) // Interrupt Identification Register (read).
+#define SERIAL_FCR (2) // FIFO Control Register (write).
+#define SERIAL_LCR (3) // Line Control Register.
+#define SERIAL_MCR (4) // Modem Control Register.
+#define SERIAL_LSR (5) // Line Status Register.
+#define SERIAL_MSR (6) // Modem Status Register.
+#define SERIAL_SCR (7) // Scratch Register.
+
+/*!
+    @defined    SERIAL_MCR_LOOP
+
+    @discussion MCR loopback bit: the transmitter output is looped back to the
+    receiver.
+*/
+#define SERIAL_MCR_LOOP (0x10)
+
+/*!
+    @defined    SERIAL_IER_THRE
+
+    @discussion IER bit: the transmitter holding register empty interrupt.
+    Setting it while THR is empty raises the interrupt.
+*/
+#define SERIAL_IER_THRE (0x02)
+
+/*!
+    @defined    SERIAL_LSR_THRE
+
+    @discussion LSR bit: the transmitter holding register (and FIFO) is empty.
+*/
+#define SERIAL_LSR_THRE (0x20)
+
+/*!
+    @defined    SERIAL_CLOCK
+
+    @discussion The highest baud rate, the UART clock (1.8432 MHz) divided by
+    16. The baud rate is SERIAL_CLOCK / divisor.
+*/
+#define SERIAL_CLOCK (115200U)
+
+/*!
+    @defined    SERIAL_FIFO_SIZE
+
+    @discussion The depth of the 16550 transmit and receive FIFOs.
+*/
+#define SERIAL_FIFO_SIZE (16)
+
+/*!
+    @defined    SERIAL_TX_RING, SERIAL_RX_RING
+
+    @discussion The sizes of the transmit and receive rings, powers of 2.
+*/
+#define SERIAL_TX_RING (4096)
+#define SERIAL_RX_RING (256)
+
+/*!
+    @typedef    serial_stats_t
+
+    @discussion Statistics of the COM1 driver.
+
+    @field    tx_bytes       Bytes written to the UART.
+    @field    tx_irqs        Transmitter holding register empty interrupts.
+    @field    tx_polls       Writes that found the ring full and waited for
+                             the UART by polling.
+    @field    rx_bytes       Bytes read from the UART.
+    @field    rx_dropped     Bytes read while the receive ring was full.
+    @field    rx_overruns    Receive FIFO overruns reported by the UART.
+*/
+typedef struct _serial_stats_t {
+    uint32_t tx_bytes;
+    uint32_t tx_irqs;
+    uint32_t tx_polls;
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;
+    uint32_t rx_overruns;
+} serial_stats_t;
+
+/*! See .c */
+extern klog_consumer_t klog_serial;
+
+/*! See .c */
+int serial_init(uint32_t baud);
+
+/*! See .c */
+void serial_write(const char *buf, uint32_t n);
+
+/*! See .c */
+void serial_puts(const char *s);
+
+/*! See .c */
+int serial_getc(void);
+
+/*! See .c */
+void serial_flush(void);
+
+/*! See .c */
+const serial_stats_t *serial_get_stats(void);
+
+/*! See .c */
+void v36_handler(uint32_t vn, uint32_t err_code, void *ctx);
+
+#endif
@@ -3,6 +3,7 @@
 */
 
 #include "assert.h"
+#include "../kernel/klog.h"
 
 /*!
     @function dead_loop
@@ -21,11 +22,11 @@ void dead_loop(void) {
 /*!
     @function print_assert
 
-    @discussion Prints a message associated with the assert macro. @doc
+    @discussion Logs a message associated with the assert macro and drains the
+    log, the dead loop that follows never gets to it otherwise. @doc
     [assert.h on your local machine](include/assert.h)
     @doc [man page for assert](man assert). @TODO This is a temporary
-    approximation to what the standard assert macro prints. Print should be
-    replaced by printf().
+    approximation to what the standard assert macro prints.
 
     @param    e    A string, the expression that was evaluated as false by the
                    assert macro.
@@ -37,10 +38,6 @@ void dead_loop(void) {
 
 */
 void print_assert(char *e, char *f, int l) {
-    print(f);
-    print(":");
-    print_d(l); // @TODO Print in decimal.
-    print(": failed assertion `");
-    print(e);
-    print("'\n");
+    klog(KLOG_ERR, "%s:%d: failed assertion `%s'", f, l, e);
+    klog_drain();
 }
\ No newline at end of file
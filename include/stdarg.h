@@ -0,0 +1,50 @@
+/*!
+    @header Standard C Header
+    Variable argument lists.
+
+    @discussion The cdecl calling convention pushes the arguments right to left,
+    hence the variable arguments follow the last named one on the stack, each
+    rounded up to 4 bytes. The compiler's builtins walk them, they also know
+    about the promotions (char and short to int, float to double) and work at
+    any optimization level, unlike pointer arithmetic on &last.
+*/
+
+#ifndef __STDARG_H__
+#define __STDARG_H__
+
+/*!
+    @typedef    va_list
+
+    @discussion The state of a walk through the variable arguments.
+*/
+typedef __builtin_va_list va_list;
+
+/*!
+    @defined    va_start(ap, last)
+
+    @discussion Starts the walk after the last named argument last.
+*/
+#define va_start(ap, last) __builtin_va_start(ap, last)
+
+/*!
+    @defined    va_arg(ap, type)
+
+    @discussion Returns the next argument, of the promoted type type.
+*/
+#define va_arg(ap, type) __builtin_va_arg(ap, type)
+
+/*!
+    @defined    va_copy(dst, src)
+
+    @discussion Copies the walk src, e.g. to walk the arguments twice.
+*/
+#define va_copy(dst, src) __builtin_va_copy(dst, src)
+
+/*!
+    @defined    va_end(ap)
+
+    @discussion Ends the walk.
+*/
+#define va_end(ap) __builtin_va_end(ap)
+
+#endif
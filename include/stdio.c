@@ -3,8 +3,10 @@
 */
 
 #include "stdio.h"
+#include "stdint.h"
 #include "assert.h"
 #include "limits.h"
+#include "../drivers/screen.h" // print()
 
 /*!
     @function    rstr
@@ -294,6 +296,375 @@ int _otoa(unsigned long long o, int nbits, char *s) {
     return 0;
 }
 
+/*!
+    @typedef    fmt_flags_t
+
+    @discussion The flags of a conversion specification, see vsnprintf().
+
+    @constant    FMT_LEFT     '-', pad on the right.
+    @constant    FMT_ZERO     '0', pad numbers with zeros.
+    @constant    FMT_PLUS     '+', prefix positive numbers with '+'.
+    @constant    FMT_SPACE    ' ', prefix positive numbers with ' '.
+    @constant    FMT_ALT      '#', prefix hexadecimal with 0x, octal with 0.
+*/
+typedef
+enum _fmt_flags_t {
+    FMT_LEFT = 1,
+    FMT_ZERO = 2,
+    FMT_PLUS = 4,
+    FMT_SPACE = 8,
+    FMT_ALT = 16
+} fmt_flags_t;
+
+/*!
+    @typedef    fmt_length_t
+
+    @discussion The length modifiers, see vsnprintf().
+*/
+typedef
+enum _fmt_length_t {
+    FMT_INT,
+    FMT_CHAR,       // hh
+    FMT_SHORT,      // h
+    FMT_LONG,       // l
+    FMT_LONG_LONG,  // ll
+    FMT_SIZE        // z
+} fmt_length_t;
+
+/*!
+    @defined    FMT_DIGITS_MAX
+
+    @discussion The most digits of a 64-bit value, 22 in octal.
+*/
+#define FMT_DIGITS_MAX 22
+
+/*!
+    @function    put_ch
+
+    @discussion Appends c to the output of vsnprintf(), if it fits. len counts
+    the characters whether they fit or not.
+*/
+static inline void put_ch(char *s, size_t n, size_t *len, char c) {
+    if (*len + 1 < n)
+        s[*len] = c;
+    (*len)++;
+}
+
+/*!
+    @function    put_rep
+
+    @discussion Appends count copies of c, see put_ch().
+*/
+static inline void put_rep(char *s, size_t n, size_t *len, char c,
+                           int count) {
+    while (count-- > 0)
+        put_ch(s, n, len, c);
+}
+
+/*!
+    @function    fmt_digits
+
+    @discussion Converts v to digits in base base, right aligned at end.
+    Values that fit 32 bits are divided in 32 bits, a 64-bit division is a
+    libgcc call.
+
+    @result The first digit.
+*/
+static char *fmt_digits(char *end, unsigned long long v, uint32_t base,
+                        int upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint32_t v32;
+
+    if ((v >> 32) == 0) {
+        v32 = (uint32_t) v;
+        do {
+            *--end = digits[v32 % base];
+            v32 /= base;
+        } while (v32);
+    } else {
+        do {
+            *--end = digits[v % base];
+            v /= base;
+        } while (v);
+    }
+
+    return end;
+}
+
+/*!
+    @function    vsnprintf
+
+    @discussion Formats a string into s, in one pass over fmt. A conversion
+    specification is
+
+    %[flags][width][.precision][length]conversion
+
+    flags: '-', '0', '+', ' ', '#', see fmt_flags_t.
+    width: the minimum field width, a number or '*' for an int argument.
+    precision: the minimum number of digits, the maximum number of characters
+    of a string. A number or '*'.
+    length: hh, h, l, ll, z.
+    conversion: d, i, u, x, X, o, s, c, p (as %#010x), %.
+
+    Unknown conversions are copied as is.
+
+    @param    s      The output buffer.
+    @param    n      The size of s. At most n - 1 characters and a '\0' are
+                     written.
+    @param    fmt    The format string.
+    @param    ap     The arguments.
+
+    @result The length of the formatted string, the output was truncated if it
+    is >= n.
+*/
+int vsnprintf(char *s, size_t n, const char *fmt, va_list ap) {
+    char buf[FMT_DIGITS_MAX], *p;
+    unsigned long long v;
+    fmt_length_t length;
+    int flags, width, prec, ndigits, zeros, total;
+    const char *prefix, *str;
+    size_t len = 0;
+    uint32_t base;
+    long long d;
+    char sign;
+
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') {
+            put_ch(s, n, &len, *fmt);
+            continue;
+        }
+
+        /* Flags. */
+        flags = 0;
+        for (;;) {
+            fmt++;
+            if (*fmt == '-')
+                flags |= FMT_LEFT;
+            else if (*fmt == '0')
+                flags |= FMT_ZERO;
+            else if (*fmt == '+')
+                flags |= FMT_PLUS;
+            else if (*fmt == ' ')
+                flags |= FMT_SPACE;
+            else if (*fmt == '#')
+                flags |= FMT_ALT;
+            else
+                break;
+        }
+
+        /* Width. */
+        width = 0;
+        if (*fmt == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                flags |= FMT_LEFT;
+                width = -width;
+            }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9')
+                width = width * 10 + *fmt++ - '0';
+        }
+
+        /* Precision. */
+        prec = -1;
+        if (*fmt == '.') {
+            fmt++;
+            prec = 0;
+            if (*fmt == '*') {
+                prec = va_arg(ap, int);
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9')
+                    prec = prec * 10 + *fmt++ - '0';
+            }
+        }
+
+        /* Length. */
+        length = FMT_INT;
+        if (*fmt == 'h') {
+            length = FMT_SHORT;
+            if (*++fmt == 'h') {
+                length = FMT_CHAR;
+                fmt++;
+            }
+        } else if (*fmt == 'l') {
+            length = FMT_LONG;
+            if (*++fmt == 'l') {
+                length = FMT_LONG_LONG;
+                fmt++;
+            }
+        } else if (*fmt == 'z') {
+            length = FMT_SIZE;
+            fmt++;
+        }
+
+        /* Conversion. */
+        sign = 0;
+        prefix = "";
+        base = 10;
+        switch (*fmt) {
+        case 'd':
+        case 'i':
+            if (length == FMT_LONG_LONG)
+                d = va_arg(ap, long long);
+            else if (length == FMT_LONG)
+                d = va_arg(ap, long);
+            else if (length == FMT_SHORT)
+                d = (short) va_arg(ap, int);
+            else if (length == FMT_CHAR)
+                d = (signed char) va_arg(ap, int);
+            else
+                d = va_arg(ap, int);
+
+            if (d < 0) {
+                sign = '-';
+                v = -(unsigned long long) d;
+            } else {
+                sign = flags & FMT_PLUS ? '+' : flags & FMT_SPACE ? ' ' : 0;
+                v = d;
+            }
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            base = *fmt == 'u' ? 10 : *fmt == 'o' ? 8 : 16;
+            if (length == FMT_LONG_LONG)
+                v = va_arg(ap, unsigned long long);
+            else if (length == FMT_LONG)
+                v = va_arg(ap, unsigned long);
+            else if (length == FMT_SIZE)
+                v = va_arg(ap, size_t);
+            else if (length == FMT_SHORT)
+                v = (unsigned short) va_arg(ap, unsigned int);
+            else if (length == FMT_CHAR)
+                v = (unsigned char) va_arg(ap, unsigned int);
+            else
+                v = va_arg(ap, unsigned int);
+
+            if (base == 16 && (flags & FMT_ALT) && v != 0)
+                prefix = *fmt == 'X' ? "0X" : "0x";
+            break;
+        case 'p':
+            v = (uint32_t) va_arg(ap, void *);
+            base = 16;
+            prefix = "0x";
+            prec = 8;
+            break;
+        case 'c':
+            if (!(flags & FMT_LEFT))
+                put_rep(s, n, &len, ' ', width - 1);
+            put_ch(s, n, &len, (char) va_arg(ap, int));
+            if (flags & FMT_LEFT)
+                put_rep(s, n, &len, ' ', width - 1);
+            continue;
+        case 's':
+            str = va_arg(ap, const char *);
+            if (str == NULL)
+                str = "(null)";
+            for (total = 0; str[total] && (prec < 0 || total < prec); total++)
+                ;
+            if (!(flags & FMT_LEFT))
+                put_rep(s, n, &len, ' ', width - total);
+            for (zeros = 0; zeros < total; zeros++)
+                put_ch(s, n, &len, str[zeros]);
+            if (flags & FMT_LEFT)
+                put_rep(s, n, &len, ' ', width - total);
+            continue;
+        case '%':
+            put_ch(s, n, &len, '%');
+            continue;
+        case '\0':
+            fmt--; // The loop stops at the '\0'.
+            continue;
+        default:
+            put_ch(s, n, &len, '%');
+            put_ch(s, n, &len, *fmt);
+            continue;
+        }
+
+        /*
+            A number: [spaces][sign|prefix][zeros]digits[spaces]. A precision
+            of 0 prints no digits for 0.
+        */
+        p = fmt_digits(buf + FMT_DIGITS_MAX, v, base, *fmt == 'X');
+        ndigits = buf + FMT_DIGITS_MAX - p;
+        if (prec == 0 && v == 0)
+            ndigits = 0;
+        zeros = prec > ndigits ? prec - ndigits : 0;
+        if (base == 8 && (flags & FMT_ALT) && zeros == 0 &&
+            (ndigits == 0 || *p != '0'))
+            zeros = 1;
+
+        total = (sign != 0) + (prefix[0] ? 2 : 0) + zeros + ndigits;
+        if ((flags & (FMT_ZERO | FMT_LEFT)) == FMT_ZERO && prec < 0 &&
+            width > total) {
+            zeros += width - total;
+            total = width;
+        }
+
+        if (!(flags & FMT_LEFT))
+            put_rep(s, n, &len, ' ', width - total);
+        if (sign)
+            put_ch(s, n, &len, sign);
+        for (str = prefix; *str; str++)
+            put_ch(s, n, &len, *str);
+        put_rep(s, n, &len, '0', zeros);
+        while (ndigits-- > 0)
+            put_ch(s, n, &len, *p++);
+        if (flags & FMT_LEFT)
+            put_rep(s, n, &len, ' ', width - total);
+    }
+
+    if (n > 0)
+        s[len < n ? len : n - 1] = '\0';
+
+    return len;
+}
+
+/*!
+    @function    snprintf
+
+    @discussion Formats a string into s, see vsnprintf().
+
+    @result The length of the formatted string, the output was truncated if it
+    is >= n.
+*/
+int snprintf(char *s, size_t n, const char *fmt, ...) {
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(s, n, fmt, ap);
+    va_end(ap);
+
+    return len;
+}
+
+/*!
+    @function    kprintf
+
+    @discussion Formats a string, see vsnprintf(), and prints it with a single
+    print() call. Output longer than KPRINTF_BUF_SIZE - 1 characters is
+    truncated.
+
+    @result The length of the formatted string.
+*/
+int kprintf(const char *fmt, ...) {
+    char s[KPRINTF_BUF_SIZE];
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(s, sizeof(s), fmt, ap);
+    va_end(ap);
+
+    print(s);
+
+    return len;
+}
+
 ///////////////////////////
 /*!
     @function print_byteb
@@ -1,6 +1,9 @@
 #ifndef __STDIO_H__
 #define __STDIO_H__
 
+#include "stddef.h" // size_t
+#include "stdarg.h" // va_list
+
 /*!
     @defined    NULL
 
@@ -32,6 +35,13 @@
 */
 #define STDIO_STR_SIZE_MAX 32
 
+/*!
+    @defined KPRINTF_BUF_SIZE
+
+    @discussion The size of the buffer kprintf() formats into.
+*/
+#define KPRINTF_BUF_SIZE 256
+
 /*! See .c */
 int _utoa(unsigned long long d, char *s);
 /*! See .c */
@@ -40,4 +50,11 @@ int _dtoa(long long d, char *s);
 int _xtoa(unsigned long long x, int nbits, char *s, int cf);
 /*! See .c */
 int _otoa(unsigned long long o, int nbits, char *s);
+/*! See .c */
+int vsnprintf(char *s, size_t n, const char *fmt, va_list ap);
+/*! See .c */
+int snprintf(char *s, size_t n, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+/*! See .c */
+int kprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 #endif
\ No newline at end of file
@@ -1,9 +1,72 @@
 /*!
     @header Standard C Header
+    Also the kernel heap, kmalloc() and friends.
+
+    @discussion kmalloc() rounds small requests up to a power of 2 size class,
+    KMALLOC_MIN_SIZE to KMALLOC_MAX_SIZE, and allocates them from the slab
+    cache of the class, see kernel/slab.c. Larger requests take a block of
+    whole pages from the buddy allocator, see kernel/buddy.c.
+
+    The metadata is out of line, there is no header in front of a block: a
+    byte per frame, indexed by the frame of a block's address, holds the size
+    class or the buddy order of the block. kfree() looks up the byte, freed
+    blocks are only touched by the slab free pointer.
 */
 
 #include "ctype.h" // digittoint() etc.
 #include "stdio.h" //  NULL
+#include "stdint.h"
+#include "limits.h" // UINT32_MAX
+#include "string.h" // memcpy(), memset()
+#include "assert.h"
+#include "stdlib.h"
+#include "../drivers/screen.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/buddy.h"
+#include "../kernel/slab.h"
+
+/*!
+    @defined    KMALLOC_CLASSES
+
+    @discussion The number of size classes, KMALLOC_MIN_SIZE << k for
+    0 <= k < KMALLOC_CLASSES.
+*/
+#define KMALLOC_CLASSES (8)
+
+/*!
+    @defined    KMALLOC_LARGE
+
+    @discussion Set in the frame byte of a block from the buddy allocator. The
+    low bits are the block order.
+*/
+#define KMALLOC_LARGE (0x80)
+
+/*!
+    @var    kmalloc_caches
+
+    @discussion The slab cache of each size class.
+*/
+static kmem_cache_t *kmalloc_caches[KMALLOC_CLASSES];
+
+/*!
+    @var    kmalloc_names
+
+    @discussion The cache name of each size class.
+*/
+static const char *kmalloc_names[KMALLOC_CLASSES] = {
+    "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048"
+};
+
+/*!
+    @var    kmalloc_frame
+
+    @discussion A byte per frame of the kernel's frame pool. For the frame of
+    a block's address: size class + 1 or KMALLOC_LARGE | order. 0 if the frame
+    never held a block's address. An entry goes stale when its frame is
+    reused, kmalloc() rewrites it for each block it returns.
+*/
+static uint8_t *kmalloc_frame;
 
 /*!
     @function atoi
@@ -52,4 +115,187 @@ int atoi(const char *str) {
     }
 
     return sum * sign;
-}
\ No newline at end of file
+}
+
+/*!
+    @function    bsr32
+
+    @discussion Returns the index of the highest set bit of x. The result is
+    undefined if x is 0. @doc [BSR](Intel 64 & IA-32 Arch. SDM Vol.2A Ch.3.2)
+*/
+static inline __attribute__((always_inline)) uint32_t bsr32(uint32_t x) {
+    uint32_t r;
+
+    __asm__("bsr %1, %0" : "=r" (r) : "rm" (x));
+
+    return r;
+}
+
+/*!
+    @function    kmalloc_init
+
+    @discussion Allocates the frame bytes and creates the slab caches of the
+    size classes. Call after buddy_init().
+*/
+void kmalloc_init(void) {
+    uint32_t frames, addr, size, k;
+
+    frames = (frame_count() + FRAME_SIZE - 1) / FRAME_SIZE;
+    addr = frame_alloc_contig(frames, 1);
+    if (addr == FRAME_NONE) {
+        print("kmalloc_init: no memory for the frame bytes.\n");
+        return;
+    }
+    memset((void *) addr, 0, frame_count());
+
+    for (k = 0; k < KMALLOC_CLASSES; k++) {
+        size = KMALLOC_MIN_SIZE << k;
+        kmalloc_caches[k] = kmem_cache_create(kmalloc_names[k], size,
+            size < KMEM_CACHE_LINE ? size : KMEM_CACHE_LINE, NULL);
+        assert(kmalloc_caches[k] != NULL);
+    }
+
+    kmalloc_frame = (uint8_t *) addr;
+}
+
+/*!
+    @function    kmalloc
+
+    @discussion Allocates size bytes. The block is aligned to its size class,
+    up to KMEM_CACHE_LINE, blocks larger than KMALLOC_MAX_SIZE are page
+    aligned.
+
+    @param    size    The size in bytes.
+
+    @result The block, NULL if size is 0 or out of memory.
+*/
+void *kmalloc(size_t size) {
+    uint32_t k, addr;
+    void *p;
+
+    assert(kmalloc_frame != NULL);
+
+    if (size == 0)
+        return NULL;
+
+    if (size <= KMALLOC_MAX_SIZE) {
+        k = size <= KMALLOC_MIN_SIZE ? 0 : bsr32(size - 1) - 3;
+        p = kmem_cache_alloc(kmalloc_caches[k]);
+        if (p)
+            kmalloc_frame[(uint32_t) p >> FRAME_SHIFT] = k + 1;
+        return p;
+    }
+
+    k = size <= FRAME_SIZE ? 0 : bsr32(size - 1) - FRAME_SHIFT + 1;
+    if (k > BUDDY_MAX_ORDER)
+        return NULL;
+    addr = buddy_alloc(k);
+    if (addr == BUDDY_NONE)
+        return NULL;
+    kmalloc_frame[addr >> FRAME_SHIFT] = KMALLOC_LARGE | k;
+
+    return (void *) addr;
+}
+
+/*!
+    @function    kfree
+
+    @discussion Frees a block allocated with kmalloc(), krealloc() or
+    kcalloc(). Does nothing if p is NULL.
+
+    @param    p    The block.
+*/
+void kfree(void *p) {
+    uint8_t m;
+
+    if (p == NULL)
+        return;
+
+    m = kmalloc_frame[(uint32_t) p >> FRAME_SHIFT];
+    assert(m != 0);
+
+    if (m & KMALLOC_LARGE)
+        buddy_free((uint32_t) p);
+    else
+        kmem_cache_free(kmalloc_caches[m - 1], p);
+}
+
+/*!
+    @function    ksize
+
+    @discussion Returns the usable size of a block, the size of its size
+    class or its pages.
+
+    @param    p    The block.
+
+    @result The size in bytes.
+*/
+size_t ksize(const void *p) {
+    uint8_t m = kmalloc_frame[(uint32_t) p >> FRAME_SHIFT];
+
+    assert(m != 0);
+
+    if (m & KMALLOC_LARGE)
+        return FRAME_SIZE << (m & ~KMALLOC_LARGE);
+    return KMALLOC_MIN_SIZE << (m - 1);
+}
+
+/*!
+    @function    krealloc
+
+    @discussion Resizes a block. The block stays in place if it is large
+    enough, it is never shrunk. Otherwise the contents are copied to a new
+    block and the old block is freed.
+
+    @param    p       The block, NULL for kmalloc(size).
+    @param    size    The new size in bytes, 0 for kfree(p).
+
+    @result The resized block, NULL if size is 0 or out of memory, in which
+    case the old block is left untouched.
+*/
+void *krealloc(void *p, size_t size) {
+    size_t old;
+    void *q;
+
+    if (p == NULL)
+        return kmalloc(size);
+    if (size == 0) {
+        kfree(p);
+        return NULL;
+    }
+
+    old = ksize(p);
+    if (size <= old)
+        return p;
+
+    q = kmalloc(size);
+    if (q == NULL)
+        return NULL;
+    memcpy(q, p, old);
+    kfree(p);
+
+    return q;
+}
+
+/*!
+    @function    kcalloc
+
+    @discussion Allocates an array of n elements of size bytes, zeroed.
+
+    @param    n       The number of elements.
+    @param    size    The element size in bytes.
+
+    @result The array, NULL if the size overflows or out of memory.
+*/
+void *kcalloc(size_t n, size_t size) {
+    void *p;
+
+    if (size != 0 && n > UINT32_MAX / size)
+        return NULL;
+
+    p = kmalloc(n * size);
+    if (p)
+        memset(p, 0, n * size);
+
+    return p;
+}
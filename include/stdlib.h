@@ -1,7 +1,42 @@
 #ifndef __STDLIB_H__
 #define __STDLIB_H__
 
+#include "stddef.h" // size_t
+
+/*!
+    @defined    KMALLOC_MIN_SIZE
+
+    @discussion The smallest size class of kmalloc().
+*/
+#define KMALLOC_MIN_SIZE (16)
+
+/*!
+    @defined    KMALLOC_MAX_SIZE
+
+    @discussion The largest size class of kmalloc(). Larger allocations take
+    whole pages from the buddy allocator.
+*/
+#define KMALLOC_MAX_SIZE (2048)
+
 /*! See .c */
 int atoi(const char *str);
 
-#endif
\ No newline at end of file
+/*! See .c */
+void kmalloc_init(void);
+
+/*! See .c */
+void *kmalloc(size_t size);
+
+/*! See .c */
+void kfree(void *p);
+
+/*! See .c */
+void *krealloc(void *p, size_t size);
+
+/*! See .c */
+void *kcalloc(size_t n, size_t size);
+
+/*! See .c */
+size_t ksize(const void *p);
+
+#endif
@@ -1,6 +1,7 @@
 #include "string.h"
 #include "assert.h"
 #include "stdio.h"
+#include "stdint.h"
 
 /*!
     @header Standard C Header
@@ -18,13 +19,59 @@ DESCRIPTION
 RETURN VALUES
      The memcpy() function returns the original value of dst.
 
+IMPLEMENTATION
+     Copies n / 4 dwords with `rep movsd`, then the n % 4 remaining bytes with
+     `rep movsb`. @doc [MOVS](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
 
+*/
+void *memcpy(void *restrict dst, const void *restrict src, size_t n) {
+    uint32_t ecx, edi, esi;
+
+    __asm__ volatile("rep movsl\n\t"
+                     "movl %4, %%ecx\n\t"
+                     "rep movsb"
+                     : "=&c" (ecx), "=&D" (edi), "=&S" (esi)
+                     : "0" (n >> 2), "g" (n & 3), "1" (dst), "2" (src)
+                     : "memory");
+
+    return dst;
+}
+
+
+/*!
+    @function    memmove
+
+memmove -- copy byte string
+DESCRIPTION
+     The memmove() function copies len bytes from string src to string dst.
+     The two strings may overlap; the copy is always done in a non-destructive
+     manner.
+
+RETURN VALUES
+     The memmove() function returns the original value of dst.
+
+IMPLEMENTATION
+     A forward copy, memcpy(), unless dst overlaps the end of src. Then a
+     backward `rep movsb` with the direction flag set.
 
 */
-// void *memcpy(void *restrict dst, const void *restrict src, size_t n) {
-//     return NULL;
-// }
+void *memmove(void *dst, const void *src, size_t len) {
+    uint32_t ecx, edi, esi;
 
+    if ((uint8_t *) dst <= (const uint8_t *) src ||
+        (uint8_t *) dst >= (const uint8_t *) src + len)
+        return memcpy(dst, src, len);
+
+    __asm__ volatile("std\n\t"
+                     "rep movsb\n\t"
+                     "cld"
+                     : "=&c" (ecx), "=&D" (edi), "=&S" (esi)
+                     : "0" (len), "1" ((uint8_t *) dst + len - 1),
+                       "2" ((const uint8_t *) src + len - 1)
+                     : "memory");
+
+    return dst;
+}
 
 /*!
     @function    memset
@@ -36,10 +83,24 @@ DESCRIPTION
 RETURN VALUES
      The memset() function returns its first argument.
 
+IMPLEMENTATION
+     Stores len / 4 dwords with `rep stosd`, then the len % 4 remaining bytes
+     with `rep stosb`.
+
 */
-// void *memset(void *b, int c, size_t len) {
-//     return NULL;
-// }
+void *memset(void *b, int c, size_t len) {
+    uint32_t ecx, edi;
+
+    __asm__ volatile("rep stosl\n\t"
+                     "movl %3, %%ecx\n\t"
+                     "rep stosb"
+                     : "=&c" (ecx), "=&D" (edi)
+                     : "0" (len >> 2), "g" (len & 3), "1" (b),
+                       "a" ((uint8_t) c * 0x01010101U)
+                     : "memory");
+
+    return b;
+}
 
 /*!
     @function    strcmp
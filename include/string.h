@@ -6,6 +6,9 @@
 /*! See .c */
 void *memcpy(void *restrict dst, const void *restrict src, size_t n);
 
+/*! See .c */
+void *memmove(void *dst, const void *src, size_t len);
+
 /*! See .c */
 void *memset(void *b, int c, size_t len);
 
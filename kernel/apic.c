@@ -0,0 +1,304 @@
+/*!
+    @header Local APIC and I/O APIC.
+    Replaces the 8259A PICs as the interrupt controller. The I/O APIC routes
+    the ISA IRQ lines to the local APIC of the bootstrap processor, which
+    delivers them to the CPU.
+
+    @discussion The 8259A's EOI is one or two port writes, each an uncached
+    bus cycle to a legacy device. The local APIC's EOI is a single write to
+    its memory mapped EOI register. Both APICs' registers are mapped
+    uncacheable with ioremap().
+
+    An IRQ line keeps its vector, IRQ_VN(irq), hence the handlers installed by
+    request_irq() work with either controller. The ISA IRQ lines are wired to
+    the I/O APIC's inputs (global system interrupts, GSIs) one to one, except
+    IRQ0, the PIT, which is wired to GSI2. That is the interrupt source
+    override ACPI's MADT reports on nearly every PC and on QEMU, the MADT
+    isn't parsed. ISA interrupts are edge triggered, active high.
+
+    apic_init() switches the controllers with interrupts disabled: the lines
+    unmasked at the PICs are unmasked at the I/O APIC, then every line of the
+    PICs is masked. The local APIC's LINT0, where the PICs' output is wired in
+    virtual wire mode, is masked too.
+
+    @doc [82093AA I/O Advanced Programmable Interrupt Controller (IOAPIC)]
+         (./docs/interrupts/intel-82093-apic.pdf)
+    @doc [Advanced Programmable Interrupt Controller (APIC)]
+         (Intel 64 & IA-32 Arch. SDM Vol.3 Ch.10)
+*/
+
+#include "../include/assert.h"
+#include "../include/mylibc.h"
+#include "../include/stddef.h"
+#include "i8259a_pic.h"
+#include "ioremap.h"
+#include "klog.h"
+#include "low_level.h"
+#include "paging.h"
+#include "apic.h"
+
+/*!
+    @defined    CPUID_EDX_MSR, CPUID_EDX_APIC
+
+    @discussion CPUID.01H:EDX bits: RDMSR/WRMSR and an on-chip local APIC.
+*/
+#define CPUID_EDX_MSR (BIT5)
+#define CPUID_EDX_APIC (BITN(9))
+
+/*!
+    @defined    APIC_BASE_ENABLE, APIC_BASE_ADDR_MASK
+
+    @discussion IA32_APIC_BASE fields: the global enable and the base address.
+*/
+#define APIC_BASE_ENABLE (BITN(11))
+#define APIC_BASE_ADDR_MASK (0xFFFFF000U)
+
+/*!
+    @defined    LAPIC_ID . . . LAPIC_LVT_LINT1
+
+    @discussion Local APIC register offsets.
+    @doc [Table 10-1 Local APIC Register Address Map]
+         (Intel 64 & IA-32 Arch. SDM Vol.3 Ch.10.4.1)
+*/
+#define LAPIC_ID (0x020)
+#define LAPIC_TPR (0x080)       // Task Priority Register.
+#define LAPIC_EOI (0x0B0)
+#define LAPIC_SVR (0x0F0)       // Spurious Interrupt Vector Register.
+#define LAPIC_LVT_LINT0 (0x350)
+#define LAPIC_LVT_LINT1 (0x360)
+
+/*!
+    @defined    LAPIC_SVR_ENABLE, LVT_MASKED, LVT_NMI
+
+    @discussion The APIC software enable bit of the SVR; the mask bit and
+    the NMI delivery mode of the local vector table entries.
+*/
+#define LAPIC_SVR_ENABLE (BITN(8))
+#define LVT_MASKED (BITN(16))
+#define LVT_NMI (4U << 8)
+
+/*!
+    @defined    IOREGSEL, IOWIN
+
+    @discussion The I/O APIC's register select and data window. A register
+    is accessed by writing its index to IOREGSEL, then accessing IOWIN.
+*/
+#define IOREGSEL (0x00)
+#define IOWIN (0x10)
+
+/*!
+    @defined    IOAPIC_VER, IOAPIC_REDTBL(n)
+
+    @discussion I/O APIC register indices: the version, bits 23:16 are the
+    index of the last redirection entry, and the low dword of redirection
+    entry n, the high dword follows.
+*/
+#define IOAPIC_VER (0x01)
+#define IOAPIC_REDTBL(n) (0x10 + 2 * (n))
+
+/*!
+    @defined    REDTBL_MASKED
+
+    @discussion Redirection entry mask bit. Delivery mode fixed, physical
+    destination, active high and edge triggered are all 0.
+*/
+#define REDTBL_MASKED (BITN(16))
+
+/*!
+    @const    isa_gsi
+
+    @discussion The GSI of each ISA IRQ line, see the header.
+*/
+static const uint8_t isa_gsi[IRQ_LINES] = {
+    2, 1, 0, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+/*!
+    @var    lapic, ioapic
+
+    @discussion The mapped registers of the local APIC and the I/O APIC.
+*/
+static volatile uint32_t *lapic;
+static volatile uint32_t *ioapic;
+
+/*!
+    @var    lapic_id
+
+    @discussion The local APIC ID of the CPU, the destination of the
+    redirection entries.
+*/
+static uint32_t lapic_id;
+
+/*!
+    @var    spurious_count
+
+    @discussion The number of spurious interrupts, see spurious_handler().
+*/
+static volatile uint32_t spurious_count;
+
+static inline __attribute__((always_inline))
+uint32_t lapic_read(uint32_t reg) {
+    return lapic[reg / 4];
+}
+
+static inline __attribute__((always_inline))
+void lapic_write(uint32_t reg, uint32_t value) {
+    lapic[reg / 4] = value;
+}
+
+static uint32_t ioapic_read(uint32_t reg) {
+    ioapic[IOREGSEL / 4] = reg;
+    return ioapic[IOWIN / 4];
+}
+
+static void ioapic_write(uint32_t reg, uint32_t value) {
+    ioapic[IOREGSEL / 4] = reg;
+    ioapic[IOWIN / 4] = value;
+}
+
+/*!
+    @function    lapic_eoi
+
+    @discussion The EOI of the APIC controller: a single write to the EOI
+    register. The I/O APIC needs no EOI for edge triggered interrupts.
+*/
+static void lapic_eoi(uint32_t vn) {
+    if (vn) { // Suppress warning.
+        ;
+    }
+    lapic_write(LAPIC_EOI, 0);
+}
+
+/*!
+    @function    ioapic_mask
+
+    @discussion Masks the redirection entry of IRQ line irq.
+*/
+static void ioapic_mask(uint32_t irq) {
+    uint32_t flags;
+
+    assert(irq < IRQ_LINES);
+    flags = irq_save();
+    ioapic_write(IOAPIC_REDTBL(isa_gsi[irq]), REDTBL_MASKED | IRQ_VN(irq));
+    irq_restore(flags);
+}
+
+/*!
+    @function    ioapic_unmask
+
+    @discussion Routes IRQ line irq to vector IRQ_VN(irq) of this CPU.
+*/
+static void ioapic_unmask(uint32_t irq) {
+    uint32_t flags;
+
+    assert(irq < IRQ_LINES);
+    flags = irq_save();
+    ioapic_write(IOAPIC_REDTBL(isa_gsi[irq]) + 1, lapic_id << 24);
+    ioapic_write(IOAPIC_REDTBL(isa_gsi[irq]), IRQ_VN(irq));
+    irq_restore(flags);
+}
+
+/*!
+    @const    apic_ctlr
+
+    @discussion The APICs as the interrupt controller, see intr_ctlr.
+*/
+const intr_ctlr_t apic_ctlr = {
+    "APIC", lapic_eoi, ioapic_mask, ioapic_unmask
+};
+
+/*!
+    @function    spurious_handler
+
+    @discussion Handler of the local APIC's spurious vector. A spurious
+    interrupt gets no EOI.
+*/
+static void spurious_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    if (vn || err_code || ctx) { // Suppress warning.
+        ;
+    }
+    spurious_count++;
+}
+
+/*!
+    @function    apic_present
+
+    @result Non-zero if the CPU has a local APIC and MSRs, see CPUID.01H:EDX.
+*/
+uint32_t apic_present(void) {
+    cpuid_regs_t r;
+
+    cpuid(1, &r);
+    return (r.edx & (CPUID_EDX_MSR | CPUID_EDX_APIC)) ==
+           (CPUID_EDX_MSR | CPUID_EDX_APIC);
+}
+
+/*!
+    @function    apic_init
+
+    @discussion Enables the local APIC, maps both APICs and makes them the
+    interrupt controller, see the header. Call after paging_init() and
+    init_interrupts().
+
+    @result 0, -1 if there is no local APIC or it can't be mapped. The PICs
+    stay the interrupt controller then.
+*/
+int apic_init(void) {
+    uint32_t base, flags, mask, entries, i;
+
+    if (!apic_present()) {
+        klog(KLOG_WARN, "apic: no local APIC, using the 8259A");
+        return -1;
+    }
+
+    base = (uint32_t) rdmsr(MSR_IA32_APIC_BASE);
+    if (!(base & APIC_BASE_ENABLE))
+        wrmsr(MSR_IA32_APIC_BASE, base | APIC_BASE_ENABLE);
+
+    lapic = ioremap(base & APIC_BASE_ADDR_MASK, PAGE_SIZE);
+    ioapic = ioremap(IOAPIC_PHYS, PAGE_SIZE);
+    if (lapic == NULL || ioapic == NULL) {
+        klog(KLOG_ERR, "apic: can't map the registers");
+        return -1;
+    }
+    lapic_id = lapic_read(LAPIC_ID) >> 24;
+    entries = ((ioapic_read(IOAPIC_VER) >> 16) & 0xFF) + 1;
+    assert(entries >= IRQ_LINES);
+
+    if (intr_register(APIC_SPURIOUS_VN, spurious_handler, NULL))
+        return -1;
+
+    flags = irq_save();
+
+    for (i = 0; i < entries; i++)
+        ioapic_write(IOAPIC_REDTBL(i), REDTBL_MASKED);
+
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_LINT0, LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, LVT_NMI);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | APIC_SPURIOUS_VN);
+
+    mask = pic_get_mask();
+    for (i = 0; i < IRQ_LINES; i++) {
+        if (i != 2 && !(mask & BITN(i))) // Not the cascade line.
+            ioapic_unmask(i);
+    }
+    pic_disable();
+    intr_ctlr = &apic_ctlr;
+
+    irq_restore(flags);
+
+    klog(KLOG_INFO, "apic: local APIC %u at %08x, I/O APIC %u entries",
+         lapic_id, base & APIC_BASE_ADDR_MASK, entries);
+
+    return 0;
+}
+
+/*!
+    @function    apic_spurious_count
+
+    @result The number of spurious interrupts of the local APIC.
+*/
+uint32_t apic_spurious_count(void) {
+    return spurious_count;
+}
@@ -0,0 +1,44 @@
+#ifndef __APIC_H__
+#define __APIC_H__
+
+#include "../include/stdint.h"
+#include "idt.h"
+
+/*!
+    @defined    MSR_IA32_APIC_BASE
+
+    @discussion The local APIC base address MSR: the physical base address of
+    the registers, bits 31:12, the global enable, bit 11, and the BSP flag,
+    bit 8.
+*/
+#define MSR_IA32_APIC_BASE (0x1B)
+
+/*!
+    @defined    IOAPIC_PHYS
+
+    @discussion The physical address of the I/O APIC's registers, the default
+    of the MP specification and of QEMU. ACPI's MADT may place it elsewhere.
+*/
+#define IOAPIC_PHYS (0xFEC00000)
+
+/*!
+    @defined    APIC_SPURIOUS_VN
+
+    @discussion The vector of the local APIC's spurious interrupts. Its low 4
+    bits must be set on P6 and Pentium processors.
+*/
+#define APIC_SPURIOUS_VN (0xFF)
+
+/*! See .c */
+extern const intr_ctlr_t apic_ctlr;
+
+/*! See .c */
+uint32_t apic_present(void);
+
+/*! See .c */
+int apic_init(void);
+
+/*! See .c */
+uint32_t apic_spurious_count(void);
+
+#endif
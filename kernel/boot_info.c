@@ -0,0 +1,125 @@
+/*!
+    @header Boot info.
+    The boot info structure is filled in by boot/stage2.s and passed to main().
+    It holds what only the BIOS can tell the kernel, such as the amount and
+    location of usable RAM, see the BIOS memory map (E820).
+*/
+
+#include "../drivers/screen.h"
+#include "../include/stdio.h"
+#include "boot_info.h"
+
+/*!
+    @function    e820_entry_usable
+
+    @discussion Returns true if the memory map entry describes usable RAM: of
+    type E820_USABLE and valid, bit 0 of the ACPI 3.0 extended attributes.
+
+    @param    e    The memory map entry.
+
+    @result 1 if usable, 0 otherwise.
+*/
+int e820_entry_usable(const e820_entry_t *e) {
+    return e->type == E820_USABLE && (e->acpi & 1) != 0;
+}
+
+/*!
+    @function    boot_info_usable_size
+
+    @discussion Returns the total size of the usable RAM in the memory map.
+    Overlapping entries are counted twice, the BIOSes we use don't return any.
+
+    @param    bi    The boot info.
+
+    @result The size of the usable RAM, in bytes.
+*/
+uint64_t boot_info_usable_size(const boot_info_t *bi) {
+    uint64_t size = 0;
+    uint32_t i;
+
+    for (i = 0; i < bi->mmap_len; i++) {
+        if (e820_entry_usable(&bi->mmap[i]))
+            size += bi->mmap[i].length;
+    }
+
+    return size;
+}
+
+/*!
+    @function    boot_info_usable_end
+
+    @discussion Returns the address one past the end of the highest usable RAM
+    in the memory map.
+
+    @param    bi    The boot info.
+
+    @result The end of the usable RAM. 0 if there is none.
+*/
+uint64_t boot_info_usable_end(const boot_info_t *bi) {
+    uint64_t end = 0;
+    uint32_t i;
+
+    for (i = 0; i < bi->mmap_len; i++) {
+        if (e820_entry_usable(&bi->mmap[i]) &&
+            bi->mmap[i].base + bi->mmap[i].length > end)
+            end = bi->mmap[i].base + bi->mmap[i].length;
+    }
+
+    return end;
+}
+
+/*!
+    @function    boot_info_print
+
+    @discussion Prints the boot drive, the memory map and the modules.
+
+    @param    bi    The boot info.
+*/
+void boot_info_print(const boot_info_t *bi) {
+    char s[STDIO_STR_SIZE_MAX];
+    uint32_t i;
+
+    if (bi->boot_drive == BOOT_INFO_DRIVE_NONE) {
+        print("Boot drive none");
+    } else {
+        print("Boot drive 0x");
+        _xtoa(bi->boot_drive, 8, s, 0);
+        print(s);
+    }
+    print(", memory map:\n");
+
+    if (bi->mmap_len == 0)
+        print("  none, E820 is not supported.\n");
+
+    for (i = 0; i < bi->mmap_len; i++) {
+        print("  0x");
+        _xtoa(bi->mmap[i].base, 64, s, 0);
+        print(s);
+        print(" - 0x");
+        _xtoa(bi->mmap[i].base + bi->mmap[i].length - 1, 64, s, 0);
+        print(s);
+        print(" type ");
+        _utoa(bi->mmap[i].type, s);
+        print(s);
+        print("\n");
+    }
+
+    print("Usable RAM: ");
+    _utoa(boot_info_usable_size(bi) >> 10, s);
+    print(s);
+    print(" KiB\n");
+
+    for (i = 0; i < bi->mods_len; i++) {
+        print("Module 0x");
+        _xtoa(bi->mods[i].start, 32, s, 0);
+        print(s);
+        print(" - 0x");
+        _xtoa(bi->mods[i].end, 32, s, 0);
+        print(s);
+        if (bi->mods[i].cmdline) {
+            print(" ");
+            print((const char *) bi->mods[i].cmdline);
+        }
+        print("\n");
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef __BOOT_INFO_H__
+#define __BOOT_INFO_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    BOOT_INFO_MAGIC
+
+    @discussion The value of EAX at the kernel's entry point when the kernel is
+    loaded by boot/stage2.s, in which case EBX is the address of a boot_info_t.
+    Must match boot/boot_info.s.
+*/
+#define BOOT_INFO_MAGIC (0x464E4942)
+
+/*!
+    @defined    BOOT_INFO_MMAP_MAX
+
+    @discussion The maximum number of memory map entries. Must match
+    boot/boot_info.s.
+*/
+#define BOOT_INFO_MMAP_MAX (32)
+
+/*!
+    @defined    BOOT_INFO_MODS_MAX
+
+    @discussion The maximum number of boot modules.
+*/
+#define BOOT_INFO_MODS_MAX (8)
+
+/*!
+    @defined    BOOT_INFO_DRIVE_NONE
+
+    @discussion The boot_drive value when the boot loader did not report a
+    BIOS boot drive, e.g. `qemu -kernel`.
+*/
+#define BOOT_INFO_DRIVE_NONE (0xFFFFFFFF)
+
+/*!
+    @typedef    e820_type_t
+
+    @discussion Address range types of the BIOS memory map, int 0x15
+    EAX = 0xE820. See ACPI Spec. 6.4, Table 15.312.
+
+    @constant   E820_USABLE      RAM available to the OS.
+    @constant   E820_RESERVED    In use or reserved by the system.
+    @constant   E820_ACPI        ACPI tables, reclaimable after they are read.
+    @constant   E820_NVS         ACPI non-volatile storage.
+    @constant   E820_UNUSABLE    Memory with errors.
+*/
+typedef
+enum _e820_type_t {
+    E820_USABLE = 1,
+    E820_RESERVED,
+    E820_ACPI,
+    E820_NVS,
+    E820_UNUSABLE
+} e820_type_t;
+
+/*!
+    @typedef    e820_entry_t
+
+    @discussion A BIOS memory map entry, in the 24 byte format returned by int
+    0x15 EAX = 0xE820.
+*/
+typedef struct _e820_entry_t {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;   // e820_type_t.
+    uint32_t acpi;   // ACPI 3.0 extended attributes. Bit 0 = 1, entry valid.
+} __attribute__((packed)) e820_entry_t;
+
+/*!
+    @typedef    boot_module_t
+
+    @discussion A module loaded into memory by the boot loader, e.g. with
+    `qemu -kernel kernel.elf -initrd file`.
+
+    @field    start      The address of the first byte of the module.
+    @field    end        The address one past the last byte of the module.
+    @field    cmdline    The address of the module's NUL terminated command
+                         line, 0 if none.
+*/
+typedef struct _boot_module_t {
+    uint32_t start;
+    uint32_t end;
+    uint32_t cmdline;
+} __attribute__((packed)) boot_module_t;
+
+/*!
+    @typedef    boot_info_t
+
+    @discussion What the boot loader tells the kernel about the machine. Must
+    match boot/boot_info.s. Filled in by boot/stage2.s, or converted from the
+    Multiboot information, see multiboot.c.
+
+    @field    boot_drive    The BIOS drive number the machine booted from.
+    @field    mmap_len      The number of valid entries in mmap. 0 if the BIOS
+                            does not support E820.
+    @field    mmap          The BIOS memory map, in the order returned by the
+                            BIOS. Entries may be unsorted and may overlap.
+    @field    mods_len      The number of valid entries in mods.
+    @field    mods          The boot modules. Their memory is not marked in
+                            mmap, it must not be reused while they are needed.
+*/
+typedef struct _boot_info_t {
+    uint32_t boot_drive;
+    uint32_t mmap_len;
+    e820_entry_t mmap[BOOT_INFO_MMAP_MAX];
+    uint32_t mods_len;
+    boot_module_t mods[BOOT_INFO_MODS_MAX];
+} __attribute__((packed)) boot_info_t;
+
+/*! See .c */
+int e820_entry_usable(const e820_entry_t *e);
+
+/*! See .c */
+uint64_t boot_info_usable_size(const boot_info_t *bi);
+
+/*! See .c */
+uint64_t boot_info_usable_end(const boot_info_t *bi);
+
+/*! See .c */
+void boot_info_print(const boot_info_t *bi);
+
+#endif
@@ -0,0 +1,128 @@
+/*!
+    @header Boot timeline.
+    Every boot stage, from the boot sector to the kernel's initialization,
+    records the time stamp counter (TSC) in its slot of the boot timeline. The
+    boot sector, stage2 and kernel_entry.s use the BOOT_TSC macro in
+    boot/boot_timeline.s, the kernel uses boot_timeline_stamp().
+
+    @discussion The timeline is printed on the screen, and on the debug port
+    where a host script can read it, see testboottimeline.sh. Each line written
+    to the debug port has the format "boot_timeline <stage name> <TSC>\n".
+*/
+
+#include "../drivers/screen.h"
+#include "../include/stdio.h"
+#include "boot_timeline.h"
+#include "low_level.h"
+
+/*!
+    @defined    DEBUG_PORT
+
+    @discussion Characters written to this I/O port are printed by the
+    emulator. QEMU: `-debugcon stdio`. Bochs: `port_e9_hack: enabled=1`.
+*/
+#define DEBUG_PORT (0xE9)
+
+/*!
+    @const    boot_stage_names
+    @discussion The name of each boot timeline slot.
+*/
+static const char *boot_stage_names[BT_LEN] = {
+    "boot_sect",
+    "print",
+    "stage2_load",
+    "disk_load",
+    "switch_to_pm",
+    "elf_load",
+    "kernel_entry",
+    "main",
+    "init_interrupts"
+};
+
+/*!
+    @function    boot_timeline_stamp
+
+    @discussion Records the current TSC value in the given boot timeline slot.
+
+    @param    s    The boot timeline slot.
+*/
+void boot_timeline_stamp(boot_stage_t s) {
+    uint64_t *boot_timeline = (uint64_t *) BOOT_TIMELINE_ADDR;
+
+    boot_timeline[s] = read_tsc();
+}
+
+/*!
+    @function    boot_timeline_clear
+
+    @discussion Clears the boot timeline slots before the given one. Used when
+    the earlier boot stages did not run, e.g. when the kernel is booted by a
+    Multiboot boot loader. Cleared slots are not printed.
+
+    @param    s    The first slot to keep.
+*/
+void boot_timeline_clear(boot_stage_t s) {
+    uint64_t *boot_timeline = (uint64_t *) BOOT_TIMELINE_ADDR;
+    int i;
+
+    for (i = 0; i < (int) s; i++)
+        boot_timeline[i] = 0;
+}
+
+/*!
+    @function    debug_port_print
+
+    @discussion Writes a string to the debug port.
+
+    @param    s    The string to write.
+*/
+static void debug_port_print(const char *s) {
+    while (*s != '\0') {
+        outb(DEBUG_PORT, *s);
+        s++;
+    }
+}
+
+/*!
+    @function    boot_timeline_print
+
+    @discussion Prints the boot timeline. On the screen, each stage is printed
+    with the cycles elapsed since the first recorded stage (the boot sector,
+    unless cleared) and the cycles spent in the stage. On the debug port, the
+    raw TSC values are written. Cleared slots are skipped.
+*/
+void boot_timeline_print(void) {
+    uint64_t *boot_timeline = (uint64_t *) BOOT_TIMELINE_ADDR;
+    char s[STDIO_STR_SIZE_MAX];
+    int first, i, n;
+
+    for (first = 0; first < BT_LEN - 1 && boot_timeline[first] == 0; first++)
+        ;
+
+    print("Boot timeline (TSC cycles): since ");
+    print(boot_stage_names[first]);
+    print(", in stage\n");
+
+    for (i = first; i < BT_LEN; i++) {
+        print(boot_stage_names[i]);
+
+        for (n = 0; boot_stage_names[i][n] != '\0'; n++)
+            ;
+        for (; n < 16; n++)
+            print(" ");
+
+        _utoa(boot_timeline[i] - boot_timeline[first], s);
+        print(s);
+        print(", ");
+        _utoa(i > first ? boot_timeline[i] - boot_timeline[i - 1] : 0, s);
+        print(s);
+        print("\n");
+
+        debug_port_print("boot_timeline ");
+        debug_port_print(boot_stage_names[i]);
+        debug_port_print(" ");
+        _utoa(boot_timeline[i], s);
+        debug_port_print(s);
+        debug_port_print("\n");
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef __BOOT_TIMELINE_H__
+#define __BOOT_TIMELINE_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    BOOT_TIMELINE_ADDR
+
+    @discussion Address of the boot timeline, an array of BT_LEN 64-bit time
+    stamp counter (TSC) values. Must match boot/boot_timeline.s.
+*/
+#define BOOT_TIMELINE_ADDR (0x0500)
+
+/*!
+    @typedef    boot_stage_t
+
+    @discussion Boot timeline slot indices. Each slot holds the TSC value
+    recorded when the boot reaches that point. Must match
+    boot/boot_timeline.s.
+
+    @constant   BT_BOOT_SECT          The boot sector is entered.
+    @constant   BT_PRINT              The real-mode print is done.
+    @constant   BT_STAGE2_LOAD        stage2 is loaded from disk.
+    @constant   BT_DISK_LOAD          The kernel image is loaded from disk.
+    @constant   BT_SWITCH_TO_PM       switch_to_pm/init_pm are done, BEGIN_PM.
+    @constant   BT_ELF_LOAD           The kernel's ELF segments are in place.
+    @constant   BT_KERNEL_ENTRY       kernel_entry.s is entered.
+    @constant   BT_MAIN               main() is entered.
+    @constant   BT_INIT_INTERRUPTS    init_interrupts() is done.
+    @constant   BT_LEN                The number of slots.
+*/
+typedef
+enum _boot_stage_t {
+    BT_BOOT_SECT = 0,
+    BT_PRINT,
+    BT_STAGE2_LOAD,
+    BT_DISK_LOAD,
+    BT_SWITCH_TO_PM,
+    BT_ELF_LOAD,
+    BT_KERNEL_ENTRY,
+    BT_MAIN,
+    BT_INIT_INTERRUPTS,
+    BT_LEN
+} boot_stage_t;
+
+/*! See .c */
+void boot_timeline_stamp(boot_stage_t s);
+
+/*! See .c */
+void boot_timeline_clear(boot_stage_t s);
+
+/*! See .c */
+void boot_timeline_print(void);
+
+#endif
@@ -0,0 +1,371 @@
+/*!
+    @header Binary buddy allocator.
+    Allocates physically contiguous blocks of 2^order frames, 0 <= order <=
+    BUDDY_MAX_ORDER, e.g. for DMA buffers and kernel stacks. The kernel's zone,
+    the buddy arena, is carved out of the frame allocator by buddy_init(), up
+    to a cap. The frame allocator keeps the rest of the memory.
+
+    @discussion A block of order k at frame index i (relative to the zone's
+    base) is aligned to 2^k frames. Its buddy is the block of order k at
+    i XOR 2^k, together they form the block of order k + 1 at min(i, buddy).
+
+    An allocation of order k takes the first block of the smallest non-empty
+    free list of order >= k, and splits it in halves down to order k. The upper
+    halves go to the free lists. A free merges the block with its buddy as long
+    as the buddy is a free block of the same order. Both take O(log n) steps,
+    at most BUDDY_MAX_ORDER splits or merges.
+
+    The metadata is out of line: a byte per frame for the order and free flag
+    of a block, and the free lists are doubly linked through an array of links
+    indexed by frame. Allocated memory is never touched by the allocator.
+
+    @doc [The Art of Computer Programming, Vol.1, Ch.2.5, Knuth]
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "frame_alloc.h"
+#include "buddy.h"
+
+/*!
+    @defined    BUDDY_FREE
+
+    @discussion Set in buddy_zone_t.order for the first frame of a free block.
+*/
+#define BUDDY_FREE (0x80)
+
+/*!
+    @defined    BUDDY_ORDER_MASK
+
+    @discussion The order bits of buddy_zone_t.order.
+*/
+#define BUDDY_ORDER_MASK (0x1F)
+
+/*!
+    @var    kernel_zone
+
+    @discussion The kernel's buddy zone, see buddy_init().
+*/
+static buddy_zone_t kernel_zone;
+
+/*!
+    @function    free_list_push
+
+    @discussion Marks block i of order k free and adds it to the free list of
+    order k.
+*/
+static void free_list_push(buddy_zone_t *z, uint32_t i, uint32_t k) {
+    uint32_t head = z->free_head[k];
+
+    z->order[i] = BUDDY_FREE | k;
+    z->link[i].prev = BUDDY_NONE;
+    z->link[i].next = head;
+    if (head != BUDDY_NONE)
+        z->link[head].prev = i;
+    z->free_head[k] = i;
+
+    z->free_blocks[k]++;
+    z->free_frames += 1U << k;
+}
+
+/*!
+    @function    free_list_remove
+
+    @discussion Removes the free block i of order k from the free list of
+    order k, and clears its free flag.
+*/
+static void free_list_remove(buddy_zone_t *z, uint32_t i, uint32_t k) {
+    uint32_t next = z->link[i].next;
+    uint32_t prev = z->link[i].prev;
+
+    if (prev != BUDDY_NONE)
+        z->link[prev].next = next;
+    else
+        z->free_head[k] = next;
+    if (next != BUDDY_NONE)
+        z->link[next].prev = prev;
+
+    z->order[i] = k;
+    z->free_blocks[k]--;
+    z->free_frames -= 1U << k;
+}
+
+/*!
+    @function    buddy_zone_meta_size
+
+    @discussion Returns the size of the metadata of a zone of nframes frames.
+
+    @param    nframes    The number of frames.
+
+    @result The metadata size in bytes.
+*/
+uint32_t buddy_zone_meta_size(uint32_t nframes) {
+    return nframes * (sizeof(buddy_link_t) + sizeof(uint8_t));
+}
+
+/*!
+    @function    buddy_zone_init
+
+    @discussion Initializes a zone. All frames are free, as blocks of the
+    largest order.
+
+    @param    z          The zone.
+    @param    base       The physical address of the first frame, aligned to
+                         2^BUDDY_MAX_ORDER frames.
+    @param    nframes    The number of frames, a multiple of
+                         2^BUDDY_MAX_ORDER.
+    @param    meta       The metadata, buddy_zone_meta_size(nframes) bytes.
+*/
+void buddy_zone_init(buddy_zone_t *z, uint32_t base, uint32_t nframes,
+                     void *meta) {
+    uint32_t i;
+
+    assert((base & ((FRAME_SIZE << BUDDY_MAX_ORDER) - 1)) == 0);
+    assert((nframes & ((1U << BUDDY_MAX_ORDER) - 1)) == 0);
+
+    z->base = base;
+    z->nframes = nframes;
+    z->link = (buddy_link_t *) meta;
+    z->order = (uint8_t *) meta + nframes * sizeof(buddy_link_t);
+    z->free_frames = 0;
+
+    for (i = 0; i < BUDDY_ORDERS; i++) {
+        z->free_head[i] = BUDDY_NONE;
+        z->free_blocks[i] = 0;
+    }
+
+    // Push in reverse so the lowest block is allocated first.
+    for (i = nframes; i > 0; i -= 1U << BUDDY_MAX_ORDER)
+        free_list_push(z, i - (1U << BUDDY_MAX_ORDER), BUDDY_MAX_ORDER);
+}
+
+/*!
+    @function    buddy_zone_alloc
+
+    @discussion Allocates a block of 2^order frames.
+
+    @param    z        The zone.
+    @param    order    The block order, 0 to BUDDY_MAX_ORDER.
+
+    @result The physical address of the block, BUDDY_NONE if there is no free
+    block large enough.
+*/
+uint32_t buddy_zone_alloc(buddy_zone_t *z, uint32_t order) {
+    uint32_t i, k;
+
+    if (order > BUDDY_MAX_ORDER)
+        return BUDDY_NONE;
+
+    for (k = order; k <= BUDDY_MAX_ORDER; k++) {
+        if (z->free_head[k] != BUDDY_NONE)
+            break;
+    }
+    if (k > BUDDY_MAX_ORDER)
+        return BUDDY_NONE;
+
+    i = z->free_head[k];
+    free_list_remove(z, i, k);
+
+    while (k > order) {     // Split, the upper half goes back.
+        k--;
+        free_list_push(z, i + (1U << k), k);
+    }
+
+    z->order[i] = order;
+
+    return z->base + (i << FRAME_SHIFT);
+}
+
+/*!
+    @function    buddy_zone_free
+
+    @discussion Frees a block allocated with buddy_zone_alloc(), and merges it
+    with its free buddies. Freeing a free block is a fatal error.
+
+    @param    z       The zone.
+    @param    addr    The physical address of the block.
+*/
+void buddy_zone_free(buddy_zone_t *z, uint32_t addr) {
+    uint32_t i, k, buddy;
+
+    assert(addr >= z->base && ((addr - z->base) >> FRAME_SHIFT) < z->nframes);
+
+    i = (addr - z->base) >> FRAME_SHIFT;
+    assert((z->order[i] & BUDDY_FREE) == 0);
+    k = z->order[i] & BUDDY_ORDER_MASK;
+
+    while (k < BUDDY_MAX_ORDER) {
+        buddy = i ^ (1U << k);
+        if (z->order[buddy] != (BUDDY_FREE | k))
+            break;
+        free_list_remove(z, buddy, k);
+        i &= buddy;         // The lower of the two.
+        k++;
+    }
+
+    free_list_push(z, i, k);
+}
+
+/*!
+    @function    buddy_zone_block_order
+
+    @discussion Returns the order of an allocated block.
+
+    @param    z       The zone.
+    @param    addr    The physical address of the block.
+
+    @result The block order.
+*/
+uint32_t buddy_zone_block_order(const buddy_zone_t *z, uint32_t addr) {
+    return z->order[(addr - z->base) >> FRAME_SHIFT] & BUDDY_ORDER_MASK;
+}
+
+/*!
+    @function    buddy_zone_stats
+
+    @discussion Computes the fragmentation statistics of a zone, see
+    buddy_stats_t.
+
+    @param    z    The zone.
+    @param    s    The statistics.
+*/
+void buddy_zone_stats(const buddy_zone_t *z, buddy_stats_t *s) {
+    uint32_t k, below = 0;
+
+    s->free_frames = z->free_frames;
+    s->largest_order = BUDDY_NONE;
+
+    for (k = 0; k < BUDDY_ORDERS; k++) {
+        s->free_blocks[k] = z->free_blocks[k];
+        if (z->free_blocks[k] != 0)
+            s->largest_order = k;
+
+        // below := free frames in blocks of order < k.
+        s->frag[k] = z->free_frames ? below * 100 / z->free_frames : 0;
+        below += z->free_blocks[k] << k;
+    }
+}
+
+/*!
+    @function    buddy_init
+
+    @discussion Creates the kernel's zone, the buddy arena. The arena takes
+    max_frames, but at most half of the free frames, rounded down to a
+    multiple of the largest block, with its metadata. The arena's frames are
+    allocated from the frame allocator, hence are never handed out by it.
+    Must be called after frame_alloc_init().
+
+    @param    max_frames    The size cap of the arena, e.g.
+                            BUDDY_ARENA_FRAMES.
+*/
+void buddy_init(uint32_t max_frames) {
+    uint32_t nframes, meta_frames, base, meta;
+    uint32_t block = 1U << BUDDY_MAX_ORDER;
+
+    nframes = frame_free_count() / 2;
+    if (nframes > max_frames)
+        nframes = max_frames;
+    nframes &= ~(block - 1);
+
+    for (; nframes > 0; nframes -= block) {
+        base = frame_alloc_contig(nframes, block);
+        if (base != FRAME_NONE)
+            break;
+    }
+    if (nframes == 0) {
+        print("buddy_init: no memory for the buddy arena.\n");
+        return;
+    }
+
+    meta_frames = (buddy_zone_meta_size(nframes) + FRAME_SIZE - 1) / FRAME_SIZE;
+    meta = frame_alloc_contig(meta_frames, 1);
+    if (meta == FRAME_NONE) {
+        frame_free_contig(base, nframes);
+        print("buddy_init: no memory for the buddy arena metadata.\n");
+        return;
+    }
+
+    buddy_zone_init(&kernel_zone, base, nframes, (void *) meta);
+}
+
+/*!
+    @function    buddy_alloc
+
+    @discussion Allocates a block of 2^order frames from the buddy arena.
+
+    @param    order    The block order, 0 to BUDDY_MAX_ORDER.
+
+    @result The physical address of the block, BUDDY_NONE if out of memory.
+*/
+uint32_t buddy_alloc(uint32_t order) {
+    if (kernel_zone.nframes == 0)
+        return BUDDY_NONE;
+
+    return buddy_zone_alloc(&kernel_zone, order);
+}
+
+/*!
+    @function    buddy_free
+
+    @discussion Frees a block allocated with buddy_alloc().
+
+    @param    addr    The physical address of the block.
+*/
+void buddy_free(uint32_t addr) {
+    buddy_zone_free(&kernel_zone, addr);
+}
+
+/*!
+    @function    buddy_contains
+
+    @discussion Returns non-zero if addr is in the buddy arena.
+
+    @param    addr    A physical address.
+*/
+uint32_t buddy_contains(uint32_t addr) {
+    return addr >= kernel_zone.base &&
+           ((addr - kernel_zone.base) >> FRAME_SHIFT) < kernel_zone.nframes;
+}
+
+/*!
+    @function    buddy_stats
+
+    @discussion Computes the fragmentation statistics of the buddy arena.
+
+    @param    s    The statistics.
+*/
+void buddy_stats(buddy_stats_t *s) {
+    buddy_zone_stats(&kernel_zone, s);
+}
+
+/*!
+    @function    buddy_print_stats
+
+    @discussion Prints the fragmentation statistics of the buddy arena: the
+    number of free blocks and the fragmentation index of each order.
+*/
+void buddy_print_stats(void) {
+    buddy_stats_t s;
+    char str[STDIO_STR_SIZE_MAX];
+    uint32_t k;
+
+    buddy_stats(&s);
+
+    print("Buddy arena: ");
+    _utoa((uint64_t) s.free_frames * (FRAME_SIZE / 1024), str);
+    print(str);
+    print(" KiB free\norder free_blocks frag%\n");
+
+    for (k = 0; k < BUDDY_ORDERS; k++) {
+        _utoa(k, str);
+        print(str);
+        print(" ");
+        _utoa(s.free_blocks[k], str);
+        print(str);
+        print(" ");
+        _utoa(s.frag[k], str);
+        print(str);
+        print("\n");
+    }
+}
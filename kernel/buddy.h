@@ -0,0 +1,136 @@
+#ifndef __BUDDY_H__
+#define __BUDDY_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    BUDDY_MAX_ORDER
+
+    @discussion The largest block is 2^BUDDY_MAX_ORDER frames, 4 MiB.
+*/
+#define BUDDY_MAX_ORDER (10)
+
+/*!
+    @defined    BUDDY_ORDERS
+
+    @discussion The number of block orders, 0 to BUDDY_MAX_ORDER.
+*/
+#define BUDDY_ORDERS (BUDDY_MAX_ORDER + 1)
+
+/*!
+    @defined    BUDDY_ARENA_FRAMES
+
+    @discussion The default size of the kernel's buddy arena in frames, 8 MiB,
+    see buddy_init(). Override with `make BUDDY_ARENA_FRAMES=n`.
+*/
+#ifndef BUDDY_ARENA_FRAMES
+#define BUDDY_ARENA_FRAMES (2048)
+#endif
+
+/*!
+    @defined    BUDDY_NONE
+
+    @discussion Returned by the allocation functions when no block is available,
+    and the end of a free list.
+*/
+#define BUDDY_NONE (0xFFFFFFFF)
+
+/*!
+    @typedef    buddy_link_t
+
+    @discussion The free list links of a free block, indexed by the block's
+    first frame.
+*/
+typedef struct _buddy_link_t {
+    uint32_t next;
+    uint32_t prev;
+} buddy_link_t;
+
+/*!
+    @typedef    buddy_zone_t
+
+    @discussion A range of physically contiguous frames managed by the buddy
+    system. The metadata is kept out of line, the blocks' memory is never read
+    or written.
+
+    @field    base           The physical address of the first frame, aligned
+                             to the largest block size.
+    @field    nframes        The number of frames, a multiple of the largest
+                             block size.
+    @field    order          One byte per frame. For the first frame of a block,
+                             the block's order, ORed with BUDDY_FREE if the
+                             block is free.
+    @field    link           The free list links, one per frame.
+    @field    free_head      The first free block of each order.
+    @field    free_blocks    The number of free blocks of each order.
+    @field    free_frames    The number of free frames.
+*/
+typedef struct _buddy_zone_t {
+    uint32_t base;
+    uint32_t nframes;
+    uint8_t *order;
+    buddy_link_t *link;
+    uint32_t free_head[BUDDY_ORDERS];
+    uint32_t free_blocks[BUDDY_ORDERS];
+    uint32_t free_frames;
+} buddy_zone_t;
+
+/*!
+    @typedef    buddy_stats_t
+
+    @discussion Fragmentation statistics of a zone, see buddy_zone_stats().
+
+    @field    free_frames      The number of free frames.
+    @field    free_blocks      The number of free blocks of each order.
+    @field    largest_order    The order of the largest free block, BUDDY_NONE
+                               if there is none.
+    @field    frag             The fragmentation index of each order, in
+                               percent. The part of the free memory that is in
+                               blocks too small for an allocation of that order.
+                               0 if there is no free memory.
+*/
+typedef struct _buddy_stats_t {
+    uint32_t free_frames;
+    uint32_t free_blocks[BUDDY_ORDERS];
+    uint32_t largest_order;
+    uint32_t frag[BUDDY_ORDERS];
+} buddy_stats_t;
+
+/*! See .c */
+uint32_t buddy_zone_meta_size(uint32_t nframes);
+
+/*! See .c */
+void buddy_zone_init(buddy_zone_t *z, uint32_t base, uint32_t nframes,
+                     void *meta);
+
+/*! See .c */
+uint32_t buddy_zone_alloc(buddy_zone_t *z, uint32_t order);
+
+/*! See .c */
+void buddy_zone_free(buddy_zone_t *z, uint32_t addr);
+
+/*! See .c */
+uint32_t buddy_zone_block_order(const buddy_zone_t *z, uint32_t addr);
+
+/*! See .c */
+void buddy_zone_stats(const buddy_zone_t *z, buddy_stats_t *s);
+
+/*! See .c */
+void buddy_init(uint32_t max_frames);
+
+/*! See .c */
+uint32_t buddy_alloc(uint32_t order);
+
+/*! See .c */
+void buddy_free(uint32_t addr);
+
+/*! See .c */
+uint32_t buddy_contains(uint32_t addr);
+
+/*! See .c */
+void buddy_stats(buddy_stats_t *s);
+
+/*! See .c */
+void buddy_print_stats(void);
+
+#endif
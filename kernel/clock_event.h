@@ -0,0 +1,64 @@
+/*!
+    @header Clock event devices.
+    A clock event device is a timer that interrupts periodically or once,
+    after a programmed delay, e.g. the 8254 PIT, see drivers/pit.c. The
+    scheduler tick and the timeouts program it through clock_event_t, without
+    knowing the hardware.
+
+    @doc [Clock event devices](https://www.kernel.org/doc/html/latest/timers/highres.html)
+*/
+#ifndef __CLOCK_EVENT_H__
+#define __CLOCK_EVENT_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    CLOCK_EVT_FEAT_PERIODIC, CLOCK_EVT_FEAT_ONESHOT
+
+    @discussion clock_event_t features: the device interrupts periodically,
+    see set_periodic; the device interrupts once, see set_next_event.
+*/
+#define CLOCK_EVT_FEAT_PERIODIC (0x01)
+#define CLOCK_EVT_FEAT_ONESHOT (0x02)
+
+/*!
+    @typedef    clock_event_handler_t
+
+    @discussion Called on each event of a clock event device, by its interrupt
+    handler, with interrupts disabled. ctx is the device's ctx.
+*/
+typedef void (*clock_event_handler_t)(void *ctx);
+
+/*!
+    @typedef    clock_event_t
+
+    @discussion A clock event device. The operations are callable with
+    interrupts enabled or disabled, also from the handler.
+
+    @field    name              The device's name.
+    @field    features          CLOCK_EVT_FEAT_* bits.
+    @field    min_delta_us      The shortest delay of set_next_event.
+    @field    max_delta_us      The longest delay of set_next_event.
+    @field    set_periodic      Interrupts hz times per second, until
+                                reprogrammed. 0, -1 if hz is out of range.
+    @field    set_next_event    Interrupts once, in us microseconds, and
+                                stops the periodic interrupts. 0, -1 if us is
+                                out of range.
+    @field    shutdown          Stops the interrupts.
+    @field    handler           Called on each event, if not NULL. Set by the
+                                user of the device.
+    @field    ctx               Passed to handler.
+*/
+typedef struct _clock_event_t {
+    const char *name;
+    uint32_t features;
+    uint32_t min_delta_us;
+    uint32_t max_delta_us;
+    int (*set_periodic)(uint32_t hz);
+    int (*set_next_event)(uint32_t us);
+    void (*shutdown)(void);
+    volatile clock_event_handler_t handler;
+    void *volatile ctx;
+} clock_event_t;
+
+#endif
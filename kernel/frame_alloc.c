@@ -0,0 +1,448 @@
+/*!
+    @header Physical page frame allocator.
+    Manages the machine's RAM in FRAME_SIZE frames. The kernel's pool is built
+    from the boot memory map by frame_alloc_init(). The frame_pool_* functions
+    work on any pool, e.g. the test suite uses its own.
+
+    @discussion A pool is a bitmap with one bit per frame, 1 = free. A single
+    frame allocation scans the bitmap 32 frames at a time, starting at the hint
+    word, and picks the lowest free frame of the first non-zero word with BSF.
+    No free frame exists below the hint, it only moves up when the frames below
+    it run out and moves back down when a frame below it is freed, hence a
+    sequence of single frame allocations and frees runs in O(1) amortized time
+    per operation.
+
+    Contiguous allocations use first-fit over the bitmap, starting at the hint.
+    Words without free frames are skipped 32 frames at a time.
+
+    The bitmap of the kernel's pool is placed right after the kernel and the
+    boot modules, it covers RAM up to the end of the highest usable memory map
+    range, below 4 GiB.
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/mylibc.h"
+#include "frame_alloc.h"
+
+/*!
+    @var    _kernel_start, _kernel_end
+
+    @discussion The first byte of the kernel and one past its last byte,
+    including .bss, page aligned. Defined by kernel/linker.ld.
+*/
+extern char _kernel_start[], _kernel_end[];
+
+/*!
+    @var    kernel_pool
+
+    @discussion The kernel's pool of frames, see frame_alloc_init().
+*/
+static frame_pool_t kernel_pool;
+
+/*!
+    @function    bsf32
+
+    @discussion Returns the index of the lowest set bit of x. The result is
+    undefined if x is 0. @doc [BSF](Intel 64 & IA-32 Arch. SDM Vol.2A Ch.3.2)
+
+    @param    x    A non-zero value.
+
+    @result The bit index, 0 to 31.
+*/
+static inline __attribute__((always_inline)) uint32_t bsf32(uint32_t x) {
+    uint32_t r;
+
+    __asm__("bsf %1, %0" : "=r" (r) : "rm" (x));
+
+    return r;
+}
+
+/*!
+    @function    align_up
+
+    @discussion Rounds x up to a multiple of align, a power of 2.
+*/
+static inline __attribute__((always_inline))
+uint32_t align_up(uint32_t x, uint32_t align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+/*!
+    @function    frame_is_free
+
+    @discussion Returns non-zero if frame i of pool p is free.
+*/
+static inline __attribute__((always_inline))
+uint32_t frame_is_free(const frame_pool_t *p, uint32_t i) {
+    return p->bitmap[i >> 5] & BITN(i & 31);
+}
+
+/*!
+    @function    frame_pool_bitmap_size
+
+    @discussion Returns the size of the bitmap for a pool of nframes frames.
+
+    @param    nframes    The number of frames.
+
+    @result The bitmap size in bytes, a multiple of 4.
+*/
+uint32_t frame_pool_bitmap_size(uint32_t nframes) {
+    return ((nframes + 31) / 32) * sizeof(uint32_t);
+}
+
+/*!
+    @function    frame_pool_init
+
+    @discussion Initializes a pool of nframes frames, all of them reserved.
+    Use frame_pool_free_range() to add free frames.
+
+    @param    p          The pool.
+    @param    bitmap     The pool's bitmap, frame_pool_bitmap_size(nframes)
+                         bytes.
+    @param    nframes    The number of frames.
+*/
+void frame_pool_init(frame_pool_t *p, uint32_t *bitmap, uint32_t nframes) {
+    uint32_t i;
+
+    p->bitmap = bitmap;
+    p->nwords = (nframes + 31) / 32;
+    p->nframes = nframes;
+    p->free_frames = 0;
+    p->hint = p->nwords;
+
+    for (i = 0; i < p->nwords; i++)
+        p->bitmap[i] = 0;
+}
+
+/*!
+    @function    frame_pool_free_range
+
+    @discussion Marks the frames that lie entirely in [start, end) as free.
+    Parts of the range outside the pool are ignored.
+
+    @param    p        The pool.
+    @param    start    The physical start address.
+    @param    end      The physical end address, exclusive.
+*/
+void frame_pool_free_range(frame_pool_t *p, uint64_t start, uint64_t end) {
+    uint64_t i, last;
+
+    i = (start + FRAME_SIZE - 1) >> FRAME_SHIFT;
+    last = end >> FRAME_SHIFT;
+    if (last > p->nframes)
+        last = p->nframes;
+
+    for (; i < last; i++) {
+        if (!frame_is_free(p, i)) {
+            p->bitmap[i >> 5] |= BITN(i & 31);
+            p->free_frames++;
+        }
+    }
+
+    i = (start + FRAME_SIZE - 1) >> FRAME_SHIFT;
+    if (i < last && (i >> 5) < p->hint)
+        p->hint = i >> 5;
+}
+
+/*!
+    @function    frame_pool_reserve_range
+
+    @discussion Marks the frames that overlap [start, end) as allocated. Parts
+    of the range outside the pool are ignored.
+
+    @param    p        The pool.
+    @param    start    The physical start address.
+    @param    end      The physical end address, exclusive.
+*/
+void frame_pool_reserve_range(frame_pool_t *p, uint64_t start, uint64_t end) {
+    uint64_t i, last;
+
+    i = start >> FRAME_SHIFT;
+    last = (end + FRAME_SIZE - 1) >> FRAME_SHIFT;
+    if (last > p->nframes)
+        last = p->nframes;
+
+    for (; i < last; i++) {
+        if (frame_is_free(p, i)) {
+            p->bitmap[i >> 5] &= ~BITN(i & 31);
+            p->free_frames--;
+        }
+    }
+}
+
+/*!
+    @function    frame_pool_alloc
+
+    @discussion Allocates the lowest free frame of the pool.
+
+    @param    p    The pool.
+
+    @result The physical address of the frame, FRAME_NONE if there is none.
+*/
+uint32_t frame_pool_alloc(frame_pool_t *p) {
+    uint32_t w, b;
+
+    for (w = p->hint; w < p->nwords; w++) {
+        if (p->bitmap[w] != 0) {
+            b = bsf32(p->bitmap[w]);
+            p->bitmap[w] &= ~BITN(b);
+            p->free_frames--;
+            p->hint = w;
+            return ((w << 5) + b) << FRAME_SHIFT;
+        }
+    }
+
+    p->hint = p->nwords;
+
+    return FRAME_NONE;
+}
+
+/*!
+    @function    frame_pool_free
+
+    @discussion Frees a frame allocated with frame_pool_alloc(). Freeing a free
+    frame is a fatal error.
+
+    @param    p       The pool.
+    @param    addr    The physical address of the frame.
+*/
+void frame_pool_free(frame_pool_t *p, uint32_t addr) {
+    uint32_t i = addr >> FRAME_SHIFT;
+
+    assert((addr & (FRAME_SIZE - 1)) == 0 && i < p->nframes);
+    assert(!frame_is_free(p, i));
+
+    p->bitmap[i >> 5] |= BITN(i & 31);
+    p->free_frames++;
+
+    if ((i >> 5) < p->hint)
+        p->hint = i >> 5;
+}
+
+/*!
+    @function    frame_pool_alloc_contig
+
+    @discussion Allocates n physically contiguous frames, first-fit. The first
+    frame's index is a multiple of align.
+
+    @param    p        The pool.
+    @param    n        The number of frames, > 0.
+    @param    align    The alignment in frames, a power of 2. 1 for none.
+
+    @result The physical address of the first frame, FRAME_NONE if there is no
+    such run of free frames.
+*/
+uint32_t frame_pool_alloc_contig(frame_pool_t *p, uint32_t n, uint32_t align) {
+    uint32_t i, j, w;
+
+    if (n == 0 || n > p->nframes)
+        return FRAME_NONE;
+
+    i = align_up(p->hint << 5, align);
+
+    while (i <= p->nframes - n) {
+        w = p->bitmap[i >> 5] >> (i & 31);
+        if (w == 0) {
+            i = align_up((i | 31) + 1, align); // No free frame left in word.
+            continue;
+        }
+
+        i += bsf32(w);                         // i := next free frame.
+        if ((i & (align - 1)) != 0) {
+            i = align_up(i, align);
+            continue;
+        }
+        if (i > p->nframes - n)
+            break;
+
+        for (j = 1; j < n && frame_is_free(p, i + j); j++)
+            ;
+
+        if (j == n) {
+            for (j = 0; j < n; j++)
+                p->bitmap[(i + j) >> 5] &= ~BITN((i + j) & 31);
+            p->free_frames -= n;
+            while (p->hint < p->nwords && p->bitmap[p->hint] == 0)
+                p->hint++;
+            return i << FRAME_SHIFT;
+        }
+
+        i = align_up(i + j, align);            // Frame i + j is allocated.
+    }
+
+    return FRAME_NONE;
+}
+
+/*!
+    @function    frame_pool_free_contig
+
+    @discussion Frees n contiguous frames allocated with
+    frame_pool_alloc_contig().
+
+    @param    p       The pool.
+    @param    addr    The physical address of the first frame.
+    @param    n       The number of frames.
+*/
+void frame_pool_free_contig(frame_pool_t *p, uint32_t addr, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        frame_pool_free(p, addr + (i << FRAME_SHIFT));
+}
+
+/*!
+    @function    bitmap_place
+
+    @discussion Finds a place for the kernel pool's bitmap, at or above addr,
+    in a usable memory map range.
+
+    @param    bi      The boot info.
+    @param    addr    The lowest address, page aligned.
+    @param    size    The size of the bitmap.
+
+    @result The bitmap's address, 0 if there is no place.
+*/
+static uint32_t bitmap_place(const boot_info_t *bi, uint32_t addr,
+                             uint32_t size) {
+    uint64_t start, end, best = 0;
+    uint32_t i;
+
+    for (i = 0; i < bi->mmap_len; i++) {
+        if (!e820_entry_usable(&bi->mmap[i]))
+            continue;
+
+        start = (bi->mmap[i].base + FRAME_SIZE - 1) & ~(FRAME_SIZE - 1ULL);
+        end = bi->mmap[i].base + bi->mmap[i].length;
+        if (start < addr)
+            start = addr;
+
+        if (start + size <= end && start < 0x100000000ULL - size &&
+            (best == 0 || start < best))
+            best = start;
+    }
+
+    return best;
+}
+
+/*!
+    @function    frame_alloc_init
+
+    @discussion Builds the kernel's pool of frames from the boot memory map.
+    The usable ranges are free, except for the first MiB, which holds the BIOS
+    data, the boot info and the boot loader, the kernel, the boot modules and
+    the bitmap itself. Ranges of other types are reserved even if they overlap
+    a usable range.
+
+    @param    bi    The boot info.
+*/
+void frame_alloc_init(const boot_info_t *bi) {
+    frame_pool_t *p = &kernel_pool;
+    uint64_t end = boot_info_usable_end(bi);
+    uint32_t nframes, size, addr, i;
+
+    if (end > 0x100000000ULL)
+        end = 0x100000000ULL;
+    nframes = end >> FRAME_SHIFT;
+    size = frame_pool_bitmap_size(nframes);
+
+    addr = (uint32_t) _kernel_end;
+    for (i = 0; i < bi->mods_len; i++) {
+        if (bi->mods[i].end > addr)
+            addr = bi->mods[i].end;
+    }
+    addr = bitmap_place(bi, align_up(addr, FRAME_SIZE), size);
+    if (addr == 0) {
+        print("frame_alloc_init: no memory for the frame bitmap.\n");
+        dead_loop();
+    }
+
+    frame_pool_init(p, (uint32_t *) addr, nframes);
+
+    for (i = 0; i < bi->mmap_len; i++) {
+        if (e820_entry_usable(&bi->mmap[i]))
+            frame_pool_free_range(p, bi->mmap[i].base,
+                                  bi->mmap[i].base + bi->mmap[i].length);
+    }
+    for (i = 0; i < bi->mmap_len; i++) {
+        if (!e820_entry_usable(&bi->mmap[i]))
+            frame_pool_reserve_range(p, bi->mmap[i].base,
+                                     bi->mmap[i].base + bi->mmap[i].length);
+    }
+
+    frame_pool_reserve_range(p, 0, 0x100000);
+    frame_pool_reserve_range(p, (uint32_t) _kernel_start,
+                             (uint32_t) _kernel_end);
+    for (i = 0; i < bi->mods_len; i++)
+        frame_pool_reserve_range(p, bi->mods[i].start, bi->mods[i].end);
+    frame_pool_reserve_range(p, addr, addr + size);
+}
+
+/*!
+    @function    frame_alloc
+
+    @discussion Allocates a frame from the kernel's pool.
+
+    @result The physical address of the frame, FRAME_NONE if out of memory.
+*/
+uint32_t frame_alloc(void) {
+    return frame_pool_alloc(&kernel_pool);
+}
+
+/*!
+    @function    frame_free
+
+    @discussion Frees a frame allocated with frame_alloc().
+
+    @param    addr    The physical address of the frame.
+*/
+void frame_free(uint32_t addr) {
+    frame_pool_free(&kernel_pool, addr);
+}
+
+/*!
+    @function    frame_alloc_contig
+
+    @discussion Allocates n physically contiguous frames from the kernel's
+    pool. See frame_pool_alloc_contig().
+
+    @param    n        The number of frames.
+    @param    align    The alignment in frames, a power of 2. 1 for none.
+
+    @result The physical address of the first frame, FRAME_NONE if out of
+    memory.
+*/
+uint32_t frame_alloc_contig(uint32_t n, uint32_t align) {
+    return frame_pool_alloc_contig(&kernel_pool, n, align);
+}
+
+/*!
+    @function    frame_free_contig
+
+    @discussion Frees n contiguous frames allocated with frame_alloc_contig().
+
+    @param    addr    The physical address of the first frame.
+    @param    n       The number of frames.
+*/
+void frame_free_contig(uint32_t addr, uint32_t n) {
+    frame_pool_free_contig(&kernel_pool, addr, n);
+}
+
+/*!
+    @function    frame_free_count
+
+    @result The number of free frames in the kernel's pool.
+*/
+uint32_t frame_free_count(void) {
+    return kernel_pool.free_frames;
+}
+
+/*!
+    @function    frame_count
+
+    @result The number of frames covered by the kernel's pool, free or not.
+    Every frame the pool hands out has an index below it.
+*/
+uint32_t frame_count(void) {
+    return kernel_pool.nframes;
+}
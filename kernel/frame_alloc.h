@@ -0,0 +1,96 @@
+#ifndef __FRAME_ALLOC_H__
+#define __FRAME_ALLOC_H__
+
+#include "../include/stdint.h"
+#include "boot_info.h"
+
+/*!
+    @defined    FRAME_SIZE
+
+    @discussion The size of a physical page frame in bytes.
+*/
+#define FRAME_SIZE (4096)
+
+/*!
+    @defined    FRAME_SHIFT
+
+    @discussion log2(FRAME_SIZE).
+*/
+#define FRAME_SHIFT (12)
+
+/*!
+    @defined    FRAME_NONE
+
+    @discussion Returned by the allocation functions when no frame is
+    available. Never a valid frame address, frames are FRAME_SIZE aligned.
+*/
+#define FRAME_NONE (0xFFFFFFFF)
+
+/*!
+    @typedef    frame_pool_t
+
+    @discussion A pool of physical page frames. Frame i is at physical address
+    i * FRAME_SIZE.
+
+    @field    bitmap         One bit per frame, 1 = free, 0 = allocated or
+                             reserved. Bits past nframes are 0.
+    @field    nwords         The number of 32-bit words in bitmap.
+    @field    nframes        The number of frames in the pool.
+    @field    free_frames    The number of free frames.
+    @field    hint           The index of a bitmap word such that there is no
+                             free frame in the words below it.
+*/
+typedef struct _frame_pool_t {
+    uint32_t *bitmap;
+    uint32_t nwords;
+    uint32_t nframes;
+    uint32_t free_frames;
+    uint32_t hint;
+} frame_pool_t;
+
+/*! See .c */
+uint32_t frame_pool_bitmap_size(uint32_t nframes);
+
+/*! See .c */
+void frame_pool_init(frame_pool_t *p, uint32_t *bitmap, uint32_t nframes);
+
+/*! See .c */
+void frame_pool_free_range(frame_pool_t *p, uint64_t start, uint64_t end);
+
+/*! See .c */
+void frame_pool_reserve_range(frame_pool_t *p, uint64_t start, uint64_t end);
+
+/*! See .c */
+uint32_t frame_pool_alloc(frame_pool_t *p);
+
+/*! See .c */
+void frame_pool_free(frame_pool_t *p, uint32_t addr);
+
+/*! See .c */
+uint32_t frame_pool_alloc_contig(frame_pool_t *p, uint32_t n, uint32_t align);
+
+/*! See .c */
+void frame_pool_free_contig(frame_pool_t *p, uint32_t addr, uint32_t n);
+
+/*! See .c */
+void frame_alloc_init(const boot_info_t *bi);
+
+/*! See .c */
+uint32_t frame_alloc(void);
+
+/*! See .c */
+void frame_free(uint32_t addr);
+
+/*! See .c */
+uint32_t frame_alloc_contig(uint32_t n, uint32_t align);
+
+/*! See .c */
+void frame_free_contig(uint32_t addr, uint32_t n);
+
+/*! See .c */
+uint32_t frame_free_count(void);
+
+/*! See .c */
+uint32_t frame_count(void);
+
+#endif
@@ -12,6 +12,7 @@
 #include "low_level.h"
 #include "../include/mylibc.h"
 #include "../include/assert.h"
+#include "i8259a_pic.h"
 
 /*!
     @defined IO_MASTER_PIC_PORT_A
@@ -158,6 +159,15 @@ static inline uint8_t icw4(int mode, int a_eoi, int ms, int buf, int sfnm) {
     return *p;
 }
 
+/*!
+    @var irq_mask
+    @discussion The interrupt masks of the master PIC, bits 7:0, and of the
+    slave PIC, bits 15:8. 1 means ignore. Kept here so that the lines unmasked
+    by request_irq() before init_pics() stay unmasked. All lines are masked,
+    but the cascade line, IRQ2.
+*/
+static uint16_t irq_mask = (uint16_t) ~BIT2;
+
 /*!
     @function init_pics
 
@@ -204,8 +214,50 @@ void init_pics(void) {
         In this byte 0 = listen, 1 = ignore. Reading from port B returns the
         current mask value.
     */
-    outb(IO_MASTER_PIC_PORT_B, (uint8_t)(~(BIT1)));
-    outb(IO_SLAVE_PIC_PORT_B, (uint8_t)(~(0U)));
+    outb(IO_MASTER_PIC_PORT_B, (uint8_t) irq_mask);
+    outb(IO_SLAVE_PIC_PORT_B, (uint8_t) (irq_mask >> 8));
+}
+
+/*!
+    @function pic_write_mask
+    @discussion Writes the mask of the PIC of IRQ line irq.
+*/
+static void pic_write_mask(uint32_t irq) {
+    if (irq < 8)
+        outb(IO_MASTER_PIC_PORT_B, (uint8_t) irq_mask);
+    else
+        outb(IO_SLAVE_PIC_PORT_B, (uint8_t) (irq_mask >> 8));
+}
+
+/*!
+    @function pic_mask
+    @discussion Masks IRQ line irq, the PIC ignores it.
+    @param irq The IRQ line, 0 - 15.
+*/
+void pic_mask(uint32_t irq) {
+    uint32_t flags;
+
+    assert(irq < 16);
+    flags = irq_save();
+    irq_mask |= BITN(irq);
+    pic_write_mask(irq);
+    irq_restore(flags);
+}
+
+/*!
+    @function pic_unmask
+    @discussion Unmasks IRQ line irq, the PIC listens to it. The slave PIC's
+    lines also need the cascade line, IRQ2, which is never masked.
+    @param irq The IRQ line, 0 - 15.
+*/
+void pic_unmask(uint32_t irq) {
+    uint32_t flags;
+
+    assert(irq < 16);
+    flags = irq_save();
+    irq_mask &= ~BITN(irq);
+    pic_write_mask(irq);
+    irq_restore(flags);
 }
 
 /*!
@@ -236,4 +288,30 @@ void pic_eoi(uint32_t vn) {
     } else {
         assert(0);
     }
-}
\ No newline at end of file
+}
+
+/*!
+    @function pic_get_mask
+    @result The IRQ masks, see irq_mask. Bit n is set if IRQ line n is masked.
+*/
+uint32_t pic_get_mask(void) {
+    return irq_mask;
+}
+
+/*!
+    @function pic_disable
+    @discussion Masks all the lines at both PICs, e.g. when the APICs take
+    over. The masks of pic_mask()/pic_unmask() are kept.
+*/
+void pic_disable(void) {
+    outb(IO_MASTER_PIC_PORT_B, 0xFF);
+    outb(IO_SLAVE_PIC_PORT_B, 0xFF);
+}
+
+/*!
+    @const pic_ctlr
+    @discussion The 8259A PICs as the interrupt controller, see intr_ctlr.
+*/
+const intr_ctlr_t pic_ctlr = {
+    "8259A", pic_eoi, pic_mask, pic_unmask
+};
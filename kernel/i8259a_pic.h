@@ -1,6 +1,12 @@
 #ifndef __I8259A_PIC_H__
 #define __I8259A_PIC_H__
 
+#include "../include/stdint.h"
+#include "idt.h"
+
+/*! See .c */
+extern const intr_ctlr_t pic_ctlr;
+
 /*! See .c */
 void init_pics(void);
 
@@ -13,4 +19,16 @@ void init_pics(void);
 /*! See .c */
 void pic_eoi(uint32_t vn);
 
+/*! See .c */
+void pic_mask(uint32_t irq);
+
+/*! See .c */
+void pic_unmask(uint32_t irq);
+
+/*! See .c */
+uint32_t pic_get_mask(void);
+
+/*! See .c */
+void pic_disable(void);
+
 #endif
\ No newline at end of file
@@ -4,12 +4,15 @@
 */
 
 #include "../drivers/screen.h"
-#include "../drivers/keyboard.h"
 #include "../include/stdint.h"
 #include "../include/assert.h"
+#include "../include/stdio.h" // kprintf()
+#include "idt.h"
 #include "idt_asm.h"
 #include "i8259a_pic.h"
 #include "low_level.h"
+#include "page_fault.h"
+#include "klog.h"
 
 
 /*******************************************************************************
@@ -217,12 +220,6 @@ static inline uint64_t intr_gate_d(uint32_t offset, uint32_t p, uint32_t dpl,
     return *((uint64_t *) &dt);
 }
 
-/*!
-    @defined    IDT_LEN
-    @discussion The length of the IDT array.
-*/
-#define IDT_LEN (34)
-
 /*
     @IMPORTANT The base addresses of the IDT should be aligned on an 8-byte
     boundary to maximize performance of cache line fills.
@@ -232,57 +229,187 @@ static inline uint64_t intr_gate_d(uint32_t offset, uint32_t p, uint32_t dpl,
 */
 uint64_t idt[IDT_LEN] __attribute__((aligned (8) ));
 
-void vn_not_handled(uint32_t vn, uint32_t err_code) {
-    if (vn || err_code) { // Suppress warning.
+/*!
+    @function    vn_not_handled
+
+    @discussion The handler of the vectors without one. Logs the vector and
+    stops.
+*/
+void vn_not_handled(uint32_t vn, uint32_t err_code, void *ctx) {
+    if (ctx) { // Suppress warning.
         ;
     }
-    print("This interrupt is not handled.\n");
+    klog(KLOG_ERR, "Interrupt %u is not handled, error code %08x.", vn,
+         err_code);
     assert(0);
 }
 
 /*!
-    @const    idt_handlers
-    @discussion Array of interrupt/exception procedure entry points and vector
-    specific handlers. The first member is used as value for the offset field in
-    interrupt and trap gate descriptors while the second member is the function
-    that is called by the common interrupt/exception handler.
-*/
-const idt_handler_t idt_handlers[IDT_LEN] = {
-    {INTR_VN_HANDLER(0), vn_not_handled},
-    {INTR_VN_HANDLER(1), vn_not_handled},
-    {INTR_VN_HANDLER(2), vn_not_handled},
-    {INTR_VN_HANDLER(3), vn_not_handled},
-    {INTR_VN_HANDLER(4), vn_not_handled},
-    {INTR_VN_HANDLER(5), vn_not_handled},
-    {INTR_VN_HANDLER(6), vn_not_handled},
-    {INTR_VN_HANDLER(7), vn_not_handled},
-    {INTR_VN_HANDLER(8), vn_not_handled},
-    {INTR_VN_HANDLER(9), vn_not_handled},
-    {INTR_VN_HANDLER(10), vn_not_handled},
-    {INTR_VN_HANDLER(11), vn_not_handled},
-    {INTR_VN_HANDLER(12), vn_not_handled},
-    {INTR_VN_HANDLER(13), vn_not_handled},
-    {INTR_VN_HANDLER(14), vn_not_handled},
-    {0, 0}, // 15 - Intel Reserved.
-    {INTR_VN_HANDLER(16), vn_not_handled},
-    {INTR_VN_HANDLER(17), vn_not_handled},
-    {INTR_VN_HANDLER(18), vn_not_handled},
-    {INTR_VN_HANDLER(19), vn_not_handled},
-    {INTR_VN_HANDLER(20), vn_not_handled},
-    {INTR_VN_HANDLER(21), vn_not_handled},
-    {0, 0}, // 22 - Intel Reserved.
-    {0, 0}, // 23
-    {0, 0}, // 24
-    {0, 0}, // 25
-    {0, 0}, // 26
-    {0, 0}, // 27
-    {0, 0}, // 28
-    {0, 0}, // 29
-    {0, 0}, // 30
-    {0, 0}, // 31
-    {INTR_VN_HANDLER(32), vn_not_handled}, // 32-255 - User Defined Interrupts
-    {INTR_VN_HANDLER(33), v33_handler}
-};
+    @var    intr_ctlr
+
+    @discussion The interrupt controller, the 8259A PICs until apic_init()
+    replaces them.
+*/
+const intr_ctlr_t *intr_ctlr = &pic_ctlr;
+
+/*!
+    @var    intr_nesting
+
+    @discussion The number of handlers running, more than 1 if a handler was
+    interrupted, e.g. by an exception. See softirq_irq_exit().
+*/
+volatile uint32_t intr_nesting;
+
+/*!
+    @var    intr_bp_count
+
+    @discussion The number of breakpoint exceptions (#BP), i.e. INT3
+    instructions executed. See v3_handler().
+*/
+volatile uint32_t intr_bp_count;
+
+/*!
+    @function    v3_handler
+
+    @discussion Breakpoint exception (#BP) handler. #BP is a trap, the saved
+    EIP points past the INT3, hence returning resumes execution. Counts the
+    breakpoints, INT3 is a cheap way to time a round trip through the
+    interrupt path.
+*/
+static void v3_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    if (vn || err_code || ctx) { // Suppress warning.
+        ;
+    }
+    intr_bp_count++;
+}
+
+/*!
+    @typedef    intr_desc_t
+
+    @discussion The handler of a vector and its argument.
+
+    @field    handler    Called by intr_handler().
+    @field    ctx        Passed to the handler.
+*/
+typedef struct _intr_desc_t {
+    vn_handler_t handler;
+    void *ctx;
+} intr_desc_t;
+
+/*!
+    @var    intr_table
+
+    @discussion The handlers, indexed by vector number. Filled with
+    vn_not_handled on first use, see intr_table_init(). Written with
+    interrupts disabled, hence intr_handler() never sees a handler without
+    its ctx.
+*/
+static intr_desc_t intr_table[IDT_LEN];
+
+/*!
+    @function    intr_table_init
+
+    @discussion Initializes intr_table on first use, with the exception
+    handlers of the kernel, so that handlers can be registered before
+    init_interrupts().
+*/
+static void intr_table_init(void) {
+    int v;
+
+    if (intr_table[0].handler)
+        return;
+
+    for (v = 0; v < IDT_LEN; v++) {
+        intr_table[v].handler = vn_not_handled;
+        intr_table[v].ctx = NULL;
+    }
+    intr_table[3].handler = v3_handler;
+    intr_table[14].handler = v14_handler;
+}
+
+/*!
+    @function    intr_register
+
+    @discussion Installs the handler of vector vn.
+
+    @param    vn         The vector number.
+    @param    handler    The handler.
+    @param    ctx        Passed to the handler.
+
+    @result 0, -1 if the vector already has a handler.
+*/
+int intr_register(uint32_t vn, vn_handler_t handler, void *ctx) {
+    uint32_t flags;
+
+    assert(vn < IDT_LEN && handler);
+    intr_table_init();
+
+    if (intr_table[vn].handler != vn_not_handled)
+        return -1;
+
+    flags = irq_save();
+    intr_table[vn].ctx = ctx;
+    intr_table[vn].handler = handler;
+    irq_restore(flags);
+
+    return 0;
+}
+
+/*!
+    @function    intr_unregister
+
+    @discussion Removes the handler of vector vn.
+
+    @param    vn    The vector number.
+*/
+void intr_unregister(uint32_t vn) {
+    uint32_t flags;
+
+    assert(vn < IDT_LEN);
+    intr_table_init();
+
+    flags = irq_save();
+    intr_table[vn].handler = vn_not_handled;
+    intr_table[vn].ctx = NULL;
+    irq_restore(flags);
+}
+
+/*!
+    @function    request_irq
+
+    @discussion Installs the handler of IRQ line irq and unmasks the line. The
+    handler is called with the vector number IRQ_VN(irq) and must acknowledge
+    the interrupt controller, see irq_eoi().
+
+    @param    irq        The IRQ line, < IRQ_LINES.
+    @param    handler    The handler.
+    @param    ctx        Passed to the handler, e.g. the device.
+
+    @result 0, -1 if the line already has a handler.
+*/
+int request_irq(uint32_t irq, vn_handler_t handler, void *ctx) {
+    assert(irq < IRQ_LINES);
+
+    if (intr_register(IRQ_VN(irq), handler, ctx))
+        return -1;
+    intr_ctlr->unmask(irq);
+
+    return 0;
+}
+
+/*!
+    @function    free_irq
+
+    @discussion Masks IRQ line irq and removes its handler.
+
+    @param    irq    The IRQ line, < IRQ_LINES.
+*/
+void free_irq(uint32_t irq) {
+    assert(irq < IRQ_LINES);
+
+    intr_ctlr->mask(irq);
+    intr_unregister(IRQ_VN(irq));
+}
 
 /*!
     @struct idt_reg_t
@@ -358,30 +485,17 @@ void intr_handler(uint32_t vn, uint32_t err_code) {
 #if 0
     struct intr_err_code_t *errc;
 
-    print("Vector Number = ");
-    print_d(vn);
-    print("\n");
-
     errc = (struct intr_err_code_t *) &err_code;
-    print("errc.ext = ");
-    print_x32(errc->ext);
-    print("\n");
-
-    print("errc.idt = ");
-    print_x32(errc->idt);
-    print("\n");
-
-    print("errc.ti = ");
-    print_x32(errc->ti);
-    print("\n");
-
-    print("errc.seg_sel_idx = ");
-    print_d(errc->seg_sel_idx);
-    print("\n");
+    kprintf("Vector Number = %u\n", vn);
+    kprintf("errc.ext = %08x\nerrc.idt = %08x\nerrc.ti = %08x\n",
+            errc->ext, errc->idt, errc->ti);
+    kprintf("errc.seg_sel_idx = %u\n", errc->seg_sel_idx);
 #endif
 
     // Call the specific interrupt/exception handler.
-    idt_handlers[vn].vn_handler(vn, err_code);
+    intr_nesting++;
+    intr_table[vn].handler(vn, err_code, intr_table[vn].ctx);
+    intr_nesting--;
 }
 
 /*!
@@ -391,10 +505,12 @@ void intr_handler(uint32_t vn, uint32_t err_code) {
 void init_interrupts(void) {
     struct idt_reg_t idtr;
 
+    intr_table_init();
+
     // Fill IDT.
     for (int v = 0; v < IDT_LEN; v++) {
         if (!IDT_RSVD_VECT(v))
-            idt[v] = intr_gate_d((uint32_t) idt_handlers[v].idt_proc,
+            idt[v] = intr_gate_d((uint32_t) intr_stubs[v],
                                  SEG_PRESENT, DPL_0, GATE_SIZE_32,
                                  CODE_SEG);
     }
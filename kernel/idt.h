@@ -1,7 +1,85 @@
 #ifndef __IDT_H__
 #define __IDT_H__
 
+#include "../include/stdint.h"
+
+/*!
+    @defined    IDT_LEN
+    @discussion The length of the IDT array, every vector.
+*/
+#define IDT_LEN (256)
+
+/*!
+    @defined    IRQ_LINES
+
+    @discussion The number of IRQ lines of the two 8259A PICs. IRQ n is
+    delivered as vector IRQ_VN(n), see init_pics().
+*/
+#define IRQ_LINES (16)
+#define IRQ_VN(irq) (32 + (irq))
+
+/*!
+    @typedef    vn_handler_t
+    @discussion Pointer to function that handles a specific interrupt/exception
+                taking into account the vector number, i.e. taking into account
+                the source of the interrupt. ctx is the value passed to
+                intr_register() or request_irq(), e.g. the device.
+*/
+typedef void (*vn_handler_t)(uint32_t vn, uint32_t err_code, void *ctx);
+
+/*!
+    @typedef    intr_ctlr_t
+
+    @discussion An interrupt controller, e.g. the 8259A PICs or the APICs. See
+    intr_ctlr.
+
+    @field    name      The controller's name.
+    @field    eoi       Signals the end of the interrupt of vector vn.
+    @field    mask      Masks IRQ line irq.
+    @field    unmask    Unmasks IRQ line irq.
+*/
+typedef struct _intr_ctlr_t {
+    const char *name;
+    void (*eoi)(uint32_t vn);
+    void (*mask)(uint32_t irq);
+    void (*unmask)(uint32_t irq);
+} intr_ctlr_t;
+
+/*! See .c */
+extern const intr_ctlr_t *intr_ctlr;
+
+/*!
+    @function    irq_eoi
+
+    @discussion Signals the end of the interrupt of vector vn to the interrupt
+    controller. Called by the IRQ handlers.
+*/
+static inline void irq_eoi(uint32_t vn) {
+    intr_ctlr->eoi(vn);
+}
+
+/*! See .c */
+extern volatile uint32_t intr_nesting;
+
+/*! See .c */
+extern volatile uint32_t intr_bp_count;
+
+/*! See .c */
+void vn_not_handled(uint32_t vn, uint32_t err_code, void *ctx);
+
+/*! See .c */
+int intr_register(uint32_t vn, vn_handler_t handler, void *ctx);
+
+/*! See .c */
+void intr_unregister(uint32_t vn);
+
+/*! See .c */
+int request_irq(uint32_t irq, vn_handler_t handler, void *ctx);
+
+/*! See .c */
+void free_irq(uint32_t irq);
+
 /*! See .c */
 void init_interrupts(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -76,7 +76,9 @@ lidt_and_sti:
 ; Interrupt handler entry point with no error code on the stack. The name of the
 ; macro is intr_handler_no_err_code. The name of the function it defines is
 ; intr_v%1_handler. This function is not called explicitly, it is called by the
-; CPU when the corresponding interrupt occurs.
+; CPU when the corresponding interrupt occurs. Pushes 0 in place of the error
+; code, so the stack looks the same as with an error code and
+; intr_common_handler can always remove it.
 ;
 ; @doc [Figure 6-4. Stack Usage on Transfers to Interrupt and Exception-Handling
 ;       Routines](Intel 64 & IA-32 Arch. SDM Vol.3 Ch.6.12.1)
@@ -85,10 +87,11 @@ lidt_and_sti:
 %macro intr_handler_no_err_code 1
 global intr_v%1_handler
 intr_v%1_handler:
+    push dword 0            ; push 0 as the error code.
     pushad                  ; Ensures the interrupted program's state is
                             ; restored, it doesn't know it was interrupted,
                             ; interrupts are asynchronous.
-    push dword 0            ; push 0 as the error code.
+    push dword [esp + 32]   ; push the error code again, for the C function.
     push dword %1           ; push vector number.
     jmp intr_common_handler ; jump to common handler.
 %endmacro
@@ -121,19 +124,51 @@ intr_v%1_handler:
 ;!
 ; @procedure    intr_common_handler
 ;
-; @stack [esp + 4] Error code.
-;        [esp    ] Vector number.
+; @stack [esp + 52] EFLAGS, CS at [esp + 48], EIP at [esp + 44].
+;        [esp + 40] Error code, pushed by the CPU or the no_err_code wrapper.
+;        [esp + 8 ] EAX ... EDI, pushed by pushad.
+;        [esp + 4 ] Error code.
+;        [esp     ] Vector number.
 ;
 ; @discussion
 ; Code common to all interrupt/exception handlers. We jump (not call) here from
 ; the wrappers intr_handler_no_err_code/intr_handler_err_code above.
-; The function `intr_handler` is implemented in the .c file.
+; The function `intr_handler` is implemented in the .c file. The error code is
+; removed before the IRET, which expects EIP on top of the stack.
+;
+; The TSC is read before and after `intr_handler` and both are passed to
+; `intr_stats_record`, see intr_stats.c. ESI:EDI keep the first TSC across the
+; call, they are callee saved and restored by popad anyway. Then
+; `softirq_irq_exit` runs the deferred work with interrupts enabled, outside
+; of the recorded latency, see softirq.c.
+;
+; The interrupted program may have DF set, e.g. memmove's backward copy. The C
+; functions expect DF = 0 (System V i386 ABI), hence `cld` first. IRET restores
+; the program's DF with its EFLAGS.
 [extern intr_handler]
+[extern intr_stats_record]
+[extern softirq_irq_exit]
 intr_common_handler:
+    cld               ; DF := 0, string instructions increment.
+    rdtsc             ; EDX:EAX := TSC at entry.
+    mov esi, eax
+    mov edi, edx
     call intr_handler ; Call the C function. Error code and Vector number are on
                       ; the stack.
+    rdtsc             ; EDX:EAX := TSC at exit.
+    push edx          ; exit
+    push eax
+    push edi          ; entry
+    push esi
+    push dword [esp + 16] ; vn
+    call intr_stats_record
+    add esp, 20
+    push dword [esp + 52] ; EFLAGS of the interrupted program.
+    call softirq_irq_exit
+    add esp, 4
     add esp, 8
     popad
+    add esp, 4        ; Remove the error code.
     iret ; @IMPORTANT: This is not the usual `ret`. Interrupt specific return.
 
 ;-------------------------------------------------------------------------------
@@ -180,41 +215,44 @@ intr_common_handler:
 ;-------------------------------------------------------------------------------
 
 ;!
-; @function    intr_v0_handler . . . intr_v32_handler
+; @function    intr_v0_handler . . . intr_v255_handler
 ;
 ; @discussion
-; These lines define the exception and interrupt handlers for the pre-defined
-; interrupt sources given in the table above. The definitions are made using
-; NASM multi-line macros. For example, the macro `intr_handler_no_err_code 0`
-; defines the function `intr_v0_handler`. Each of these handlers is exported to
-; the .c file via the NASM `global` directive. None of these handlers are ever
-; called explicitly by the programmer. Instead, the entry point address of the
-; handler is saved in the IDT, and the CPU calls the appropriate handler when
-; the event that triggers the interrupt occurs.
-intr_handler_no_err_code   0
-intr_handler_no_err_code   1
-intr_handler_no_err_code   2
-intr_handler_no_err_code   3
-intr_handler_no_err_code   4
-intr_handler_no_err_code   5
-intr_handler_no_err_code   6
-intr_handler_no_err_code   7
-intr_handler_with_err_code 8
-intr_handler_no_err_code   9
-intr_handler_with_err_code 10
-intr_handler_with_err_code 11
-intr_handler_with_err_code 12
-intr_handler_with_err_code 13
-intr_handler_with_err_code 14
-; 15 - RESERVED
-intr_handler_no_err_code   16
-intr_handler_with_err_code 17
-intr_handler_no_err_code   18
-intr_handler_no_err_code   19
-intr_handler_no_err_code   20
-intr_handler_with_err_code 21
-; 22 - 31 RESERVED
-intr_handler_no_err_code   32 ; 32-255 - User Defined Interrupts
-intr_handler_no_err_code   33
+; These lines define the exception and interrupt handlers for all 256 vectors,
+; see the table above. The definitions are made using NASM multi-line macros in
+; a %rep loop. For example, the macro `intr_handler_no_err_code 0` defines the
+; function `intr_v0_handler`. The vectors for which the CPU pushes an error code
+; use intr_handler_with_err_code. Each of these handlers is exported to the .c
+; file via the NASM `global` directive. None of these handlers are ever called
+; explicitly by the programmer. Instead, the entry point address of the handler
+; is saved in the IDT, and the CPU calls the appropriate handler when the event
+; that triggers the interrupt occurs. The reserved vectors get handlers too,
+; they are left out of the IDT by the .c file.
+;
+; @doc [NASM preprocessor loops: %rep](NASM manual ch.4.5)
+%assign vn 0
+%rep 256
+%if vn == 8 || (vn >= 10 && vn <= 14) || vn == 17 || vn == 21
+intr_handler_with_err_code vn
+%else
+intr_handler_no_err_code   vn
+%endif
+%assign vn vn + 1
+%endrep
+
+;!
+; @var    intr_stubs
+;
+; @discussion The entry points intr_v0_handler . . . intr_v255_handler indexed
+; by vector number, used by the .c file to fill the IDT.
+section .rodata
+align 4
+global intr_stubs
+intr_stubs:
+%assign vn 0
+%rep 256
+    dd intr_v%[vn]_handler
+%assign vn vn + 1
+%endrep
 ;-------------------------------------------------------------------------------
 
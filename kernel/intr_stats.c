@@ -0,0 +1,131 @@
+/*!
+    @header Interrupt statistics.
+    Per vector interrupt counts and handler latencies, to find slow handlers.
+
+    @discussion intr_common_handler, see idt_asm.s, reads the TSC before it
+    calls intr_handler() and after it returns, and passes both to
+    intr_stats_record(). The latency covers the dispatch and the handler, not
+    the CPU's interrupt delivery, the register saves and the IRET.
+
+    The statistics of each vector are in their own cache lines, a vector's
+    record only touches its lines. The interrupt gates clear IF, hence the
+    records are updated without a lock.
+
+    @remark The TSC must be invariant for the latencies to be cycles, see
+    CPUID.80000007H:EDX[8].
+*/
+
+#include "../include/stdio.h"
+#include "idt.h"
+#include "low_level.h"
+#include "intr_stats.h"
+
+/*!
+    @var    stats
+
+    @discussion The statistics, indexed by vector number.
+*/
+static intr_stats_t stats[IDT_LEN];
+
+/*!
+    @function    log2_bucket
+
+    @discussion Returns the histogram bucket of a latency, floor(log2(cycles))
+    clamped to the buckets.
+*/
+static inline __attribute__((always_inline))
+uint32_t log2_bucket(uint32_t cycles) {
+    uint32_t b;
+
+    if (cycles == 0)
+        return 0;
+    b = 31 - __builtin_clz(cycles); // BSR.
+    return b < INTR_HIST_BUCKETS ? b : INTR_HIST_BUCKETS - 1;
+}
+
+/*!
+    @function    intr_stats_record
+
+    @discussion Records an interrupt of vector vn. Called by
+    intr_common_handler only, with interrupts disabled.
+
+    @param    vn       The vector number.
+    @param    entry    The TSC before the handler.
+    @param    exit     The TSC after the handler.
+*/
+void intr_stats_record(uint32_t vn, uint64_t entry, uint64_t exit) {
+    intr_stats_t *s = &stats[vn & (IDT_LEN - 1)];
+    uint64_t d = exit - entry;
+    uint32_t cycles = d > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t) d;
+
+    if (s->count == 0 || cycles < s->min)
+        s->min = cycles;
+    if (cycles > s->max)
+        s->max = cycles;
+    s->count++;
+    s->total += cycles;
+    s->hist[log2_bucket(cycles)]++;
+}
+
+/*!
+    @function    intr_stats_get
+
+    @param    vn    The vector number.
+
+    @result The statistics of vector vn.
+*/
+const intr_stats_t *intr_stats_get(uint32_t vn) {
+    return &stats[vn & (IDT_LEN - 1)];
+}
+
+/*!
+    @function    intr_stats_reset
+
+    @discussion Clears the statistics of all vectors.
+*/
+void intr_stats_reset(void) {
+    uint32_t flags, v, i;
+
+    flags = irq_save();
+    for (v = 0; v < IDT_LEN; v++) {
+        stats[v].count = 0;
+        stats[v].min = 0;
+        stats[v].max = 0;
+        stats[v].total = 0;
+        for (i = 0; i < INTR_HIST_BUCKETS; i++)
+            stats[v].hist[i] = 0;
+    }
+    irq_restore(flags);
+}
+
+/*!
+    @function    intr_stats_dump
+
+    @discussion Prints the statistics of the vectors that fired: the count,
+    the min/avg/max cycles, and the histogram buckets that aren't empty as
+    log2(cycles):count. A snapshot of a vector is taken with interrupts
+    disabled, the printing is done with them enabled.
+*/
+void intr_stats_dump(void) {
+    intr_stats_t s;
+    uint32_t flags, v, i;
+
+    kprintf("vec count min avg max\n");
+
+    for (v = 0; v < IDT_LEN; v++) {
+        flags = irq_save();
+        s = stats[v];
+        irq_restore(flags);
+        if (s.count == 0)
+            continue;
+
+        kprintf("%3u %u %u %u %u\n", v, s.count, s.min,
+                (uint32_t) (s.total / s.count), s.max);
+        kprintf("   ");
+        for (i = 0; i < INTR_HIST_BUCKETS; i++) {
+            if (s.hist[i])
+                kprintf(" %u:%u", i, s.hist[i]);
+        }
+        kprintf("\n");
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef __INTR_STATS_H__
+#define __INTR_STATS_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    INTR_HIST_BUCKETS
+
+    @discussion The number of latency histogram buckets. Bucket i counts the
+    handlers that took [2^i, 2^(i+1)) cycles, bucket 0 also counts 0 and the
+    last bucket everything longer.
+*/
+#define INTR_HIST_BUCKETS (24)
+
+/*!
+    @typedef    intr_stats_t
+
+    @discussion The statistics of a vector, from entry into
+    intr_common_handler to the return of the handler. Each vector has its own
+    cache lines.
+
+    @field    count    The number of interrupts.
+    @field    min      The fewest cycles taken.
+    @field    max      The most cycles taken.
+    @field    total    The cycles taken, summed.
+    @field    hist     The log2 latency histogram, see INTR_HIST_BUCKETS.
+*/
+typedef struct _intr_stats_t {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[INTR_HIST_BUCKETS];
+} __attribute__((aligned(64))) intr_stats_t;
+
+/*! See .c */
+void intr_stats_record(uint32_t vn, uint64_t entry, uint64_t exit);
+
+/*! See .c */
+const intr_stats_t *intr_stats_get(uint32_t vn);
+
+/*! See .c */
+void intr_stats_reset(void);
+
+/*! See .c */
+void intr_stats_dump(void);
+
+#endif
@@ -0,0 +1,219 @@
+/*!
+    @header Memory mapped I/O.
+    Maps device memory, e.g. the VGA text buffer or a framebuffer, with the
+    memory type it needs: uncacheable for registers, write combining for
+    frame buffers. The memory type of a 4 KiB page is selected by its PAT,
+    PCD and PWT bits, an index into the page attribute table (PAT).
+
+    @discussion pat_init() programs the PAT MSR. Only entry 1, selected by
+    PWT alone, changes from its power-on type WT to WC. WT stays available as
+    entry 5:
+
+    | Index | PAT PCD PWT | Type |
+    |-------|-------------|------|
+    | 0     | 0   0   0   | WB   |
+    | 1     | 0   0   1   | WC   |
+    | 2     | 0   1   0   | UC-  |
+    | 3     | 0   1   1   | UC   |
+    | 4-7   | 1   x   x   | WB, WT, UC-, UC |
+
+    Hence mappings without PAT bits, e.g. the identity map, stay WB. Without
+    PAT (CPUID.01H:EDX[bit 16]) ioremap_wc() falls back to UC.
+
+    ioremap() takes linear addresses from a window above the identity map,
+    IOREMAP_BASE, and never reuses them. Device mappings are global.
+
+    @doc [Page Attribute Table (PAT)](Intel 64 & IA-32 Arch. SDM Vol.3
+         Ch.11.12)
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/stddef.h" // NULL
+#include "low_level.h"
+#include "paging.h"
+#include "ioremap.h"
+
+/*!
+    @defined    CPUID_EDX_PAT
+
+    @discussion CPUID.01H:EDX[bit 16], the PAT is supported.
+*/
+#define CPUID_EDX_PAT (1U << 16)
+
+/*!
+    @defined    CR0_CD, CR0_NW
+
+    @discussion CR0 cache disable and not write-through.
+*/
+#define CR0_CD (1U << 30)
+#define CR0_NW (1U << 29)
+
+/*!
+    @defined    PAT_ENTRY(i, type)
+
+    @discussion The PAT MSR value of entry i, 8 bits per entry.
+*/
+#define PAT_ENTRY(i, type) ((uint64_t) (type) << ((i) * 8))
+
+/*!
+    @defined    PAT_VALUE
+
+    @discussion The PAT MSR value, see the table above.
+*/
+#define PAT_VALUE (PAT_ENTRY(0, PAT_WB) | PAT_ENTRY(1, PAT_WC) | \
+                   PAT_ENTRY(2, PAT_UC_MINUS) | PAT_ENTRY(3, PAT_UC) | \
+                   PAT_ENTRY(4, PAT_WB) | PAT_ENTRY(5, PAT_WT) | \
+                   PAT_ENTRY(6, PAT_UC_MINUS) | PAT_ENTRY(7, PAT_UC))
+
+/*!
+    @defined    PTE_WC, PTE_UC
+
+    @discussion The PTE bits of the WC and UC memory types.
+*/
+#define PTE_WC (PTE_PWT)
+#define PTE_UC (PTE_PCD | PTE_PWT)
+
+/*!
+    @var    pat_on
+
+    @discussion 1 if the PAT is programmed, see pat_init().
+*/
+static uint32_t pat_on;
+
+/*!
+    @var    ioremap_next
+
+    @discussion The next free linear address of the ioremap() window.
+*/
+static uint32_t ioremap_next = IOREMAP_BASE;
+
+/*!
+    @function    pat_init
+
+    @discussion Programs the PAT MSR, if the CPU has a PAT. Call after
+    paging_init(), before the first ioremap_wc().
+
+    The update follows the SDM's sequence, with interrupts disabled: caches
+    disabled with CR0.CD = 1, NW = 0, written back and invalidated, TLBs
+    flushed, then the MSR written, the caches and TLBs flushed again and CR0
+    restored. No line or TLB entry cached with the old type survives.
+
+    @doc [MTRR Considerations in MP Systems](Intel 64 & IA-32 Arch. SDM Vol.3
+         Ch.11.11.8), the PAT is programmed the same way, see Ch.11.12.4.
+*/
+void pat_init(void) {
+    uint32_t flags, cr0;
+    cpuid_regs_t r;
+
+    cpuid(1, &r);
+    if ((r.edx & CPUID_EDX_PAT) == 0)
+        return;
+
+    flags = irq_save();
+    cr0 = read_cr0();
+    write_cr0((cr0 | CR0_CD) & ~CR0_NW);
+    wbinvd();
+    tlb_flush_global();
+
+    wrmsr(MSR_IA32_PAT, PAT_VALUE);
+
+    wbinvd();
+    tlb_flush_global();
+    write_cr0(cr0);
+    irq_restore(flags);
+
+    pat_on = 1;
+}
+
+/*!
+    @function    pat_enabled
+
+    @result 1 if the PAT is programmed and ioremap_wc() maps WC, 0 otherwise.
+*/
+uint32_t pat_enabled(void) {
+    return pat_on;
+}
+
+/*!
+    @function    ioremap_flags
+
+    @discussion Maps size bytes of device memory at phys with the PTE flags
+    of a memory type.
+
+    @result The linear address of phys, NULL if out of linear addresses or
+    memory for page tables.
+*/
+static void *ioremap_flags(uint32_t phys, uint32_t size, uint32_t flags) {
+    uint32_t offset = phys & (PAGE_SIZE - 1);
+    uint32_t virt = ioremap_next;
+    uint32_t n, i;
+
+    n = (offset + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (size == 0 || n > (IOREMAP_BASE + IOREMAP_SIZE - virt) / PAGE_SIZE)
+        return NULL;
+
+    phys -= offset;
+    for (i = 0; i < n; i++) {
+        if (!paging_map(virt + i * PAGE_SIZE, phys + i * PAGE_SIZE,
+                        flags | PTE_GLOBAL | PTE_WRITE)) {
+            iounmap((void *) virt, i * PAGE_SIZE);
+            return NULL;
+        }
+    }
+    ioremap_next += n * PAGE_SIZE;
+
+    return (void *) (virt + offset);
+}
+
+/*!
+    @function    ioremap
+
+    @discussion Maps device memory uncacheable (UC), e.g. device registers.
+
+    @param    phys    The physical address.
+    @param    size    The size in bytes.
+
+    @result The linear address of phys, NULL on failure.
+*/
+void *ioremap(uint32_t phys, uint32_t size) {
+    return ioremap_flags(phys, size, PTE_UC);
+}
+
+/*!
+    @function    ioremap_wc
+
+    @discussion Maps device memory write combining (WC), e.g. a frame buffer.
+    Writes are buffered and combined into bursts, reads are uncached. UC
+    without PAT.
+
+    @param    phys    The physical address.
+    @param    size    The size in bytes.
+
+    @result The linear address of phys, NULL on failure.
+*/
+void *ioremap_wc(uint32_t phys, uint32_t size) {
+    return ioremap_flags(phys, size, pat_on ? PTE_WC : PTE_UC);
+}
+
+/*!
+    @function    iounmap
+
+    @discussion Unmaps a mapping made by ioremap() or ioremap_wc(). The
+    linear addresses are not reused.
+
+    @param    virt    The linear address returned by ioremap().
+    @param    size    The size passed to ioremap().
+*/
+void iounmap(void *virt, uint32_t size) {
+    uint32_t v = (uint32_t) virt & ~(PAGE_SIZE - 1);
+    uint32_t end = (uint32_t) virt + size;
+    tlb_batch_t b;
+
+    assert(v >= IOREMAP_BASE && end <= IOREMAP_BASE + IOREMAP_SIZE);
+
+    tlb_batch_begin(&b);
+    for (; v < end; v += PAGE_SIZE)
+        paging_unmap(v);
+    tlb_batch_end(&b);
+}
@@ -0,0 +1,60 @@
+#ifndef __IOREMAP_H__
+#define __IOREMAP_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    IOREMAP_BASE, IOREMAP_SIZE
+
+    @discussion The window of linear addresses for ioremap().
+*/
+#define IOREMAP_BASE (0xE0000000)
+#define IOREMAP_SIZE (0x10000000)
+
+/*!
+    @defined    MSR_IA32_PAT
+
+    @discussion The page attribute table MSR.
+*/
+#define MSR_IA32_PAT (0x277)
+
+/*!
+    @typedef    pat_type_t
+
+    @discussion Memory types of the page attribute table.
+    @doc [Table 11-10. Memory Types That Can Be Encoded With PAT]
+         (Intel 64 & IA-32 Arch. SDM Vol.3 Ch.11.12.3)
+
+    @constant    PAT_UC         Strong uncacheable.
+    @constant    PAT_WC         Write combining.
+    @constant    PAT_WT         Write through.
+    @constant    PAT_WP         Write protected.
+    @constant    PAT_WB         Write back.
+    @constant    PAT_UC_MINUS   Uncacheable, can be overridden by an MTRR WC.
+*/
+typedef
+enum _pat_type_t {
+    PAT_UC = 0,
+    PAT_WC = 1,
+    PAT_WT = 4,
+    PAT_WP = 5,
+    PAT_WB = 6,
+    PAT_UC_MINUS = 7
+} pat_type_t;
+
+/*! See .c */
+void pat_init(void);
+
+/*! See .c */
+uint32_t pat_enabled(void);
+
+/*! See .c */
+void *ioremap(uint32_t phys, uint32_t size);
+
+/*! See .c */
+void *ioremap_wc(uint32_t phys, uint32_t size);
+
+/*! See .c */
+void iounmap(void *virt, uint32_t size);
+
+#endif
@@ -8,19 +8,52 @@
 */
 
 
+#include "../drivers/keyboard.h"
+#include "../drivers/pit.h"
 #include "../drivers/screen.h"
+#include "../drivers/serial.h"
 #include "../include/stdint.h"
 #include "../include/stdio.h"
+#include "../include/stdlib.h"
 #include "idt.h"
+#include "apic.h"
+#include "low_level.h"
+#include "boot_timeline.h"
+#include "boot_info.h"
+#include "frame_alloc.h"
+#include "buddy.h"
+#include "paging.h"
+#include "ioremap.h"
+#include "klog.h"
+#include "softirq.h"
 
-extern uint64_t idt[]; // @IMPORTANT Remember the kernel.bin size limit!
+/*!
+    @defined    ISA_DEBUG_EXIT_PORT
+
+    @discussion I/O port of QEMU's isa-debug-exit device, when QEMU is started
+    with `-device isa-debug-exit,iobase=0xf4,iosize=0x04`. Writing a value to
+    it exits QEMU. Used with `make BOOT_EXIT=1`, see testboottime.sh and
+    testboottimeline.sh.
+*/
+#define ISA_DEBUG_EXIT_PORT (0xF4)
+
+extern uint64_t idt[]; // @IMPORTANT Remember the kernel.elf size limit!
 
 /************************** Testing *******************************************/
 #ifdef TEST_MODE
 #include "../tests/test_all.h"
-int main(void) {
+int main(boot_info_t *bi) {
     clear_screen();
     print_at("Edsger Dijkstra!\n", 0, 0);
+    frame_alloc_init(bi);
+    buddy_init(BUDDY_ARENA_FRAMES);
+    kmalloc_init();
+    paging_init();
+    pat_init();
+    screen_map_wc();
+    serial_init(SERIAL_CLOCK);
+    keyboard_init();
+    pit_init(PIT_HZ);
     test_all();
     return 0;
 }
@@ -32,15 +65,42 @@ int main(void) {
 
     @discussion Entry point for the kernel.
 
+    @param    bi    The boot info, see boot_info.h.
+
     @result 0
 */
-int main(void) {
+int main(boot_info_t *bi) {
+    boot_timeline_stamp(BT_MAIN);
     clear_screen();
     print_at("Edsger Dijkstra!\n", 0, 0);
+    boot_info_print(bi);
+    frame_alloc_init(bi);
+    buddy_init(BUDDY_ARENA_FRAMES);
+    kmalloc_init();
+    paging_init();
+    pat_init();
+    screen_map_wc();
+    serial_init(SERIAL_CLOCK);
+    keyboard_init();
+    pit_init(PIT_HZ);
+    pit_clock_event.handler = klog_tick; // Drains the log every tick.
+    print("Free frames: ");
+    print_d(frame_free_count());
+    print("\n");
     init_interrupts();
+    apic_init();
+    boot_timeline_stamp(BT_INIT_INTERRUPTS);
+    boot_timeline_print();
+#ifdef BOOT_EXIT
+    outb(ISA_DEBUG_EXIT_PORT, 0); // Measure boot time up to here.
+#endif
 
-    while(1)
-        ;
+    while(1) { // Idle.
+        softirq_run();
+        // Sleep until the next interrupt. It runs the tasklets it schedules
+        // on its exit, see softirq_irq_exit().
+        __asm__ volatile("sti; hlt" : : : "memory");
+    }
 
 
     return 0;
@@ -5,26 +5,108 @@
 ; kernel binary the kernel's entry point happens to be located.
 ;
 ; @discussion This assembly program is taken from @doc [Writing a Simple
-; Operating System - from Scratch, by Nick Blundell]. Since the boot sector
-; program transfers control to the kernel by jumping to an absolute address.
-; Since we don't have direct control over where the kernel's entry point is
-; placed in the kernel binary, we use this program as a workaround. The only
-; thing this program does is call the kernel's entry point function. It is
-; essential for this program to be compiled in ELF format and for the resulting
-; program to be the first object file in the list of all object files passed to
-; the linker to produce the final kernel binary.
+; Operating System - from Scratch, by Nick Blundell]. Originally the boot sector
+; transferred control to the kernel by jumping to its first byte, which is why
+; this program had to be the first object file passed to the linker. The kernel
+; is now an ELF executable and boot/stage2.s jumps to its ELF entry point, _start,
+; see kernel/linker.ld. _start is placed in the .text.entry section, which the
+; linker script puts first in .text, so the entry point is still easy to find
+; in a disassembly.
 ; e.g. to assemble use:
-; `nasm kernel_entry.asm -f elf -o kernel_entry.o`
+; `nasm kernel_entry.s -I 'boot/' -f elf -o kernel_entry.o`
 ; to link use:
-; `i386-elf-ld -o kernel.bin -Ttext 0x1000 kernel_entry.o kernel.o --oformat
-;  binary`
+; `i386-elf-ld -o kernel.elf -T kernel/linker.ld kernel_entry.o kernel.o`
+
+;
+; The kernel runs on its own stack, KERNEL_STACK_SIZE bytes in .bss, instead of
+; the boot loader's. The boot info structure, see boot/boot_info.s, is passed to
+; main() as its only argument: `int main(boot_info_t *bi)`.
+;
+; The kernel can also be booted by a Multiboot boot loader, e.g.
+; `qemu-system-i386 -kernel kernel.elf`, see `make runqk`. The Multiboot header
+; below is placed at the start of .text by kernel/linker.ld, hence within the
+; first 8 KiB of kernel.elf as the spec requires. The boot loader loads the ELF
+; segments itself. _start tells the two boot paths apart by the magic value in
+; EAX.
+; @doc [Multiboot Spec. 0.6.96, Ch.3.1-3.2](https://www.gnu.org/software/grub/manual/multiboot/multiboot.html)
 
 [bits 32]
 [extern main] ; @doc [NASM extern assembler directive](NASM manual ch.7.5).
+[extern multiboot_boot_info]
+[global _start]
+
+%include "boot_timeline.s"
+%include "boot_info.s"
+
+KERNEL_STACK_SIZE          equ 0x4000 ; 16 KiB.
+
+MULTIBOOT_HEADER_MAGIC     equ 0x1badb002
+MULTIBOOT_PAGE_ALIGN       equ 1 << 0 ; Load modules on 4 KiB boundaries.
+MULTIBOOT_MEMORY_INFO      equ 1 << 1 ; Provide mem_* and mmap_*.
+MULTIBOOT_HEADER_FLAGS     equ MULTIBOOT_PAGE_ALIGN | MULTIBOOT_MEMORY_INFO
+MULTIBOOT_BOOTLOADER_MAGIC equ 0x2badb002 ; Must match kernel/multiboot.h.
+
+section .multiboot progbits alloc noexec nowrite align=4
+
+;!
+; @struct    multiboot_header    The Multiboot header. The magic, flags and
+;                                checksum fields must sum to 0.
+multiboot_header:
+    dd MULTIBOOT_HEADER_MAGIC
+    dd MULTIBOOT_HEADER_FLAGS
+    dd -(MULTIBOOT_HEADER_MAGIC + MULTIBOOT_HEADER_FLAGS)
+
+section .text.entry progbits alloc exec nowrite align=16
+
+;!
+; @procedure    _start    The kernel's ELF entry point, called by stage2 or
+;                         jumped to by a Multiboot boot loader.
+;
+; @register    EAX    BOOT_INFO_MAGIC or MULTIBOOT_BOOTLOADER_MAGIC.
+; @register    EBX    The address of the boot info structure, or of the
+;                     Multiboot information structure.
+;
+; @discussion A Multiboot boot loader leaves the GDTR undefined, hence the
+; kernel loads its own copy of the GDT before it reloads any segment register.
+_start:
+    mov ecx, eax              ; ECX := magic.
+    BOOT_TSC BT_KERNEL_ENTRY  ; Boot timeline, BT_KERNEL_ENTRY. Keeps EBX, ECX.
+
+    mov esp, kernel_stack_top ; Stack init.
+    mov ebp, esp
+
+    cmp ecx, BOOT_INFO_MAGIC
+    je start_main
+    cmp ecx, MULTIBOOT_BOOTLOADER_MAGIC
+    jne $                     ; Infinite loop. Unknown boot loader.
+
+    lgdt [gdt_descriptor]
+    jmp CODE_SEG:multiboot_init
+
+multiboot_init:
+    mov ax, DATA_SEG
+    mov ds, ax
+    mov ss, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    push ebx                  ; EAX := multiboot_boot_info(EBX).
+    call multiboot_boot_info
+    add esp, 4
+    mov ebx, eax
 
-call main
-jmp $
+start_main:
+    push ebx                  ; main(EBX).
+    call main
+    jmp $
 
+section .data progbits alloc noexec write align=8
 
+%include "gdt.s"
 
+section .bss nobits alloc noexec write align=16
 
+kernel_stack:
+    resb KERNEL_STACK_SIZE
+kernel_stack_top:
@@ -0,0 +1,442 @@
+/*!
+    @header Kernel log.
+    A ring buffer of log records, in the style of printk. Producers append
+    records from any context, interrupt handlers included, and never block or
+    touch a device. Consumers, e.g. the VGA console, are passed the records
+    later, by klog_drain().
+
+    @discussion A producer reserves a record with an atomic increment of the
+    next sequence number (lock xadd), hence concurrent producers, e.g. an
+    interrupt handler interrupting a producer, get distinct records without a
+    lock. The record's seq is 0 while it is written and is set to its sequence
+    number + 1 when committed.
+
+    A record keeps the format and the argument words, a cache line, and is
+    formatted by klog_drain(). Writing a record costs a scan of the format
+    for its arguments and a copy of their words, no formatting, no port I/O
+    and no video memory writes. Hence a string argument, %s, must stay valid
+    until the record is drained, e.g. a string literal.
+
+    Each consumer keeps the sequence number of the next record it is passed.
+    klog_drain() passes every consumer the committed records it hasn't seen,
+    then calls its flush, e.g. one screen_flush() for a batch of records. A
+    consumer that falls more than KLOG_RECORDS behind skips the overwritten
+    records and counts them as dropped. A record that is still being written
+    stops the drain until the next one.
+
+    The screen module isn't reentrant and the keyboard tasklet echoes keys to
+    it, hence the log drains as a tasklet too, klog_tasklet, scheduled on
+    every timer tick by klog_tick(). Tasklets never run concurrently, see
+    softirq.c.
+
+    @remark There is a single CPU, hence a single ring. The ring of a CPU is
+    only overwritten by that CPU's producers.
+
+    @doc [printk](https://www.kernel.org/doc/html/latest/core-api/printk-basics.html)
+*/
+
+#include "../drivers/screen.h"
+#include "../include/stdarg.h"
+#include "../include/stdio.h"
+#include "low_level.h"
+#include "softirq.h"
+#include "klog.h"
+
+/*!
+    @typedef    klog_entry_t
+
+    @discussion A record of the ring, not formatted yet.
+
+    @field    seq      The record's sequence number + 1 once the record is
+                       committed, 0 while it is written.
+    @field    level    The klog_level_t.
+    @field    tsc      The TSC when the record was reserved.
+    @field    fmt      The message format.
+    @field    args     The argument words of fmt, see next_conv(). The
+                       words past them are unused.
+*/
+typedef struct _klog_entry_t {
+    volatile uint32_t seq;
+    uint32_t level;
+    uint64_t tsc;
+    const char *fmt;
+    uint32_t args[KLOG_ARGS];
+} __attribute__((aligned(64))) klog_entry_t;
+
+/*!
+    @defined    ARG_NONE, ARG_WORD, ARG_LONG_LONG, ARG_PTR
+
+    @discussion The argument of a conversion, see next_conv(): none (%%), an
+    int or a smaller or same sized integer, a long long, which takes 2 words,
+    a pointer (%s, %p).
+*/
+#define ARG_NONE (0)
+#define ARG_WORD (1)
+#define ARG_LONG_LONG (2)
+#define ARG_PTR (3)
+
+/*!
+    @var    ring
+
+    @discussion The log records. Record seq is at ring[seq % KLOG_RECORDS].
+*/
+static klog_entry_t ring[KLOG_RECORDS];
+
+/*!
+    @var    next_seq
+
+    @discussion The sequence number of the next record to reserve.
+*/
+static volatile uint32_t next_seq;
+
+/*!
+    @function    vga_write
+
+    @discussion Writes a record to the screen, without flushing it.
+*/
+static void vga_write(const klog_record_t *r) {
+    char s[KLOG_MSG_MAX + 32]; // And the TSC and level.
+    int i;
+
+    snprintf(s, sizeof(s), "[%10llu] %c %s\n", r->tsc, "EWID"[r->level],
+             r->msg);
+    for (i = 0; s[i]; i++)
+        print_ch_at(s[i], 0, -1, -1);
+}
+
+/*!
+    @var    klog_vga
+
+    @discussion The VGA console, registered from the start so that records
+    logged before any initialization are seen.
+*/
+klog_consumer_t klog_vga = {
+    "vga", KLOG_DEBUG, vga_write, screen_flush, 0, 0, NULL
+};
+
+/*!
+    @var    consumers
+
+    @discussion The list of consumers, linked through klog_consumer_t.next.
+*/
+static klog_consumer_t *consumers = &klog_vga;
+
+/*!
+    @function    fetch_add
+
+    @discussion Atomically adds v to *p.
+
+    @result The previous value of *p.
+*/
+static inline __attribute__((always_inline))
+uint32_t fetch_add(volatile uint32_t *p, uint32_t v) {
+    __asm__ volatile("lock xaddl %0, %1" : "+r" (v), "+m" (*p) : : "memory");
+    return v;
+}
+
+/*!
+    @function    next_conv
+
+    @discussion Parses the next conversion specification of fmt the way
+    vsnprintf() does, for the arguments it takes: stars int arguments, the
+    '*' width and precision, then the converted value, arg.
+
+    @param    fmt      Where to start, in the format.
+    @param    stars    Returns the number of '*'.
+    @param    arg      Returns the ARG_* of the converted value.
+
+    @result The character after the specification, NULL if there is none.
+*/
+static const char *next_conv(const char *fmt, uint32_t *stars,
+                             uint32_t *arg) {
+    while (*fmt != '%') {
+        if (*fmt++ == '\0')
+            return NULL;
+    }
+    fmt++;
+
+    *stars = 0;
+    while (*fmt == '-' || *fmt == '0' || *fmt == '+' || *fmt == ' ' ||
+           *fmt == '#')
+        fmt++;
+    if (*fmt == '*') {
+        (*stars)++;
+        fmt++;
+    } else {
+        while (*fmt >= '0' && *fmt <= '9')
+            fmt++;
+    }
+    if (*fmt == '.') {
+        if (*++fmt == '*') {
+            (*stars)++;
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9')
+                fmt++;
+        }
+    }
+
+    *arg = ARG_WORD;
+    if (*fmt == 'h') {
+        if (*++fmt == 'h')
+            fmt++;
+    } else if (*fmt == 'l') {
+        if (*++fmt == 'l') {
+            *arg = ARG_LONG_LONG;
+            fmt++;
+        }
+    } else if (*fmt == 'z') {
+        fmt++;
+    }
+
+    switch (*fmt) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        break;
+    case 'c':
+        *arg = ARG_WORD;
+        break;
+    case 'p':
+    case 's':
+        *arg = ARG_PTR;
+        break;
+    case '\0':
+        *arg = ARG_NONE;
+        return fmt; // The next call returns NULL.
+    default:
+        *arg = ARG_NONE;
+    }
+
+    return fmt + 1;
+}
+
+/*!
+    @function    klog
+
+    @discussion Appends a record to the log, see vsnprintf() for the format.
+    Never blocks, callable from interrupt handlers. The message is formatted
+    and passed to the consumers by the next klog_drain(), see the header.
+
+    @param    level    The klog_level_t.
+    @param    fmt      The message format. No '\n' needed. At most KLOG_ARGS
+                       argument words, otherwise the record is a "too many
+                       arguments" message with fmt.
+*/
+void klog(klog_level_t level, const char *fmt, ...) {
+    uint32_t seq, stars, arg, n = 0;
+    unsigned long long v;
+    klog_entry_t *r;
+    const char *p;
+    va_list ap;
+
+    seq = fetch_add(&next_seq, 1);
+    r = &ring[seq & (KLOG_RECORDS - 1)];
+
+    r->seq = 0;
+    r->level = level;
+    r->tsc = read_tsc();
+    r->fmt = fmt;
+
+    // The words of the arguments fmt takes, no more, see format().
+    va_start(ap, fmt);
+    for (p = fmt; (p = next_conv(p, &stars, &arg)) != NULL; ) {
+        if (n + stars + (arg == ARG_LONG_LONG ? 2 : arg != ARG_NONE) >
+            KLOG_ARGS) {
+            r->fmt = "klog: too many arguments: %s";
+            r->args[0] = (uint32_t) fmt;
+            break;
+        }
+        for (; stars; stars--)
+            r->args[n++] = va_arg(ap, int);
+        if (arg == ARG_WORD) {
+            r->args[n++] = va_arg(ap, uint32_t);
+        } else if (arg == ARG_LONG_LONG) {
+            v = va_arg(ap, unsigned long long);
+            r->args[n++] = (uint32_t) v;
+            r->args[n++] = (uint32_t) (v >> 32);
+        } else if (arg == ARG_PTR) {
+            r->args[n++] = (uint32_t) va_arg(ap, const void *);
+        }
+    }
+    va_end(ap);
+
+    __asm__ volatile("" : : : "memory"); // The record before the commit.
+    r->seq = seq + 1;
+}
+
+/*!
+    @function    klog_seq
+
+    @result The sequence number of the next record, i.e. the number of
+    records logged.
+*/
+uint32_t klog_seq(void) {
+    return next_seq;
+}
+
+/*!
+    @function    klog_register_consumer
+
+    @discussion Registers a consumer. Its first klog_drain() passes it the
+    records still in the ring, e.g. the boot messages for a console that
+    starts late.
+
+    @param    c    The consumer. name, max_level, write and flush must be set.
+*/
+void klog_register_consumer(klog_consumer_t *c) {
+    uint32_t head = next_seq;
+
+    c->next_seq = head > KLOG_RECORDS ? head - KLOG_RECORDS : 0;
+    c->dropped = 0;
+    c->next = consumers;
+    consumers = c;
+}
+
+/*!
+    @function    klog_unregister_consumer
+
+    @param    c    A registered consumer.
+*/
+void klog_unregister_consumer(klog_consumer_t *c) {
+    klog_consumer_t **p;
+
+    for (p = &consumers; *p; p = &(*p)->next) {
+        if (*p == c) {
+            *p = c->next;
+            return;
+        }
+    }
+}
+
+/*!
+    @function    format_words
+
+    @discussion Formats a message into s, KLOG_MSG_MAX bytes, see
+    vsnprintf(). The arguments are the argument words of a record: on i386
+    every argument is passed as stack words, a long long as 2, hence
+    vsnprintf() reads them as the arguments klog() was passed.
+
+    @result The length of the message, truncated if it is >= KLOG_MSG_MAX.
+*/
+static int format_words(char *s, const char *fmt, ...) {
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(s, KLOG_MSG_MAX, fmt, ap);
+    va_end(ap);
+
+    return len;
+}
+
+/*!
+    @function    format
+
+    @discussion Formats the record of entry e into rec. All KLOG_ARGS words
+    are passed, fmt only takes those klog() copied.
+*/
+static void format(const klog_entry_t *e, klog_record_t *rec) {
+    const uint32_t *w = e->args;
+    int len;
+
+    rec->seq = e->seq;
+    rec->level = e->level;
+    rec->tsc = e->tsc;
+
+    len = format_words(rec->msg, e->fmt, w[0], w[1], w[2], w[3], w[4], w[5],
+                       w[6], w[7], w[8], w[9], w[10]);
+    rec->len = len < KLOG_MSG_MAX ? len : KLOG_MSG_MAX - 1;
+}
+
+/*!
+    @function    klog_drain
+
+    @discussion Passes every consumer the committed records it hasn't seen, in
+    sequence order, and flushes it. A record is copied before it is formatted
+    and passed, so that a producer can't overwrite it meanwhile. Call from a
+    context where the consumers' devices may be used, e.g. a tasklet, see
+    klog_tasklet.
+*/
+void klog_drain(void) {
+    klog_consumer_t *c;
+    klog_record_t rec;
+    klog_entry_t *r, e;
+    uint32_t head, n;
+
+    for (c = consumers; c; c = c->next) {
+        n = 0;
+
+        while (c->next_seq != (head = next_seq)) {
+            if (head - c->next_seq > KLOG_RECORDS) {
+                c->dropped += head - KLOG_RECORDS - c->next_seq;
+                c->next_seq = head - KLOG_RECORDS;
+            }
+
+            r = &ring[c->next_seq & (KLOG_RECORDS - 1)];
+            if (r->seq != c->next_seq + 1) {
+                if ((int32_t) (r->seq - (c->next_seq + 1)) > 0)
+                    continue;   // Overwritten, skipped above.
+                break;          // Not committed yet.
+            }
+
+            e = *r;
+            if (r->seq != c->next_seq + 1)
+                continue;       // Overwritten while copied.
+
+            c->next_seq++;
+            if (e.level <= c->max_level) {
+                format(&e, &rec);
+                c->write(&rec);
+                n++;
+            }
+        }
+
+        if (n && c->flush)
+            c->flush();
+    }
+}
+
+/*!
+    @function    klog_work
+
+    @discussion The klog tasklet, drains the log.
+
+    @param    ctx    NULL
+*/
+static void klog_work(void *ctx) {
+    if (ctx) { // Suppress warning.
+        ;
+    }
+    klog_drain();
+}
+
+/*!
+    @var    klog_tasklet
+
+    @discussion Drains the log from a tasklet, never while another tasklet,
+    e.g. keyboard_tasklet, writes to the screen. Scheduled by klog_tick().
+*/
+tasklet_t klog_tasklet = {
+    klog_work, NULL, 0, 0, 0, NULL
+};
+
+/*!
+    @function    klog_tick
+
+    @discussion A clock event handler, see clock_event.h, that schedules
+    klog_tasklet. Installed on the tick by main(), the log is drained once per
+    tick, on the exit of the timer interrupt, rather than by a busy idle
+    loop.
+
+    @param    ctx    Unused.
+*/
+void klog_tick(void *ctx) {
+    if (ctx) { // Suppress warning.
+        ;
+    }
+    tasklet_schedule(&klog_tasklet);
+}
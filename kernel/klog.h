@@ -0,0 +1,120 @@
+#ifndef __KLOG_H__
+#define __KLOG_H__
+
+#include "../include/stdint.h"
+#include "softirq.h"
+
+/*!
+    @defined    KLOG_RECORDS
+
+    @discussion The number of records of the log ring, a power of 2. The
+    oldest records are overwritten.
+*/
+#define KLOG_RECORDS (256)
+
+/*!
+    @defined    KLOG_ARGS
+
+    @discussion The number of argument words of klog() kept by the ring, a
+    long long takes 2. Sized so that an entry of the ring is a cache line.
+    format() in klog.c passes this many words.
+*/
+#define KLOG_ARGS (11)
+
+/*!
+    @defined    KLOG_MSG_MAX
+
+    @discussion The size of a formatted message. Longer messages are
+    truncated.
+*/
+#define KLOG_MSG_MAX (240)
+
+/*!
+    @typedef    klog_level_t
+
+    @discussion Log levels, the most severe first.
+
+    @constant    KLOG_ERR      An error.
+    @constant    KLOG_WARN     Something unexpected that was handled.
+    @constant    KLOG_INFO     Informational.
+    @constant    KLOG_DEBUG    Debugging output.
+*/
+typedef
+enum _klog_level_t {
+    KLOG_ERR,
+    KLOG_WARN,
+    KLOG_INFO,
+    KLOG_DEBUG
+} klog_level_t;
+
+/*!
+    @typedef    klog_record_t
+
+    @discussion A log record, as passed to the consumers. Formatted by
+    klog_drain().
+
+    @field    seq      The record's sequence number + 1.
+    @field    level    The klog_level_t.
+    @field    len      The message length, without the '\0'.
+    @field    tsc      The TSC when the record was reserved.
+    @field    msg      The message, '\0' terminated.
+*/
+typedef struct _klog_record_t {
+    volatile uint32_t seq;
+    uint16_t level;
+    uint16_t len;
+    uint64_t tsc;
+    char msg[KLOG_MSG_MAX];
+} klog_record_t;
+
+/*!
+    @typedef    klog_consumer_t
+
+    @discussion A consumer of the log, e.g. a console. See
+    klog_register_consumer().
+
+    @field    name         The consumer's name. Not copied.
+    @field    max_level    The least severe level the consumer is passed.
+    @field    write        Called with each record, in sequence order.
+    @field    flush        Called after a batch of records, NULL if none.
+    @field    next_seq     The sequence number of the next record to pass.
+    @field    dropped      The number of records overwritten before they
+                           were passed.
+    @field    next         The next consumer.
+*/
+typedef struct _klog_consumer_t {
+    const char *name;
+    klog_level_t max_level;
+    void (*write)(const klog_record_t *r);
+    void (*flush)(void);
+    uint32_t next_seq;
+    uint32_t dropped;
+    struct _klog_consumer_t *next;
+} klog_consumer_t;
+
+/*! See .c */
+extern klog_consumer_t klog_vga;
+
+/*! See .c */
+extern tasklet_t klog_tasklet;
+
+/*! See .c */
+void klog(klog_level_t level, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/*! See .c */
+uint32_t klog_seq(void);
+
+/*! See .c */
+void klog_register_consumer(klog_consumer_t *c);
+
+/*! See .c */
+void klog_unregister_consumer(klog_consumer_t *c);
+
+/*! See .c */
+void klog_drain(void);
+
+/*! See .c */
+void klog_tick(void *ctx);
+
+#endif
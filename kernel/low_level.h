@@ -9,4 +9,61 @@ uint8_t inb (uint16_t port);
 /*! See .s */
 void outb (uint16_t port, uint8_t data);
 
+/*! See .s */
+uint64_t read_tsc (void);
+
+/*!
+    @typedef    cpuid_regs_t
+
+    @discussion The registers returned by the CPUID instruction.
+*/
+typedef struct _cpuid_regs_t {
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+} cpuid_regs_t;
+
+/*! See .s */
+uint32_t read_cr0 (void);
+
+/*! See .s */
+uint32_t read_cr2 (void);
+
+/*! See .s */
+uint32_t read_cr3 (void);
+
+/*! See .s */
+uint32_t read_cr4 (void);
+
+/*! See .s */
+void write_cr0 (uint32_t value);
+
+/*! See .s */
+void write_cr3 (uint32_t value);
+
+/*! See .s */
+void write_cr4 (uint32_t value);
+
+/*! See .s */
+void invlpg (uint32_t addr);
+
+/*! See .s */
+void cpuid (uint32_t leaf, cpuid_regs_t *regs);
+
+/*! See .s */
+uint64_t rdmsr (uint32_t msr);
+
+/*! See .s */
+void wrmsr (uint32_t msr, uint64_t value);
+
+/*! See .s */
+void wbinvd (void);
+
+/*! See .s */
+uint32_t irq_save (void);
+
+/*! See .s */
+void irq_restore (uint32_t flags);
+
 #endif
\ No newline at end of file
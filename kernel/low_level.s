@@ -42,4 +42,204 @@ outb:
     out dx, al             ; port# -> reg.
     mov esp, ebp
     pop ebp
-    ret
\ No newline at end of file
+    ret
+
+;     @function    read_tsc
+;
+;     @discussion C wrapper for the `rdtsc` instruction. Returns the 64-bit
+;     time stamp counter (TSC). A 64-bit return value is passed in EDX:EAX,
+;     which is exactly where RDTSC puts the TSC.
+;     @doc [RDTSC](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
+;
+; @stack  [esp    ]  EIP
+;
+global read_tsc
+read_tsc:
+    rdtsc                  ; EDX:EAX := TSC.
+    ret
+
+;     @function    read_cr0, read_cr2, read_cr3, read_cr4
+;
+;     @discussion C wrappers for reading the control registers.
+;     @doc [Control Registers](Intel 64 & IA-32 Arch. SDM Vol.3 Ch.2.5)
+;
+; @stack  [esp    ]  EIP
+;
+global read_cr0
+read_cr0:
+    mov eax, cr0
+    ret
+
+global read_cr2
+read_cr2:
+    mov eax, cr2
+    ret
+
+global read_cr3
+read_cr3:
+    mov eax, cr3
+    ret
+
+global read_cr4
+read_cr4:
+    mov eax, cr4
+    ret
+
+;     @function    write_cr0, write_cr3, write_cr4
+;
+;     @discussion C wrappers for writing the control registers. Writing CR3
+;     flushes the TLB entries of non-global pages.
+;
+;     @param    value    The value to write.
+;
+; @stack  [esp + 4]  @param value
+;         [esp    ]  EIP
+;
+global write_cr0
+write_cr0:
+    mov eax, [esp + 4]
+    mov cr0, eax
+    ret
+
+global write_cr3
+write_cr3:
+    mov eax, [esp + 4]
+    mov cr3, eax
+    ret
+
+global write_cr4
+write_cr4:
+    mov eax, [esp + 4]
+    mov cr4, eax
+    ret
+
+;     @function    invlpg
+;
+;     @discussion C wrapper for the `invlpg` instruction. Invalidates the TLB
+;     entries of the page that contains addr.
+;     @doc [INVLPG](Intel 64 & IA-32 Arch. SDM Vol.2A Ch.3.3)
+;
+;     @param    addr    A linear address.
+;
+; @stack  [esp + 4]  @param addr
+;         [esp    ]  EIP
+;
+global invlpg
+invlpg:
+    mov eax, [esp + 4]
+    invlpg [eax]
+    ret
+
+;     @function    cpuid
+;
+;     @discussion C wrapper for the `cpuid` instruction, with ECX = 0.
+;     @doc [CPUID](Intel 64 & IA-32 Arch. SDM Vol.2A Ch.3.2)
+;
+;     @param    leaf    The value of EAX, the CPUID leaf.
+;     @param    regs    Where to store EAX, EBX, ECX and EDX, a cpuid_regs_t.
+;
+; @stack  [esp + 12] @param regs
+;         [esp + 8]  @param leaf
+;         [esp + 4]  EIP
+;         [esp    ]  EBP
+;
+global cpuid
+cpuid:
+    push ebp
+    mov ebp, esp
+    push ebx               ; EBX and EDI are callee saved.
+    push edi
+    mov eax, [ebp + 8]
+    xor ecx, ecx
+    cpuid
+    mov edi, [ebp + 12]
+    mov [edi], eax
+    mov [edi + 4], ebx
+    mov [edi + 8], ecx
+    mov [edi + 12], edx
+    pop edi
+    pop ebx
+    mov esp, ebp
+    pop ebp
+    ret
+
+;     @function    rdmsr
+;
+;     @discussion C wrapper for the `rdmsr` instruction. Returns the 64-bit
+;     model specific register in EDX:EAX, which is exactly where RDMSR puts it.
+;     @doc [RDMSR](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
+;
+;     @param    msr    The MSR address.
+;
+; @stack  [esp + 4]  @param msr
+;         [esp    ]  EIP
+;
+global rdmsr
+rdmsr:
+    mov ecx, [esp + 4]
+    rdmsr                  ; EDX:EAX := MSR[ECX].
+    ret
+
+;     @function    wrmsr
+;
+;     @discussion C wrapper for the `wrmsr` instruction.
+;     @doc [WRMSR](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
+;
+;     @param    msr      The MSR address.
+;     @param    value    The 64-bit value to write.
+;
+; @stack  [esp + 12] @param value, high dword
+;         [esp + 8]  @param value, low dword
+;         [esp + 4]  @param msr
+;         [esp    ]  EIP
+;
+global wrmsr
+wrmsr:
+    mov ecx, [esp + 4]
+    mov eax, [esp + 8]
+    mov edx, [esp + 12]
+    wrmsr                  ; MSR[ECX] := EDX:EAX.
+    ret
+
+;     @function    wbinvd
+;
+;     @discussion C wrapper for the `wbinvd` instruction. Writes back the
+;     modified cache lines and invalidates the caches.
+;     @doc [WBINVD](Intel 64 & IA-32 Arch. SDM Vol.2D Ch.6.1)
+;
+; @stack  [esp    ]  EIP
+;
+global wbinvd
+wbinvd:
+    wbinvd
+    ret
+
+;     @function    irq_save
+;
+;     @discussion Disables interrupts and returns the EFLAGS value from
+;     before, for irq_restore(). Nests, unlike a bare cli/sti pair.
+;     @doc [PUSHF/PUSHFD](Intel 64 & IA-32 Arch. SDM Vol.2B Ch.4.3)
+;
+; @stack  [esp    ]  EIP
+;
+global irq_save
+irq_save:
+    pushfd
+    pop eax                ; EAX := EFLAGS.
+    cli
+    ret
+
+;     @function    irq_restore
+;
+;     @discussion Restores EFLAGS, hence IF, to a value saved by irq_save().
+;
+;     @param    flags    The value returned by irq_save().
+;
+; @stack  [esp + 4]  @param flags
+;         [esp    ]  EIP
+;
+global irq_restore
+irq_restore:
+    push dword [esp + 4]
+    popfd                  ; EFLAGS := flags.
+    ret
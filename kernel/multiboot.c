@@ -0,0 +1,114 @@
+/*!
+    @header Multiboot support.
+    The kernel can be booted by a Multiboot boot loader instead of
+    boot/stage2.s, e.g. with `qemu -kernel kernel.elf`, which skips the BIOS
+    floppy emulation and the real mode boot code. The Multiboot header is in
+    kernel/kernel_entry.s. On entry from a Multiboot boot loader, kernel_entry.s
+    calls multiboot_boot_info() to convert the Multiboot information into the
+    boot info structure main() expects.
+
+    @doc [Multiboot Spec. 0.6.96](https://www.gnu.org/software/grub/manual/multiboot/multiboot.html)
+*/
+
+#include "multiboot.h"
+#include "boot_timeline.h"
+
+/*!
+    @var    multiboot_bi
+
+    @discussion The boot info converted from the Multiboot information. Unlike
+    boot/stage2.s, the boot info is not at BOOT_INFO_ADDR, the boot loader may
+    have placed its own data there.
+*/
+static boot_info_t multiboot_bi;
+
+/*!
+    @function    mmap_add
+
+    @discussion Appends a memory map entry to the boot info. Drops the entry if
+    the memory map is full.
+
+    @param    bi        The boot info.
+    @param    base      The address of the first byte of the range.
+    @param    length    The size of the range in bytes.
+    @param    type      The range type, one of e820_type_t.
+*/
+static void mmap_add(boot_info_t *bi, uint64_t base, uint64_t length,
+                     uint32_t type) {
+    e820_entry_t *e;
+
+    if (bi->mmap_len >= BOOT_INFO_MMAP_MAX || length == 0)
+        return;
+
+    e = &bi->mmap[bi->mmap_len++];
+    e->base = base;
+    e->length = length;
+    e->type = type;
+    e->acpi = 1;
+}
+
+/*!
+    @function    multiboot_to_boot_info
+
+    @discussion Converts the Multiboot information into a boot info structure.
+    The memory map is copied from the Multiboot memory map. If there is none, it
+    is built from mem_lower and mem_upper. The boot drive is
+    BOOT_INFO_DRIVE_NONE unless the boot loader reports one. Up to
+    BOOT_INFO_MODS_MAX modules are kept.
+
+    @param    mbi    The Multiboot information.
+    @param    bi     The boot info to fill in.
+*/
+void multiboot_to_boot_info(const multiboot_info_t *mbi, boot_info_t *bi) {
+    const multiboot_mmap_entry_t *e;
+    const multiboot_module_t *m;
+    uint32_t addr;
+    uint32_t i;
+
+    bi->boot_drive = BOOT_INFO_DRIVE_NONE;
+    bi->mmap_len = 0;
+    bi->mods_len = 0;
+
+    if (mbi->flags & MULTIBOOT_INFO_BOOTDEV)
+        bi->boot_drive = mbi->boot_device >> 24;
+
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        addr = mbi->mmap_addr;
+        while (addr < mbi->mmap_addr + mbi->mmap_length) {
+            e = (const multiboot_mmap_entry_t *) addr;
+            mmap_add(bi, e->base, e->length, e->type);
+            addr += e->size + sizeof(e->size);
+        }
+    } else if (mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        mmap_add(bi, 0, (uint64_t) mbi->mem_lower << 10, E820_USABLE);
+        mmap_add(bi, 0x100000, (uint64_t) mbi->mem_upper << 10, E820_USABLE);
+    }
+
+    if (mbi->flags & MULTIBOOT_INFO_MODS) {
+        m = (const multiboot_module_t *) mbi->mods_addr;
+        for (i = 0; i < mbi->mods_count && i < BOOT_INFO_MODS_MAX; i++) {
+            bi->mods[i].start = m[i].start;
+            bi->mods[i].end = m[i].end;
+            bi->mods[i].cmdline = m[i].cmdline;
+        }
+        bi->mods_len = i;
+    }
+}
+
+/*!
+    @function    multiboot_boot_info
+
+    @discussion Called by kernel_entry.s on entry from a Multiboot boot loader.
+    Converts the Multiboot information, and clears the boot timeline slots of
+    the boot stages that did not run.
+
+    @param    mbi    The Multiboot information, EBX on entry.
+
+    @result The boot info to pass to main().
+*/
+boot_info_t *multiboot_boot_info(const multiboot_info_t *mbi) {
+    boot_timeline_clear(BT_KERNEL_ENTRY);
+    multiboot_to_boot_info(mbi, &multiboot_bi);
+
+    return &multiboot_bi;
+}
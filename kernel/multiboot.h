@@ -0,0 +1,87 @@
+#ifndef __MULTIBOOT_H__
+#define __MULTIBOOT_H__
+
+#include "../include/stdint.h"
+#include "boot_info.h"
+
+/*!
+    @defined    MULTIBOOT_BOOTLOADER_MAGIC
+
+    @discussion The value of EAX at the kernel's entry point when the kernel is
+    loaded by a Multiboot boot loader, e.g. `qemu -kernel` or GRUB. EBX is then
+    the physical address of a multiboot_info_t. Must match
+    kernel/kernel_entry.s.
+*/
+#define MULTIBOOT_BOOTLOADER_MAGIC (0x2BADB002)
+
+/*!
+    @typedef    multiboot_info_flags_t
+
+    @discussion The bits of multiboot_info_t.flags that tell which fields are
+    valid. Only the fields used by the kernel are listed.
+
+    @constant   MULTIBOOT_INFO_MEMORY         mem_lower and mem_upper.
+    @constant   MULTIBOOT_INFO_BOOTDEV        boot_device.
+    @constant   MULTIBOOT_INFO_MODS           mods_count and mods_addr.
+    @constant   MULTIBOOT_INFO_MEM_MAP        mmap_length and mmap_addr.
+*/
+typedef
+enum _multiboot_info_flags_t {
+    MULTIBOOT_INFO_MEMORY  = 1 << 0,
+    MULTIBOOT_INFO_BOOTDEV = 1 << 1,
+    MULTIBOOT_INFO_MODS    = 1 << 3,
+    MULTIBOOT_INFO_MEM_MAP = 1 << 6
+} multiboot_info_flags_t;
+
+/*!
+    @typedef    multiboot_info_t
+
+    @discussion The Multiboot information structure, see the Multiboot Spec.
+    0.6.96, Ch.3.3. Only the fields up to the memory map are declared.
+*/
+typedef struct _multiboot_info_t {
+    uint32_t flags;
+    uint32_t mem_lower;    // KiB of memory from address 0.
+    uint32_t mem_upper;    // KiB of memory from address 1 MiB.
+    uint32_t boot_device;  // Bits 31:24 are the BIOS drive number.
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;    // Address of mods_count multiboot_module_t.
+    uint32_t syms[4];
+    uint32_t mmap_length;  // Size of the memory map buffer in bytes.
+    uint32_t mmap_addr;    // Address of the memory map buffer.
+} __attribute__((packed)) multiboot_info_t;
+
+/*!
+    @typedef    multiboot_mmap_entry_t
+
+    @discussion A Multiboot memory map entry. The size field does not count
+    itself, the next entry is at (address of size) + size + 4. type has the same
+    values as e820_type_t.
+*/
+typedef struct _multiboot_mmap_entry_t {
+    uint32_t size;
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;
+} __attribute__((packed)) multiboot_mmap_entry_t;
+
+/*!
+    @typedef    multiboot_module_t
+
+    @discussion A Multiboot module list entry.
+*/
+typedef struct _multiboot_module_t {
+    uint32_t start;
+    uint32_t end;
+    uint32_t cmdline;
+    uint32_t reserved;
+} __attribute__((packed)) multiboot_module_t;
+
+/*! See .c */
+void multiboot_to_boot_info(const multiboot_info_t *mbi, boot_info_t *bi);
+
+/*! See .c */
+boot_info_t *multiboot_boot_info(const multiboot_info_t *mbi);
+
+#endif
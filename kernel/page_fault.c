@@ -0,0 +1,216 @@
+/*!
+    @header Page fault (#PF) handler.
+    Demand-zero paging: lazy regions reserve ranges of linear addresses
+    without committing memory. The first access to a page of a region takes a
+    not-present page fault, the handler maps a zeroed frame and returns, and
+    the CPU retries the faulting instruction.
+
+    @discussion A page fault is a fault, the saved EIP points to the faulting
+    instruction. CR2 holds the faulting linear address. Any other page fault
+    is a kernel bug, the handler prints the decoded error code and asserts.
+
+    @doc [Page-Fault Exceptions](Intel 64 & IA-32 Arch. SDM Vol.3 Ch.4.7)
+    @doc [Interrupt 14—Page-Fault Exception (#PF)]
+         (Intel 64 & IA-32 Arch. SDM Vol.3 Ch.6.15)
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/string.h"
+#include "frame_alloc.h"
+#include "low_level.h"
+#include "paging.h"
+#include "slab.h"
+#include "page_fault.h"
+
+/*!
+    @var    lazy_regions
+
+    @discussion The lazy regions. A region is unused if its end is 0.
+*/
+static lazy_region_t lazy_regions[LAZY_REGIONS_MAX];
+
+/*!
+    @var    pf_count
+
+    @discussion The number of page faults, demand-zero or not.
+*/
+static uint32_t pf_count;
+
+/*!
+    @function    lazy_region_find
+
+    @result The region that contains addr, NULL if none.
+*/
+static lazy_region_t *lazy_region_find(uint32_t addr) {
+    uint32_t i;
+
+    for (i = 0; i < LAZY_REGIONS_MAX; i++) {
+        if (addr >= lazy_regions[i].start && addr < lazy_regions[i].end)
+            return &lazy_regions[i];
+    }
+
+    return NULL;
+}
+
+/*!
+    @function    lazy_region_register
+
+    @discussion Registers a lazy region. The range must not be mapped, and
+    must not overlap another region.
+
+    @param    name     The region's name, for statistics. Must outlive the
+                       region.
+    @param    start    The first address, page aligned.
+    @param    size     The size in bytes, a multiple of PAGE_SIZE.
+    @param    flags    The PTE_* flags of the pages, e.g. PTE_WRITE.
+
+    @result The region, to read its counters, NULL if all regions are in use.
+*/
+const lazy_region_t *lazy_region_register(const char *name, uint32_t start,
+                                          uint32_t size, uint32_t flags) {
+    lazy_region_t *r = NULL;
+    uint32_t i;
+
+    assert(((start | size) & (PAGE_SIZE - 1)) == 0 && size > 0);
+
+    for (i = 0; i < LAZY_REGIONS_MAX; i++) {
+        assert(lazy_regions[i].end == 0 || start >= lazy_regions[i].end ||
+               start + size <= lazy_regions[i].start);
+        if (r == NULL && lazy_regions[i].end == 0)
+            r = &lazy_regions[i];
+    }
+    if (r == NULL)
+        return NULL;
+
+    r->name = name;
+    r->start = start;
+    r->end = start + size;
+    r->flags = flags;
+    r->faults = 0;
+
+    return r;
+}
+
+/*!
+    @function    lazy_region_release
+
+    @discussion Unmaps the committed pages of a region, returns their frames
+    to the frame allocator and unregisters the region.
+
+    @param    r    The region.
+
+    @result The number of frames returned.
+*/
+uint32_t lazy_region_release(const lazy_region_t *r) {
+    lazy_region_t *lr = (lazy_region_t *) r;
+    uint32_t addr, phys, n = 0;
+
+    for (addr = lr->start; addr < lr->end; addr += PAGE_SIZE) {
+        phys = paging_translate(addr);
+        if (phys == PAGING_NONE)
+            continue;
+        paging_unmap(addr);
+        frame_free(phys);
+        n++;
+    }
+
+    lr->end = 0;
+    lr->start = 0;
+
+    return n;
+}
+
+/*!
+    @function    page_fault_count
+
+    @result The number of page faults so far.
+*/
+uint32_t page_fault_count(void) {
+    return pf_count;
+}
+
+/*!
+    @function    page_fault_print_stats
+
+    @discussion Prints the range and fault counter of each lazy region.
+*/
+void page_fault_print_stats(void) {
+    uint32_t i;
+
+    print("Page faults: ");
+    print_d(pf_count);
+    print("\n");
+
+    for (i = 0; i < LAZY_REGIONS_MAX; i++) {
+        if (lazy_regions[i].end == 0)
+            continue;
+        print(lazy_regions[i].name);
+        print(" ");
+        print_x32(lazy_regions[i].start);
+        print("-");
+        print_x32(lazy_regions[i].end);
+        print(" faults ");
+        print_d(lazy_regions[i].faults);
+        print("\n");
+    }
+}
+
+/*!
+    @function    page_fault_print
+
+    @discussion Prints the faulting address and the decoded error code.
+*/
+static void page_fault_print(uint32_t addr, uint32_t err_code) {
+    print("Page fault at ");
+    print_x32(addr);
+    print(err_code & PF_PRESENT ? ": protection violation, " :
+                                  ": page not present, ");
+    print(err_code & PF_FETCH ? "fetch, " :
+          err_code & PF_WRITE ? "write, " : "read, ");
+    print(err_code & PF_USER ? "user" : "supervisor");
+    if (err_code & PF_RSVD)
+        print(", reserved bit set");
+    print("\n");
+}
+
+/*!
+    @function    v14_handler
+
+    @discussion Page fault (#PF) handler. Maps a zeroed frame for a
+    not-present fault inside a lazy region. Under memory pressure the empty
+    slabs are reaped before giving up.
+
+    @param    vn          14.
+    @param    err_code    The page fault error code, PF_* bits.
+    @param    ctx         NULL.
+*/
+void v14_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    uint32_t addr = read_cr2();
+    lazy_region_t *r;
+    uint32_t frame;
+
+    if (vn || ctx) { // Suppress warning.
+        ;
+    }
+    pf_count++;
+
+    r = lazy_region_find(addr);
+    if (r && (err_code & (PF_PRESENT | PF_RSVD)) == 0) {
+        frame = frame_alloc();
+        if (frame == FRAME_NONE && kmem_cache_reap() > 0)
+            frame = frame_alloc();
+        if (frame != FRAME_NONE) {
+            memset((void *) frame, 0, PAGE_SIZE);  // Through the identity map.
+            if (paging_map(addr & ~(PAGE_SIZE - 1), frame, r->flags)) {
+                r->faults++;
+                return;                             // Retry the access.
+            }
+            frame_free(frame);
+        }
+        print("Page fault: out of memory.\n");
+    }
+
+    page_fault_print(addr, err_code);
+    assert(0);
+}
@@ -0,0 +1,69 @@
+#ifndef __PAGE_FAULT_H__
+#define __PAGE_FAULT_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    LAZY_REGIONS_MAX
+
+    @discussion The maximum number of lazy regions.
+*/
+#define LAZY_REGIONS_MAX (16)
+
+/*!
+    @defined    PF_PRESENT ... PF_FETCH
+
+    @discussion Page fault error code bits.
+    @doc [Figure 4-12. Page-Fault Error Code](Intel 64 & IA-32 Arch. SDM Vol.3
+         Ch.4.7)
+
+    @constant    PF_PRESENT    0 = non-present page, 1 = protection violation.
+    @constant    PF_WRITE      0 = read, 1 = write.
+    @constant    PF_USER       0 = supervisor mode, 1 = user mode access.
+    @constant    PF_RSVD       A reserved bit is set in a paging entry.
+    @constant    PF_FETCH      The access was an instruction fetch.
+*/
+#define PF_PRESENT (0x01)
+#define PF_WRITE   (0x02)
+#define PF_USER    (0x04)
+#define PF_RSVD    (0x08)
+#define PF_FETCH   (0x10)
+
+/*!
+    @typedef    lazy_region_t
+
+    @discussion A range of linear addresses that is backed by memory on first
+    touch. A not-present page fault inside the region maps a zeroed frame.
+
+    @field    name      The region's name, for statistics. Not copied.
+    @field    start     The first address, page aligned.
+    @field    end       One past the last address, page aligned. 0 for an
+                        unused region.
+    @field    flags     The PTE_* flags of the pages.
+    @field    faults    The number of pages committed by page faults.
+*/
+typedef struct _lazy_region_t {
+    const char *name;
+    uint32_t start;
+    uint32_t end;
+    uint32_t flags;
+    uint32_t faults;
+} lazy_region_t;
+
+/*! See .c */
+const lazy_region_t *lazy_region_register(const char *name, uint32_t start,
+                                          uint32_t size, uint32_t flags);
+
+/*! See .c */
+uint32_t lazy_region_release(const lazy_region_t *r);
+
+/*! See .c */
+uint32_t page_fault_count(void);
+
+/*! See .c */
+void page_fault_print_stats(void);
+
+/*! See .c */
+void v14_handler(uint32_t vn, uint32_t err_code, void *ctx);
+
+#endif
@@ -0,0 +1,467 @@
+/*!
+    @header Paging.
+    32-bit paging with a single page directory. paging_init() identity maps
+    the RAM of the frame pool, including the kernel and low memory, with
+    4 MiB pages (PSE), and enables paging. The identity map keeps every
+    physical address a valid pointer, hence the frame, buddy and slab
+    allocators work the same with paging on or off.
+
+    @discussion A 4 MiB page takes a single TLB entry, the kernel image, its
+    stack and the low memory fit in the first one. Finer mappings use 4 KiB
+    pages: paging_map() allocates the page table of an unmapped 4 MiB region
+    from the frame allocator, and splits a 4 MiB page into a page table with
+    the same mapping and flags if the region is a large page.
+
+    Without PSE (CPUID.01H:EDX[bit 3]) the identity map is built from page
+    tables instead.
+
+    With PGE (CPUID.01H:EDX[bit 13]) the identity map is global, its TLB
+    entries survive CR3 reloads, e.g. on a context switch. Changed mappings
+    are invalidated with INVLPG, right away or batched: between
+    tlb_batch_begin() and tlb_batch_end() paging_map() and paging_unmap()
+    only record the addresses, and tlb_batch_end() issues one INVLPG per page
+    for small batches and a single full flush past TLB_FLUSH_CEILING pages.
+    A mapping that becomes present needs no invalidation, the TLB does not
+    cache not-present entries.
+
+    @doc [32-Bit Paging](Intel 64 & IA-32 Arch. SDM Vol.3 Ch.4.3)
+    @doc [Invalidation of TLBs and Paging-Structure Caches]
+         (Intel 64 & IA-32 Arch. SDM Vol.3 Ch.4.10.4)
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/string.h"
+#include "frame_alloc.h"
+#include "low_level.h"
+#include "paging.h"
+
+/*!
+    @defined    CR0_PG, CR4_PSE
+
+    @discussion Control register bits. CR0.PG enables paging, CR4.PSE enables
+    4 MiB pages.
+*/
+#define CR0_PG (0x80000000)
+#define CR4_PSE (0x10)
+#define CR4_PGE (0x80)
+
+/*!
+    @defined    CPUID_EDX_PSE, CPUID_EDX_PGE
+
+    @discussion CPUID.01H:EDX[bit 3], 4 MiB pages are supported.
+    CPUID.01H:EDX[bit 13], global pages are supported.
+*/
+#define CPUID_EDX_PSE (1U << 3)
+#define CPUID_EDX_PGE (1U << 13)
+
+/*!
+    @defined    PDE_INDEX(v), PTE_INDEX(v)
+
+    @discussion The page directory and page table index of a linear address.
+*/
+#define PDE_INDEX(v) ((v) >> 22)
+#define PTE_INDEX(v) (((v) >> 12) & (PAGE_ENTRIES - 1))
+
+/*!
+    @defined    PTE_ADDR_MASK, PDE_LARGE_ADDR_MASK
+
+    @discussion The address bits of a page table entry or of a page
+    directory entry that references a page table, and of a 4 MiB page
+    directory entry.
+*/
+#define PTE_ADDR_MASK (0xFFFFF000)
+#define PDE_LARGE_ADDR_MASK (0xFFC00000)
+
+/*!
+    @defined    PTE_INHERIT
+
+    @discussion The flags a page table entry inherits from the 4 MiB page it
+    is split from.
+*/
+#define PTE_INHERIT (PTE_PRESENT | PTE_WRITE | PTE_USER | PTE_PWT | PTE_PCD | \
+                     PTE_GLOBAL)
+
+/*!
+    @var    kernel_pd
+
+    @discussion The page directory.
+*/
+static uint32_t kernel_pd[PAGE_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+
+/*!
+    @var    tlb_counters
+
+    @discussion The TLB invalidation counters, see tlb_stats().
+*/
+static tlb_stats_t tlb_counters;
+
+/*!
+    @var    tlb_batch
+
+    @discussion The batch between tlb_batch_begin() and tlb_batch_end(), NULL
+    if none.
+*/
+static tlb_batch_t *tlb_batch;
+
+/*!
+    @function    pt_alloc
+
+    @discussion Allocates a zeroed page table.
+
+    @result The page table, NULL if out of memory.
+*/
+static uint32_t *pt_alloc(void) {
+    uint32_t addr = frame_alloc();
+
+    if (addr == FRAME_NONE)
+        return NULL;
+    memset((void *) addr, 0, PAGE_SIZE);
+
+    return (uint32_t *) addr;
+}
+
+/*!
+    @function    tlb_invalidate
+
+    @discussion Invalidates the TLB entry of the page at virt, or adds it to
+    the current batch.
+
+    @param    virt      The linear address.
+    @param    global    1 if the old mapping was global.
+*/
+static void tlb_invalidate(uint32_t virt, uint32_t global) {
+    tlb_batch_t *b = tlb_batch;
+
+    if (b) {
+        if (b->n < TLB_FLUSH_CEILING)
+            b->addr[b->n] = virt;
+        b->n++;
+        b->global |= global != 0;
+    } else if (paging_enabled()) {
+        invlpg(virt);
+        tlb_counters.invlpg++;
+    }
+}
+
+/*!
+    @function    pt_split
+
+    @discussion Replaces the 4 MiB page of page directory entry pdi with a
+    page table of 4 KiB pages with the same mapping and flags.
+
+    @result The page table, NULL if out of memory.
+*/
+static uint32_t *pt_split(uint32_t pdi) {
+    uint32_t pde = kernel_pd[pdi];
+    uint32_t flags = pde & PTE_INHERIT;
+    uint32_t *pt, i;
+
+    if (pde & PDE_PAT)
+        flags |= PTE_PAT;
+
+    pt = pt_alloc();
+    if (pt == NULL)
+        return NULL;
+
+    for (i = 0; i < PAGE_ENTRIES; i++)
+        pt[i] = ((pde & PDE_LARGE_ADDR_MASK) + i * PAGE_SIZE) | flags;
+
+    kernel_pd[pdi] = (uint32_t) pt | (pde & (PTE_WRITE | PTE_USER)) |
+                     PTE_PRESENT;
+    tlb_flush_global();     // The 4 MiB page may be global.
+
+    return pt;
+}
+
+/*!
+    @function    paging_init
+
+    @discussion Identity maps the RAM of the frame pool, rounded up to 4 MiB,
+    loads the page directory and enables paging. The identity map is global
+    if the CPU supports it. Call after frame_alloc_init().
+*/
+void paging_init(void) {
+    uint64_t end = (uint64_t) frame_count() << FRAME_SHIFT;
+    uint32_t pdes, i, j, *pt, global = 0;
+    cpuid_regs_t r;
+
+    pdes = (end + PAGE_LARGE_SIZE - 1) / PAGE_LARGE_SIZE;
+    if (pdes > PAGE_ENTRIES)
+        pdes = PAGE_ENTRIES;
+
+    cpuid(1, &r);
+    if (r.edx & CPUID_EDX_PGE)
+        global = PTE_GLOBAL;
+
+    for (i = 0; i < pdes; i++) {
+        if (r.edx & CPUID_EDX_PSE) {
+            kernel_pd[i] = (i * PAGE_LARGE_SIZE) | PTE_PS | global |
+                           PTE_WRITE | PTE_PRESENT;
+            continue;
+        }
+
+        pt = pt_alloc();
+        if (pt == NULL) {
+            print("paging_init: no memory for the page tables.\n");
+            return;
+        }
+        for (j = 0; j < PAGE_ENTRIES; j++)
+            pt[j] = (i * PAGE_LARGE_SIZE + j * PAGE_SIZE) | global |
+                    PTE_WRITE | PTE_PRESENT;
+        kernel_pd[i] = (uint32_t) pt | PTE_WRITE | PTE_PRESENT;
+    }
+
+    if (r.edx & CPUID_EDX_PSE)
+        write_cr4(read_cr4() | CR4_PSE);
+    write_cr3((uint32_t) kernel_pd);
+    paging_enable();
+    if (global)
+        write_cr4(read_cr4() | CR4_PGE);
+}
+
+/*!
+    @function    paging_enabled
+
+    @result 1 if paging is enabled, 0 otherwise.
+*/
+uint32_t paging_enabled(void) {
+    return (read_cr0() & CR0_PG) != 0;
+}
+
+/*!
+    @function    paging_enable
+
+    @discussion Sets CR0.PG. The page directory must be loaded, see
+    paging_init().
+*/
+void paging_enable(void) {
+    write_cr0(read_cr0() | CR0_PG);
+}
+
+/*!
+    @function    paging_disable
+
+    @discussion Clears CR0.PG. Safe since the kernel is identity mapped,
+    mappings outside the identity map are not accessible until paging is
+    enabled again. Used by the benchmarks.
+*/
+void paging_disable(void) {
+    write_cr0(read_cr0() & ~CR0_PG);
+}
+
+/*!
+    @function    paging_map
+
+    @discussion Maps the 4 KiB page at virt to the frame at phys. Replaces an
+    existing mapping.
+
+    @param    virt     The linear address, page aligned.
+    @param    phys     The physical address, page aligned.
+    @param    flags    PTE_* flags. PTE_PRESENT is implied. PTE_GLOBAL for a
+                       mapping that is the same in every address space.
+
+    @result 1 if mapped, 0 if out of memory for the page table.
+*/
+uint32_t paging_map(uint32_t virt, uint32_t phys, uint32_t flags) {
+    uint32_t pdi = PDE_INDEX(virt);
+    uint32_t pde = kernel_pd[pdi];
+    uint32_t *pt, old;
+
+    assert(((virt | phys) & (PAGE_SIZE - 1)) == 0);
+
+    if ((pde & PTE_PRESENT) == 0) {
+        pt = pt_alloc();
+        if (pt == NULL)
+            return 0;
+        kernel_pd[pdi] = (uint32_t) pt | PTE_WRITE | (flags & PTE_USER) |
+                         PTE_PRESENT;
+    } else if (pde & PTE_PS) {
+        pt = pt_split(pdi);
+        if (pt == NULL)
+            return 0;
+    } else {
+        pt = (uint32_t *) (pde & PTE_ADDR_MASK);
+    }
+
+    old = pt[PTE_INDEX(virt)];
+    pt[PTE_INDEX(virt)] = phys | (flags & ~PTE_ADDR_MASK) | PTE_PRESENT;
+    if (old & PTE_PRESENT)
+        tlb_invalidate(virt, old & PTE_GLOBAL);
+
+    return 1;
+}
+
+/*!
+    @function    paging_unmap
+
+    @discussion Removes the mapping of the 4 KiB page at virt. The page table
+    is kept.
+
+    @param    virt    The linear address, page aligned.
+*/
+void paging_unmap(uint32_t virt) {
+    uint32_t pdi = PDE_INDEX(virt);
+    uint32_t pde = kernel_pd[pdi];
+    uint32_t *pt, old;
+
+    if ((pde & PTE_PRESENT) == 0)
+        return;
+
+    if (pde & PTE_PS) {
+        pt = pt_split(pdi);
+        assert(pt != NULL);
+    } else {
+        pt = (uint32_t *) (pde & PTE_ADDR_MASK);
+    }
+
+    old = pt[PTE_INDEX(virt)];
+    pt[PTE_INDEX(virt)] = 0;
+    if (old & PTE_PRESENT)
+        tlb_invalidate(virt, old & PTE_GLOBAL);
+}
+
+/*!
+    @function    paging_translate
+
+    @discussion Walks the page directory.
+
+    @param    virt    A linear address.
+
+    @result The physical address virt maps to, PAGING_NONE if unmapped.
+*/
+uint32_t paging_translate(uint32_t virt) {
+    uint32_t pde = kernel_pd[PDE_INDEX(virt)];
+    uint32_t pte;
+
+    if ((pde & PTE_PRESENT) == 0)
+        return PAGING_NONE;
+    if (pde & PTE_PS)
+        return (pde & PDE_LARGE_ADDR_MASK) | (virt & (PAGE_LARGE_SIZE - 1));
+
+    pte = ((uint32_t *) (pde & PTE_ADDR_MASK))[PTE_INDEX(virt)];
+    if ((pte & PTE_PRESENT) == 0)
+        return PAGING_NONE;
+
+    return (pte & PTE_ADDR_MASK) | (virt & (PAGE_SIZE - 1));
+}
+
+/*!
+    @function    paging_global_enabled
+
+    @result 1 if global pages are enabled, CR4.PGE, 0 otherwise.
+*/
+uint32_t paging_global_enabled(void) {
+    return (read_cr4() & CR4_PGE) != 0;
+}
+
+/*!
+    @function    tlb_flush_all
+
+    @discussion Flushes the TLB entries of non-global pages by reloading CR3.
+*/
+void tlb_flush_all(void) {
+    if (paging_enabled()) {
+        write_cr3(read_cr3());
+        tlb_counters.flush++;
+    }
+}
+
+/*!
+    @function    tlb_flush_global
+
+    @discussion Flushes all TLB entries, including the global ones, by
+    toggling CR4.PGE. A CR3 reload if global pages are disabled.
+*/
+void tlb_flush_global(void) {
+    uint32_t cr4;
+
+    if (!paging_enabled())
+        return;
+
+    cr4 = read_cr4();
+    if ((cr4 & CR4_PGE) == 0) {
+        tlb_flush_all();
+        return;
+    }
+
+    write_cr4(cr4 & ~CR4_PGE);
+    write_cr4(cr4);
+    tlb_counters.flush_global++;
+}
+
+/*!
+    @function    tlb_batch_begin
+
+    @discussion Starts a TLB batch. Until tlb_batch_end(), paging_map() and
+    paging_unmap() record the changed pages in b instead of invalidating
+    them. The changed mappings may still be used through stale TLB entries
+    until then. Batches do not nest.
+
+    @param    b    The batch.
+*/
+void tlb_batch_begin(tlb_batch_t *b) {
+    assert(tlb_batch == NULL);
+
+    b->n = 0;
+    b->global = 0;
+    tlb_batch = b;
+}
+
+/*!
+    @function    tlb_batch_end
+
+    @discussion Ends a TLB batch and invalidates its pages: one INVLPG per page
+    for up to TLB_FLUSH_CEILING pages, otherwise a full flush, which includes
+    the global entries only if a global mapping changed.
+
+    @param    b    The batch.
+*/
+void tlb_batch_end(tlb_batch_t *b) {
+    uint32_t i;
+
+    assert(tlb_batch == b);
+    tlb_batch = NULL;
+    tlb_counters.batches++;
+
+    if (b->n == 0 || !paging_enabled())
+        return;
+
+    if (b->n <= TLB_FLUSH_CEILING) {
+        for (i = 0; i < b->n; i++)
+            invlpg(b->addr[i]);
+        tlb_counters.invlpg += b->n;
+    } else if (b->global) {
+        tlb_flush_global();
+    } else {
+        tlb_flush_all();
+    }
+}
+
+/*!
+    @function    tlb_stats
+
+    @discussion Copies the TLB invalidation counters.
+
+    @param    s    Where to store the counters.
+*/
+void tlb_stats(tlb_stats_t *s) {
+    *s = tlb_counters;
+}
+
+/*!
+    @function    tlb_print_stats
+
+    @discussion Prints the TLB invalidation counters.
+*/
+void tlb_print_stats(void) {
+    print("TLB: invlpg ");
+    print_d(tlb_counters.invlpg);
+    print(" flush ");
+    print_d(tlb_counters.flush);
+    print(" flush_global ");
+    print_d(tlb_counters.flush_global);
+    print(" batches ");
+    print_d(tlb_counters.batches);
+    print("\n");
+}
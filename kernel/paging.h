@@ -0,0 +1,146 @@
+#ifndef __PAGING_H__
+#define __PAGING_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    PAGE_SIZE, PAGE_LARGE_SIZE
+
+    @discussion The sizes of a page and of a large (PSE) page.
+*/
+#define PAGE_SIZE (4096)
+#define PAGE_LARGE_SIZE (0x400000)
+
+/*!
+    @defined    PAGE_ENTRIES
+
+    @discussion The number of entries of a page directory or page table.
+*/
+#define PAGE_ENTRIES (1024)
+
+/*!
+    @defined    PTE_PRESENT ... PTE_GLOBAL
+
+    @discussion Flags of page directory and page table entries.
+    @doc [Figure 4-4. Formats of CR3 and Paging-Structure Entries with 32-Bit
+         Paging](Intel 64 & IA-32 Arch. SDM Vol.3 Ch.4.3)
+
+    @constant    PTE_PRESENT     The entry maps a page or page table.
+    @constant    PTE_WRITE       Writes are allowed.
+    @constant    PTE_USER        User mode accesses are allowed.
+    @constant    PTE_PWT         Page-level write-through.
+    @constant    PTE_PCD         Page-level cache disable.
+    @constant    PTE_ACCESSED    Set by the CPU when the page is accessed.
+    @constant    PTE_DIRTY       Set by the CPU when the page is written.
+    @constant    PTE_PS          Page directory entries only, the entry maps a
+                                 4 MiB page.
+    @constant    PTE_PAT         Page table entries only, the PAT bit.
+    @constant    PTE_GLOBAL      The translation is global, see CR4.PGE.
+    @constant    PDE_PAT         4 MiB page directory entries only, the PAT
+                                 bit.
+*/
+#define PTE_PRESENT  (0x001)
+#define PTE_WRITE    (0x002)
+#define PTE_USER     (0x004)
+#define PTE_PWT      (0x008)
+#define PTE_PCD      (0x010)
+#define PTE_ACCESSED (0x020)
+#define PTE_DIRTY    (0x040)
+#define PTE_PS       (0x080)
+#define PTE_PAT      (0x080)
+#define PTE_GLOBAL   (0x100)
+#define PDE_PAT      (0x1000)
+
+/*!
+    @defined    PAGING_NONE
+
+    @discussion Returned by paging_translate() for an unmapped address.
+*/
+#define PAGING_NONE (0xFFFFFFFF)
+
+/*!
+    @defined    TLB_FLUSH_CEILING
+
+    @discussion A TLB batch of up to this many pages is flushed with one
+    INVLPG per page, a larger batch with a full flush.
+*/
+#define TLB_FLUSH_CEILING (32)
+
+/*!
+    @typedef    tlb_batch_t
+
+    @discussion The linear addresses whose mappings changed since
+    tlb_batch_begin(), see tlb_batch_end().
+
+    @field    n         The number of pages, may exceed TLB_FLUSH_CEILING.
+    @field    global    1 if a global mapping changed.
+    @field    addr      The first TLB_FLUSH_CEILING addresses.
+*/
+typedef struct _tlb_batch_t {
+    uint32_t n;
+    uint32_t global;
+    uint32_t addr[TLB_FLUSH_CEILING];
+} tlb_batch_t;
+
+/*!
+    @typedef    tlb_stats_t
+
+    @discussion TLB invalidation counters.
+
+    @field    invlpg          Single page invalidations, INVLPG.
+    @field    flush           Full flushes of the non-global entries, CR3
+                              reloads.
+    @field    flush_global    Full flushes including the global entries, CR4.PGE
+                              toggles.
+    @field    batches         Batches ended by tlb_batch_end().
+*/
+typedef struct _tlb_stats_t {
+    uint32_t invlpg;
+    uint32_t flush;
+    uint32_t flush_global;
+    uint32_t batches;
+} tlb_stats_t;
+
+/*! See .c */
+void paging_init(void);
+
+/*! See .c */
+uint32_t paging_enabled(void);
+
+/*! See .c */
+void paging_enable(void);
+
+/*! See .c */
+void paging_disable(void);
+
+/*! See .c */
+uint32_t paging_map(uint32_t virt, uint32_t phys, uint32_t flags);
+
+/*! See .c */
+void paging_unmap(uint32_t virt);
+
+/*! See .c */
+uint32_t paging_translate(uint32_t virt);
+
+/*! See .c */
+uint32_t paging_global_enabled(void);
+
+/*! See .c */
+void tlb_flush_all(void);
+
+/*! See .c */
+void tlb_flush_global(void);
+
+/*! See .c */
+void tlb_batch_begin(tlb_batch_t *b);
+
+/*! See .c */
+void tlb_batch_end(tlb_batch_t *b);
+
+/*! See .c */
+void tlb_stats(tlb_stats_t *s);
+
+/*! See .c */
+void tlb_print_stats(void);
+
+#endif
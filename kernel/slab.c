@@ -0,0 +1,433 @@
+/*!
+    @header Slab allocator.
+    Object caches for fixed size kernel structures, in the style of the
+    kmem_cache_* interface. Each cache allocates objects of one size from
+    slabs, blocks of 2^order frames taken from the frame allocator.
+
+    @discussion A slab starts with its header, slab_t, which is aligned to the
+    cache line size. The objects follow at a multiple of the requested
+    alignment. The free objects of a slab form a singly linked list through
+    their free pointers, hence an allocation pops the list head of the first
+    partially used slab and a free pushes the object back onto its slab's list.
+    No search is needed, the slab of an object is its address rounded down to
+    the slab size.
+
+    A cache keeps three doubly linked lists of slabs: partial (free and
+    allocated objects), full (no free objects) and empty (no allocated
+    objects). Allocations take the partial slabs first, then the empty ones,
+    and only create a new slab if both lists are empty. Empty slabs stay on
+    their cache, their objects stay constructed. They are returned to the
+    frame allocator only under memory pressure: when a slab can't be created
+    kmem_cache_reap() shrinks all caches and the allocation is retried.
+
+    A hit is an allocation served by an existing slab, a miss one that had to
+    create a slab.
+
+    @doc [The Slab Allocator: An Object-Caching Kernel Memory Allocator,
+    Bonwick, USENIX Summer 1994]
+*/
+
+#include "../drivers/screen.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "frame_alloc.h"
+#include "slab.h"
+
+/*!
+    @defined    SLAB_MAX_ORDER
+
+    @discussion The largest slab, 2^SLAB_MAX_ORDER frames.
+*/
+#define SLAB_MAX_ORDER (3)
+
+/*!
+    @defined    SLAB_MIN_OBJS
+
+    @discussion The slab order is raised until a slab holds at least this many
+    objects, or up to SLAB_MAX_ORDER. Bounds the internal fragmentation.
+*/
+#define SLAB_MIN_OBJS (8)
+
+/*!
+    @var    cache_cache
+
+    @discussion The cache of the kmem_cache_t structures. Statically
+    allocated, it is the first cache on the list of all caches.
+*/
+static kmem_cache_t cache_cache;
+
+/*!
+    @var    caches
+
+    @discussion The list of all caches, linked through kmem_cache_t.next.
+*/
+static kmem_cache_t *caches;
+
+/*!
+    @function    align_up
+
+    @discussion Rounds x up to a multiple of align, a power of 2.
+*/
+static inline __attribute__((always_inline))
+uint32_t align_up(uint32_t x, uint32_t align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+/*!
+    @function    slab_list_push
+
+    @discussion Adds slab s to the front of the list at head.
+*/
+static void slab_list_push(slab_t **head, slab_t *s) {
+    s->prev = NULL;
+    s->next = *head;
+    if (*head)
+        (*head)->prev = s;
+    *head = s;
+}
+
+/*!
+    @function    slab_list_remove
+
+    @discussion Removes slab s from the list at head.
+*/
+static void slab_list_remove(slab_t **head, slab_t *s) {
+    if (s->prev)
+        s->prev->next = s->next;
+    else
+        *head = s->next;
+    if (s->next)
+        s->next->prev = s->prev;
+}
+
+/*!
+    @function    free_ptr
+
+    @discussion Returns the address of the free pointer of object obj.
+*/
+static inline __attribute__((always_inline))
+void **free_ptr(const kmem_cache_t *c, void *obj) {
+    return (void **) ((uint8_t *) obj + c->free_offset);
+}
+
+/*!
+    @function    cache_setup
+
+    @discussion Initializes cache c: computes the slab layout and clears the
+    lists and counters. See kmem_cache_create().
+*/
+static void cache_setup(kmem_cache_t *c, const char *name, uint32_t size,
+                        uint32_t align, kmem_ctor_t ctor) {
+    uint32_t slab_size;
+
+    if (align < sizeof(void *))
+        align = sizeof(void *);
+    assert((align & (align - 1)) == 0 && align <= FRAME_SIZE);
+
+    c->name = name;
+    c->size = size;
+    c->ctor = ctor;
+
+    if (ctor) {
+        // The constructed state of an object must survive the free pointer.
+        c->free_offset = align_up(size, sizeof(void *));
+        c->stride = c->free_offset + sizeof(void *);
+    } else {
+        c->free_offset = 0;
+        c->stride = size < sizeof(void *) ? sizeof(void *) : size;
+    }
+    c->stride = align_up(c->stride, align);
+    c->first_offset = align_up(sizeof(slab_t), align);
+
+    for (c->slab_order = 0; ; c->slab_order++) {
+        slab_size = FRAME_SIZE << c->slab_order;
+        c->objs_per_slab = slab_size > c->first_offset ?
+                           (slab_size - c->first_offset) / c->stride : 0;
+        if (c->objs_per_slab >= SLAB_MIN_OBJS ||
+            c->slab_order == SLAB_MAX_ORDER)
+            break;
+    }
+    assert(c->objs_per_slab > 0);
+
+    c->partial = NULL;
+    c->full = NULL;
+    c->empty = NULL;
+    c->nr_slabs = 0;
+    c->hits = 0;
+    c->misses = 0;
+    c->reaped = 0;
+}
+
+/*!
+    @function    cache_init
+
+    @discussion Initializes cache_cache on first use.
+*/
+static void cache_init(void) {
+    if (caches)
+        return;
+
+    cache_setup(&cache_cache, "kmem_cache", sizeof(kmem_cache_t), 0, NULL);
+    cache_cache.next = NULL;
+    caches = &cache_cache;
+}
+
+/*!
+    @function    slab_create
+
+    @discussion Allocates a slab for cache c from the frame allocator, builds
+    its free list and constructs its objects. The slab is not on any list.
+
+    @result The slab, NULL if there are not enough free frames.
+*/
+static slab_t *slab_create(kmem_cache_t *c) {
+    uint32_t n = 1U << c->slab_order;
+    uint32_t addr, i;
+    uint8_t *obj;
+    slab_t *s;
+
+    addr = n == 1 ? frame_alloc() : frame_alloc_contig(n, n);
+    if (addr == FRAME_NONE)
+        return NULL;
+
+    s = (slab_t *) addr;
+    s->cache = c;
+    s->inuse = 0;
+    s->free = NULL;
+
+    // Push in reverse so the objects are allocated in address order.
+    obj = (uint8_t *) s + c->first_offset + c->objs_per_slab * c->stride;
+    for (i = 0; i < c->objs_per_slab; i++) {
+        obj -= c->stride;
+        if (c->ctor)
+            c->ctor(obj);
+        *free_ptr(c, obj) = s->free;
+        s->free = obj;
+    }
+
+    c->nr_slabs++;
+
+    return s;
+}
+
+/*!
+    @function    slab_destroy
+
+    @discussion Returns the empty slab s of cache c to the frame allocator.
+*/
+static void slab_destroy(kmem_cache_t *c, slab_t *s) {
+    uint32_t n = 1U << c->slab_order;
+
+    c->nr_slabs--;
+    c->reaped++;
+
+    if (n == 1)
+        frame_free((uint32_t) s);
+    else
+        frame_free_contig((uint32_t) s, n);
+}
+
+/*!
+    @function    kmem_cache_create
+
+    @discussion Creates an object cache. The object address is a multiple of
+    align. The cache starts without slabs.
+
+    @param    name     The cache's name, for statistics. Must outlive the
+                       cache.
+    @param    size     The object size in bytes.
+    @param    align    The object alignment, a power of 2 up to FRAME_SIZE.
+                       0 for pointer alignment, KMEM_CACHE_LINE to keep
+                       objects on separate cache lines.
+    @param    ctor     The object constructor, NULL if none.
+
+    @result The cache, NULL if out of memory.
+*/
+kmem_cache_t *kmem_cache_create(const char *name, uint32_t size,
+                                uint32_t align, kmem_ctor_t ctor) {
+    kmem_cache_t *c;
+
+    assert(size > 0);
+
+    cache_init();
+
+    c = (kmem_cache_t *) kmem_cache_alloc(&cache_cache);
+    if (c == NULL)
+        return NULL;
+
+    cache_setup(c, name, size, align, ctor);
+    c->next = caches->next;     // cache_cache stays first.
+    caches->next = c;
+
+    return c;
+}
+
+/*!
+    @function    kmem_cache_destroy
+
+    @discussion Destroys a cache and returns its slabs to the frame allocator.
+    All its objects must have been freed.
+
+    @param    c    The cache.
+*/
+void kmem_cache_destroy(kmem_cache_t *c) {
+    kmem_cache_t *p;
+
+    assert(c != &cache_cache);
+    assert(c->partial == NULL && c->full == NULL);
+
+    kmem_cache_shrink(c);
+
+    for (p = caches; p->next != c; p = p->next)
+        assert(p->next);
+    p->next = c->next;
+
+    kmem_cache_free(&cache_cache, c);
+}
+
+/*!
+    @function    kmem_cache_alloc
+
+    @discussion Allocates an object. The object is in its constructed state if
+    the cache has a constructor.
+
+    @param    c    The cache.
+
+    @result The object, NULL if out of memory.
+*/
+void *kmem_cache_alloc(kmem_cache_t *c) {
+    slab_t *s = c->partial;
+    void *obj;
+
+    if (s) {
+        c->hits++;
+    } else if ((s = c->empty)) {
+        c->hits++;
+        slab_list_remove(&c->empty, s);
+        slab_list_push(&c->partial, s);
+    } else {
+        c->misses++;
+        s = slab_create(c);
+        if (s == NULL) {
+            kmem_cache_reap();
+            s = slab_create(c);
+            if (s == NULL)
+                return NULL;
+        }
+        slab_list_push(&c->partial, s);
+    }
+
+    obj = s->free;
+    s->free = *free_ptr(c, obj);
+    s->inuse++;
+
+    if (s->free == NULL) {
+        slab_list_remove(&c->partial, s);
+        slab_list_push(&c->full, s);
+    }
+
+    return obj;
+}
+
+/*!
+    @function    kmem_cache_free
+
+    @discussion Frees an object allocated with kmem_cache_alloc(). If the cache
+    has a constructor, the object must be in its constructed state.
+
+    @param    c      The cache.
+    @param    obj    The object.
+*/
+void kmem_cache_free(kmem_cache_t *c, void *obj) {
+    slab_t *s = (slab_t *) ((uint32_t) obj &
+                            ~((FRAME_SIZE << c->slab_order) - 1));
+
+    assert(s->cache == c && s->inuse > 0);
+
+    if (s->free == NULL) {
+        slab_list_remove(&c->full, s);
+        slab_list_push(&c->partial, s);
+    }
+
+    *free_ptr(c, obj) = s->free;
+    s->free = obj;
+    s->inuse--;
+
+    if (s->inuse == 0) {
+        slab_list_remove(&c->partial, s);
+        slab_list_push(&c->empty, s);
+    }
+}
+
+/*!
+    @function    kmem_cache_shrink
+
+    @discussion Returns the empty slabs of a cache to the frame allocator.
+
+    @param    c    The cache.
+
+    @result The number of frames returned.
+*/
+uint32_t kmem_cache_shrink(kmem_cache_t *c) {
+    uint32_t n = 0;
+    slab_t *s;
+
+    while ((s = c->empty)) {
+        slab_list_remove(&c->empty, s);
+        slab_destroy(c, s);
+        n += 1U << c->slab_order;
+    }
+
+    return n;
+}
+
+/*!
+    @function    kmem_cache_reap
+
+    @discussion Returns the empty slabs of all caches to the frame allocator.
+    Called under memory pressure, e.g. when a slab can't be created.
+
+    @result The number of frames returned.
+*/
+uint32_t kmem_cache_reap(void) {
+    kmem_cache_t *c;
+    uint32_t n = 0;
+
+    for (c = caches; c; c = c->next)
+        n += kmem_cache_shrink(c);
+
+    return n;
+}
+
+/*!
+    @function    kmem_cache_print_stats
+
+    @discussion Prints the statistics of all caches: object size, objects per
+    slab, number of slabs, hits and misses.
+*/
+void kmem_cache_print_stats(void) {
+    char str[STDIO_STR_SIZE_MAX];
+    kmem_cache_t *c;
+
+    print("cache size objs slabs hits misses\n");
+
+    for (c = caches; c; c = c->next) {
+        print(c->name);
+        print(" ");
+        _utoa(c->size, str);
+        print(str);
+        print(" ");
+        _utoa(c->objs_per_slab, str);
+        print(str);
+        print(" ");
+        _utoa(c->nr_slabs, str);
+        print(str);
+        print(" ");
+        _utoa(c->hits, str);
+        print(str);
+        print(" ");
+        _utoa(c->misses, str);
+        print(str);
+        print("\n");
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @defined    KMEM_CACHE_LINE
+
+    @discussion The cache line size. Slab headers are aligned to it, and it is
+    the alignment to pass to kmem_cache_create() for objects that must not
+    share a cache line.
+*/
+#define KMEM_CACHE_LINE (64)
+
+/*!
+    @typedef    kmem_ctor_t
+
+    @discussion An object constructor. Called once for each object when its
+    slab is created. Objects must be freed in their constructed state.
+*/
+typedef void (*kmem_ctor_t)(void *obj);
+
+/*!
+    @typedef    slab_t
+
+    @discussion A slab, 2^order frames that hold objects of a single cache. The
+    slab header is at the start of the slab, the objects follow. The slab of an
+    object is found by rounding the object's address down to the slab size.
+
+    @field    next, prev    The links of the cache's slab list the slab is on.
+    @field    cache         The slab's cache.
+    @field    free          The first free object. Each free object holds the
+                            address of the next one.
+    @field    inuse         The number of allocated objects.
+*/
+typedef struct _slab_t {
+    struct _slab_t *next;
+    struct _slab_t *prev;
+    struct _kmem_cache_t *cache;
+    void *free;
+    uint32_t inuse;
+} __attribute__((aligned(KMEM_CACHE_LINE))) slab_t;
+
+/*!
+    @typedef    kmem_cache_t
+
+    @discussion A cache of objects of a single size.
+
+    @field    name             The cache's name, for statistics. Not copied.
+    @field    size             The object size.
+    @field    stride           The distance between objects in a slab.
+    @field    free_offset      The offset of the free list pointer in a free
+                               object. Past the object if there is a
+                               constructor, whose work must not be overwritten.
+    @field    first_offset     The offset of the first object in a slab.
+    @field    slab_order       A slab is 2^slab_order frames.
+    @field    objs_per_slab    The number of objects per slab.
+    @field    ctor             The object constructor, NULL if none.
+    @field    partial          The slabs with free and allocated objects.
+    @field    full             The slabs without free objects.
+    @field    empty            The slabs without allocated objects.
+    @field    nr_slabs         The number of slabs.
+    @field    hits             Allocations served by an existing slab.
+    @field    misses           Allocations that had to create a slab.
+    @field    reaped           Slabs returned to the frame allocator.
+    @field    next             The next cache, see kmem_cache_reap().
+*/
+typedef struct _kmem_cache_t {
+    const char *name;
+    uint32_t size;
+    uint32_t stride;
+    uint32_t free_offset;
+    uint32_t first_offset;
+    uint32_t slab_order;
+    uint32_t objs_per_slab;
+    kmem_ctor_t ctor;
+    slab_t *partial;
+    slab_t *full;
+    slab_t *empty;
+    uint32_t nr_slabs;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t reaped;
+    struct _kmem_cache_t *next;
+} kmem_cache_t;
+
+/*! See .c */
+kmem_cache_t *kmem_cache_create(const char *name, uint32_t size,
+                                uint32_t align, kmem_ctor_t ctor);
+
+/*! See .c */
+void kmem_cache_destroy(kmem_cache_t *c);
+
+/*! See .c */
+void *kmem_cache_alloc(kmem_cache_t *c);
+
+/*! See .c */
+void kmem_cache_free(kmem_cache_t *c, void *obj);
+
+/*! See .c */
+uint32_t kmem_cache_shrink(kmem_cache_t *c);
+
+/*! See .c */
+uint32_t kmem_cache_reap(void);
+
+/*! See .c */
+void kmem_cache_print_stats(void);
+
+#endif
@@ -0,0 +1,184 @@
+/*!
+    @header Deferred interrupt work.
+    Tasklets, in the style of Linux's bottom halves. An interrupt handler
+    acknowledges its device, schedules a tasklet with the rest of the work and
+    returns. The tasklets run with interrupts enabled, hence a slow one delays
+    no interrupt.
+
+    @discussion The scheduled tasklets are a singly linked list, pending.
+    tasklet_schedule() pushes a tasklet with a compare and swap, from any
+    context, without disabling interrupts. The runner takes the whole list
+    with an exchange and runs it in scheduling order.
+
+    The tasklets run on exit from the outermost interrupt, see
+    softirq_irq_exit(), and from the idle loop, see softirq_run(). They never
+    run nested: an interrupt that arrives while the tasklets run leaves its
+    tasklets to the running loop. A tasklet is scheduled at most once, until
+    it is run, hence it never runs concurrently with itself. It can schedule
+    itself again. Tasklets are thus serialized with each other: work sharing
+    a non-reentrant module with a tasklet, e.g. the screen, runs as a tasklet
+    too, see klog_tasklet.
+
+    @remark There is a single CPU, hence a single list. Each CPU would have
+    its own.
+
+    @doc [Deferred work](https://www.kernel.org/doc/html/latest/core-api/irq/concepts.html)
+*/
+
+#include "../include/stddef.h"
+#include "idt.h"
+#include "low_level.h"
+#include "softirq.h"
+
+/*!
+    @defined    SOFTIRQ_MAX_RESTART
+
+    @discussion The number of times the list is taken again when tasklets
+    were scheduled meanwhile, the rest is left to the next run. Bounds the
+    time an interrupted program waits.
+*/
+#define SOFTIRQ_MAX_RESTART (10)
+
+/*!
+    @defined    EFLAGS_IF
+
+    @discussion The interrupt enable flag in EFLAGS.
+*/
+#define EFLAGS_IF (1U << 9)
+
+/*!
+    @var    pending
+
+    @discussion The scheduled tasklets, the last scheduled first.
+*/
+static tasklet_t *volatile pending;
+
+/*!
+    @var    running
+
+    @discussion Set while the tasklets run, see run().
+*/
+static volatile uint32_t running;
+
+/*!
+    @function    xchg
+
+    @discussion Atomically stores v into *p.
+
+    @result The previous value of *p.
+*/
+static inline __attribute__((always_inline))
+uint32_t xchg(volatile uint32_t *p, uint32_t v) {
+    __asm__ volatile("xchgl %0, %1" : "+r" (v), "+m" (*p) : : "memory");
+    return v;
+}
+
+/*!
+    @function    cmpxchg
+
+    @discussion Atomically stores v into *p if *p == old.
+
+    @result The previous value of *p, old if v was stored.
+*/
+static inline __attribute__((always_inline))
+uint32_t cmpxchg(volatile uint32_t *p, uint32_t old, uint32_t v) {
+    __asm__ volatile("lock cmpxchgl %2, %1"
+                     : "+a" (old), "+m" (*p) : "r" (v) : "memory");
+    return old;
+}
+
+/*!
+    @function    tasklet_schedule
+
+    @discussion Schedules tasklet t, unless it is already. Callable from
+    interrupt handlers. fn and ctx must be set.
+
+    @param    t    The tasklet.
+*/
+void tasklet_schedule(tasklet_t *t) {
+    tasklet_t *old;
+
+    if (xchg(&t->scheduled, 1))
+        return;
+
+    do {
+        old = pending;
+        t->next = old;
+    } while (cmpxchg((volatile uint32_t *) &pending, (uint32_t) old,
+                     (uint32_t) t) != (uint32_t) old);
+}
+
+/*!
+    @function    run
+
+    @discussion Takes the list of scheduled tasklets and runs it, up to
+    restarts times while tasklets are scheduled meanwhile. running must be
+    set and interrupts enabled.
+*/
+static void run(uint32_t restarts) {
+    tasklet_t *list, *prev, *t;
+    uint64_t tsc;
+
+    do {
+        list = (tasklet_t *) xchg((volatile uint32_t *) &pending, 0);
+
+        // Scheduling order.
+        for (prev = NULL; list; list = t) {
+            t = list->next;
+            list->next = prev;
+            prev = list;
+        }
+
+        for (t = prev; t; t = list) {
+            list = t->next;
+            t->scheduled = 0; // Before fn, it may schedule t again.
+            tsc = read_tsc();
+            t->fn(t->ctx);
+            t->cycles += read_tsc() - tsc;
+            t->runs++;
+        }
+    } while (pending && restarts--);
+}
+
+/*!
+    @function    softirq_run
+
+    @discussion Runs the scheduled tasklets. Called by the idle loop. Does
+    nothing if called from a tasklet.
+*/
+void softirq_run(void) {
+    uint32_t flags;
+
+    flags = irq_save();
+    if (running || pending == NULL) {
+        irq_restore(flags);
+        return;
+    }
+    running = 1;
+    irq_restore(flags);
+
+    run(SOFTIRQ_MAX_RESTART);
+    running = 0;
+}
+
+/*!
+    @function    softirq_irq_exit
+
+    @discussion Runs the scheduled tasklets with interrupts enabled, on exit
+    from the outermost interrupt. Called by intr_common_handler, see
+    idt_asm.s, with interrupts disabled, and returns with them disabled.
+    Nothing is run if the interrupted program had interrupts disabled, e.g.
+    an exception in a critical section.
+
+    @param    eflags    The EFLAGS of the interrupted program.
+*/
+void softirq_irq_exit(uint32_t eflags) {
+    if (!(eflags & EFLAGS_IF) || intr_nesting || running || pending == NULL)
+        return;
+
+    running = 1;
+    __asm__ volatile("sti" : : : "memory");
+    run(SOFTIRQ_MAX_RESTART);
+    __asm__ volatile("cli" : : : "memory");
+    running = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef __SOFTIRQ_H__
+#define __SOFTIRQ_H__
+
+#include "../include/stdint.h"
+
+/*!
+    @typedef    tasklet_fn_t
+
+    @discussion The work of a tasklet, called with interrupts enabled.
+*/
+typedef void (*tasklet_fn_t)(void *ctx);
+
+/*!
+    @typedef    tasklet_t
+
+    @discussion Deferred work, scheduled by an interrupt handler and run
+    later with interrupts enabled. See tasklet_schedule().
+
+    @field    fn           The work.
+    @field    ctx          Passed to fn.
+    @field    scheduled    Set from tasklet_schedule() until fn is called.
+    @field    runs         The number of calls of fn.
+    @field    cycles       The cycles spent in fn, summed.
+    @field    next         The next scheduled tasklet.
+*/
+typedef struct _tasklet_t {
+    tasklet_fn_t fn;
+    void *ctx;
+    volatile uint32_t scheduled;
+    uint32_t runs;
+    uint64_t cycles;
+    struct _tasklet_t *next;
+} tasklet_t;
+
+/*! See .c */
+void tasklet_schedule(tasklet_t *t);
+
+/*! See .c */
+void softirq_run(void);
+
+/*! See .c */
+void softirq_irq_exit(uint32_t eflags);
+
+#endif
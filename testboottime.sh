@@ -0,0 +1,31 @@
+#!/bin/sh
+# Usage: ./testboottime.sh [runs]
+# Compares the boot time of the plain and the compressed (`make COMPRESS=1`)
+# os-image under QEMU, and of kernel.elf booted directly by QEMU's Multiboot
+# loader (`qemu -kernel`). Each image is built with `make BOOT_EXIT=1`, so QEMU
+# exits as soon as the kernel is initialized. The time reported is the average
+# wall clock time of one boot, from QEMU start to the end of the kernel's
+# initialization. For a per-stage breakdown see testboottimeline.sh.
+
+runs=${1:-10}
+qemu="qemu-system-i386 -display none -device isa-debug-exit,iobase=0xf4,iosize=0x04"
+
+# Usage: boottime name qemu_boot_options
+boottime() {
+    echo "$1: average of $runs boots"
+    /usr/bin/time -p sh -c "i=0; while [ \$i -lt $runs ]; do \
+        $qemu $2; i=\$((i + 1)); done" \
+        2>&1 | awk -v n=$runs '/^real/ { printf "%.3f s per boot\n", $2 / n }'
+}
+
+make clean > /dev/null && make BOOT_EXIT=1 > /dev/null || exit 1
+echo "$(wc -c < kernel.elf) bytes loaded from disk"
+boottime kernel.elf "-drive file=os-image,if=floppy,format=raw"
+
+boottime "kernel.elf -kernel" "-kernel kernel.elf"
+
+make clean > /dev/null && make BOOT_EXIT=1 COMPRESS=1 > /dev/null || exit 1
+echo "$(wc -c < kernel.lz4) bytes loaded from disk"
+boottime kernel.lz4 "-drive file=os-image,if=floppy,format=raw"
+
+make clean > /dev/null
@@ -0,0 +1,21 @@
+#!/bin/sh
+# Usage: ./testboottimeline.sh [make options]
+# Boots os-image under QEMU and prints the boot timeline that the kernel writes
+# to the debug port 0xe9, see kernel/boot_timeline.c. The image is built with
+# `make BOOT_EXIT=1`, so QEMU exits once the timeline is written. e.g. use
+# `./testboottimeline.sh COMPRESS=1` for the compressed image.
+
+make clean > /dev/null && make BOOT_EXIT=1 "$@" > /dev/null || exit 1
+
+qemu-system-i386 -display none -debugcon stdio \
+    -device isa-debug-exit,iobase=0xf4,iosize=0x04 \
+    -drive file=os-image,if=floppy,format=raw |
+awk '$1 == "boot_timeline" {
+    if (n == 0) { t0 = $3; prev = $3 }
+    printf "%-16s %14.0f cycles since first stage %14.0f in stage\n", \
+        $2, $3 - t0, $3 - prev
+    prev = $3
+    n++
+}'
+
+make clean > /dev/null
@@ -1,15 +1,19 @@
 #!/bin/sh
+# Usage: ./testksize.sh [file] [maxsize]
+# Defaults to checking kernel.elf as loaded by stage2.
 
-file=kernel.bin
-# 16384 = 512*32 # SECTOR_READ_COUNT=32
-maxsize=16384
+file=${1:-kernel.elf}
+# 2097152 = 0x600000 - 0x400000. The kernel image is read at
+# KERNEL_STAGING_ADDR=0x400000, and in compressed mode decompressed there from
+# 0x600000. See boot/stage2.s.
+maxsize=${2:-2097152}
 actualsize=$(wc -c < "$file")
 echo Max size is $maxsize. Is this up to date?
-echo kernel.bin size is $actualsize
-if [ $actualsize -lt $maxsize ]; then
-    echo kernel.bin size is OK.
+echo $file size is $actualsize
+if [ $actualsize -le $maxsize ]; then
+    echo $file size is OK.
     exit 0
 else
-    echo kernel.bin TOO LARGE increase boot_sect.asm SECTOR_READ_COUNT.
+    echo $file TOO LARGE.
     exit 1
-fi
\ No newline at end of file
+fi
@@ -1,14 +1,59 @@
 #include "test_assert.h"
 #include "test_stdlib.h"
 #include "test_stdio.h"
+#include "test_screen.h"
 #include "test_idt.h"
+#include "test_intr_stats.h"
+#include "test_boot_info.h"
+#include "test_multiboot.h"
+#include "test_frame_alloc.h"
+#include "test_buddy.h"
+#include "test_slab.h"
+#include "test_paging.h"
+#include "test_page_fault.h"
+#include "test_ioremap.h"
+#include "test_klog.h"
+#include "test_serial.h"
+#include "test_apic.h"
+#include "test_softirq.h"
+#include "test_pit.h"
 #include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
 
 void test_all(void) {
+    test_all_screen();
     test_all_stdio();
     test_all_stdlib();
     test_all_assert();
     test_all_idt();
+    test_all_intr_stats();
+    test_all_boot_info();
+    test_all_multiboot();
+    test_all_frame_alloc();
+    test_all_buddy();
+    test_all_slab();
+    test_all_paging();
+    test_all_page_fault();
+    test_all_ioremap();
+    test_all_klog();
+    test_all_serial();
+    test_all_apic();
+    test_all_softirq();
+    test_all_pit();
     print("All tests passed!\n");
     assert(0); // Marks the end of all tests.
+}
+
+/*
+    Prints what, the average of cycles over n operations, and " cycles". Used
+    by the benchmarks.
+*/
+void print_cycles(const char *what, uint64_t cycles, uint32_t n) {
+    char s[STDIO_STR_SIZE_MAX];
+
+    print(what);
+    _utoa(cycles / n, s);
+    print(s);
+    print(" cycles\n");
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef __TEST_ALL_H__
 #define __TEST_ALL_H__
 
+#include "../include/stdint.h"
+
 void test_all(void);
 
+void print_cycles(const char *what, uint64_t cycles, uint32_t n);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "../kernel/apic.h"
+#include "../kernel/idt.h"
+#include "../kernel/i8259a_pic.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/serial.h"
+
+#define TEST_IRQS (200)
+#define TEST_EOIS (1000)
+#define TEST_TIMEOUT (100000000ULL)
+
+/*
+    Cycles per IRQ round trip, from the device raising the line to the return
+    from the handler. COM1 raises IRQ4 when its THRE interrupt is enabled with
+    the transmitter empty, the handler, v36_handler, finds the transmit ring
+    empty and acknowledges the controller.
+*/
+static uint32_t time_irq(void) {
+    const serial_stats_t *st = serial_get_stats();
+    uint8_t ier = inb(SERIAL_COM1 + SERIAL_IER);
+    uint64_t t, start;
+    uint32_t irqs, i;
+
+    serial_flush();
+    start = read_tsc();
+    for (i = 0; i < TEST_IRQS; i++) {
+        irqs = st->tx_irqs;
+        outb(SERIAL_COM1 + SERIAL_IER, ier & ~SERIAL_IER_THRE);
+        outb(SERIAL_COM1 + SERIAL_IER, ier | SERIAL_IER_THRE);
+        t = read_tsc();
+        while (st->tx_irqs == irqs)
+            assert(read_tsc() - t < TEST_TIMEOUT);
+    }
+    return (read_tsc() - start) / TEST_IRQS;
+}
+
+/*
+    Cycles per EOI of the current controller, without an interrupt in
+    service. A non-specific EOI of the PICs and an EOI of the local APIC are
+    then ignored. IRQ 8 is on the slave PIC, 2 port writes.
+*/
+static uint32_t time_eoi(uint32_t irq) {
+    uint32_t flags, i;
+    uint64_t t;
+
+    flags = irq_save();
+    t = read_tsc();
+    for (i = 0; i < TEST_EOIS; i++)
+        irq_eoi(IRQ_VN(irq));
+    t = read_tsc() - t;
+    irq_restore(flags);
+
+    return t / TEST_EOIS;
+}
+
+/*
+    Switches from the 8259A to the APICs, and compares both. The APICs stay
+    the interrupt controller for the tests that follow.
+*/
+void test_apic_switch(void) {
+    uint32_t pic_irq, pic_eoi1, pic_eoi2, apic_irq, apic_eoi1;
+
+    if (!apic_present()) {
+        print("apic: no local APIC, skipped\n");
+        return;
+    }
+    assert(intr_ctlr == &pic_ctlr);
+
+    time_irq(); // Warm up.
+    pic_irq = time_irq();
+    pic_eoi1 = time_eoi(4);
+    pic_eoi2 = time_eoi(8);
+
+    assert(apic_init() == 0);
+    assert(intr_ctlr == &apic_ctlr);
+
+    // The lines requested before the switch are still delivered.
+    time_irq();
+    apic_irq = time_irq();
+    apic_eoi1 = time_eoi(4);
+
+    kprintf("apic: IRQ round trip 8259A %u, APIC %u cycles\n", pic_irq,
+            apic_irq);
+    kprintf("apic: EOI 8259A master %u, slave %u, APIC %u cycles\n",
+            pic_eoi1, pic_eoi2, apic_eoi1);
+}
+
+void test_all_apic(void) {
+    test_apic_switch();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for apic.c/h.
+*/
+#ifndef __TEST_APIC_H__
+#define __TEST_APIC_H__
+
+void test_all_apic(void);
+
+#endif
@@ -0,0 +1,45 @@
+#include "../kernel/boot_info.h"
+#include "../include/assert.h"
+
+/*
+    A memory map like the one QEMU returns for 128 MiB of RAM, plus an entry
+    with the ACPI 3.0 "entry valid" bit clear, which must be ignored.
+*/
+static boot_info_t test_bi = {
+    0x00,
+    6,
+    {
+        {0x00000000ULL, 0x0009FC00ULL, E820_USABLE, 1},
+        {0x0009FC00ULL, 0x00000400ULL, E820_RESERVED, 1},
+        {0x000F0000ULL, 0x00010000ULL, E820_RESERVED, 1},
+        {0x00100000ULL, 0x07EE0000ULL, E820_USABLE, 1},
+        {0x07FE0000ULL, 0x00020000ULL, E820_RESERVED, 1},
+        {0x10000000ULL, 0x00100000ULL, E820_USABLE, 0},
+    },
+    0,
+    {{0, 0, 0}}
+};
+
+void test_boot_info_usable_size(void) {
+    assert(boot_info_usable_size(&test_bi) == 0x0009FC00ULL + 0x07EE0000ULL);
+}
+
+void test_boot_info_usable_end(void) {
+    assert(boot_info_usable_end(&test_bi) == 0x07FE0000ULL);
+}
+
+void test_boot_info_empty(void) {
+    boot_info_t bi;
+
+    bi.boot_drive = 0;
+    bi.mmap_len = 0;
+
+    assert(boot_info_usable_size(&bi) == 0);
+    assert(boot_info_usable_end(&bi) == 0);
+}
+
+void test_all_boot_info(void) {
+    test_boot_info_usable_size();
+    test_boot_info_usable_end();
+    test_boot_info_empty();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases for boot_info.c/h.
+*/
+#ifndef __TEST_BOOT_INFO_H__
+#define __TEST_BOOT_INFO_H__
+
+void test_all_boot_info(void);
+
+#endif
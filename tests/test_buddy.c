@@ -0,0 +1,182 @@
+#include "test_all.h"
+#include "../kernel/buddy.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+/*
+    The tests use their own zone of TEST_NBLOCKS largest blocks at TEST_BASE.
+    The allocator never touches the blocks' memory, so the zone does not have to
+    be backed by RAM.
+*/
+#define TEST_BASE (0x40000000)
+#define TEST_NBLOCKS (4)
+#define TEST_NFRAMES (TEST_NBLOCKS << BUDDY_MAX_ORDER)
+#define TEST_CHURN_SLOTS (64)
+#define TEST_CHURN_MAX_ORDER (5)
+#define TEST_CHURN_ITERATIONS (20000)
+
+static uint8_t test_meta[TEST_NFRAMES * (sizeof(buddy_link_t) + 1)];
+static buddy_zone_t test_zone;
+static uint32_t test_blocks[TEST_CHURN_SLOTS];
+static uint8_t test_orders[TEST_CHURN_SLOTS];
+
+static void test_zone_init(void) {
+    assert(buddy_zone_meta_size(TEST_NFRAMES) <= sizeof(test_meta));
+    buddy_zone_init(&test_zone, TEST_BASE, TEST_NFRAMES, test_meta);
+}
+
+/*
+    Checks that the zone is fully coalesced, i.e. every frame is free in a
+    block of the largest order.
+*/
+static void assert_coalesced(void) {
+    buddy_stats_t s;
+    uint32_t k;
+
+    buddy_zone_stats(&test_zone, &s);
+    assert(s.free_frames == TEST_NFRAMES);
+    assert(s.free_blocks[BUDDY_MAX_ORDER] == TEST_NBLOCKS);
+    assert(s.largest_order == BUDDY_MAX_ORDER);
+    for (k = 0; k < BUDDY_MAX_ORDER; k++)
+        assert(s.free_blocks[k] == 0 && s.frag[k] == 0);
+}
+
+void test_buddy_split_merge(void) {
+    uint32_t a, b, c;
+    buddy_stats_t s;
+
+    test_zone_init();
+    assert_coalesced();
+
+    a = buddy_zone_alloc(&test_zone, 0);
+    assert(a == TEST_BASE);
+    buddy_zone_stats(&test_zone, &s);
+    for (c = 0; c < BUDDY_MAX_ORDER; c++)
+        assert(s.free_blocks[c] == 1);      // One upper half per split.
+    assert(s.free_frames == TEST_NFRAMES - 1);
+
+    b = buddy_zone_alloc(&test_zone, 0);
+    assert(b == TEST_BASE + FRAME_SIZE);    // a's buddy.
+    c = buddy_zone_alloc(&test_zone, 2);
+    assert(c == TEST_BASE + 4 * FRAME_SIZE);
+    assert(buddy_zone_block_order(&test_zone, c) == 2);
+
+    buddy_zone_free(&test_zone, a);
+    buddy_zone_free(&test_zone, c);
+    buddy_zone_stats(&test_zone, &s);
+    assert(s.free_blocks[0] == 1);          // a can't merge, b is allocated.
+    assert(s.free_blocks[2] == 1);          // c can't merge, a and b can't.
+
+    buddy_zone_free(&test_zone, b);
+    assert_coalesced();
+}
+
+void test_buddy_exhaust(void) {
+    uint32_t i;
+
+    test_zone_init();
+
+    for (i = 0; i < TEST_NBLOCKS; i++)
+        test_blocks[i] = buddy_zone_alloc(&test_zone, BUDDY_MAX_ORDER);
+    assert(buddy_zone_alloc(&test_zone, 0) == BUDDY_NONE);
+    assert(buddy_zone_alloc(&test_zone, BUDDY_MAX_ORDER + 1) == BUDDY_NONE);
+
+    for (i = 0; i < TEST_NBLOCKS; i++)
+        buddy_zone_free(&test_zone, test_blocks[i]);
+    assert_coalesced();
+}
+
+/*
+    The kernel's arena is capped at BUDDY_ARENA_FRAMES, the frame allocator
+    keeps the rest of the memory.
+*/
+void test_buddy_arena_cap(void) {
+    buddy_stats_t s;
+
+    buddy_stats(&s);
+    assert(s.free_frames <= BUDDY_ARENA_FRAMES);
+    assert(frame_free_count() > s.free_frames);
+}
+
+/*
+    A linear congruential pseudo random number generator, Numerical Recipes
+    constants.
+*/
+static uint32_t test_rand_state = 1;
+
+static uint32_t test_rand(void) {
+    test_rand_state = test_rand_state * 1664525 + 1013904223;
+    return test_rand_state >> 8;
+}
+
+/*
+    Allocates and frees blocks of random orders 0 to TEST_CHURN_MAX_ORDER in
+    random slots, for TEST_CHURN_ITERATIONS iterations. Every allocation
+    succeeds: each of the at most TEST_CHURN_SLOTS blocks held lies in one of
+    the TEST_NFRAMES >> TEST_CHURN_MAX_ORDER aligned blocks of the largest
+    churn order, which are twice as many. Checks the free frame count half
+    way, and that everything coalesces back at the end. Reports the average
+    TSC cycles per alloc and per free.
+*/
+void bench_buddy_churn(void) {
+    uint64_t t, alloc_cycles = 0, free_cycles = 0;
+    uint32_t i, slot, order, held = 0, nalloc = 0, nfree = 0;
+    buddy_stats_t s;
+
+    assert(TEST_CHURN_SLOTS * 2 <= TEST_NFRAMES >> TEST_CHURN_MAX_ORDER);
+
+    test_zone_init();
+
+    for (i = 0; i < TEST_CHURN_SLOTS; i++)
+        test_blocks[i] = BUDDY_NONE;
+
+    for (i = 0; i < TEST_CHURN_ITERATIONS; i++) {
+        slot = test_rand() % TEST_CHURN_SLOTS;
+
+        if (test_blocks[slot] == BUDDY_NONE) {
+            order = test_rand() % (TEST_CHURN_MAX_ORDER + 1);
+            t = read_tsc();
+            test_blocks[slot] = buddy_zone_alloc(&test_zone, order);
+            alloc_cycles += read_tsc() - t;
+            nalloc++;
+            assert(test_blocks[slot] != BUDDY_NONE);
+            test_orders[slot] = order;
+            held += 1 << order;
+        } else {
+            t = read_tsc();
+            buddy_zone_free(&test_zone, test_blocks[slot]);
+            free_cycles += read_tsc() - t;
+            nfree++;
+            test_blocks[slot] = BUDDY_NONE;
+            held -= 1 << test_orders[slot];
+        }
+
+        if (i == TEST_CHURN_ITERATIONS / 2) {
+            // Every frame not held is free, and a block of the largest churn
+            // order is.
+            buddy_zone_stats(&test_zone, &s);
+            assert(s.free_frames == TEST_NFRAMES - held);
+            assert(s.largest_order != BUDDY_NONE &&
+                   s.largest_order >= TEST_CHURN_MAX_ORDER);
+        }
+    }
+
+    for (i = 0; i < TEST_CHURN_SLOTS; i++) {
+        if (test_blocks[i] != BUDDY_NONE)
+            buddy_zone_free(&test_zone, test_blocks[i]);
+    }
+    assert_coalesced();
+
+    print_cycles("buddy: churn per alloc ", alloc_cycles, nalloc);
+    print_cycles("buddy: churn per free ", free_cycles, nfree);
+}
+
+void test_all_buddy(void) {
+    test_buddy_split_merge();
+    test_buddy_exhaust();
+    test_buddy_arena_cap();
+    bench_buddy_churn();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for buddy.c/h.
+*/
+#ifndef __TEST_BUDDY_H__
+#define __TEST_BUDDY_H__
+
+void test_all_buddy(void);
+
+#endif
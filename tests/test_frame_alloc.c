@@ -0,0 +1,136 @@
+#include "test_all.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+/*
+    The tests use their own pool of TEST_NFRAMES frames (32 MiB), the first MiB
+    is reserved like in the kernel's pool.
+*/
+#define TEST_NFRAMES (8192)
+#define TEST_FREE_FRAMES (TEST_NFRAMES - 256)
+
+static uint32_t test_bitmap[TEST_NFRAMES / 32];
+static uint32_t test_frames[TEST_NFRAMES];
+static frame_pool_t test_pool;
+
+static void test_pool_init(void) {
+    frame_pool_init(&test_pool, test_bitmap, TEST_NFRAMES);
+    frame_pool_free_range(&test_pool, 0, (uint64_t) TEST_NFRAMES * FRAME_SIZE);
+    frame_pool_reserve_range(&test_pool, 0, 0x100000);
+}
+
+void test_frame_pool_init(void) {
+    test_pool_init();
+    assert(test_pool.free_frames == TEST_FREE_FRAMES);
+
+    // Partial frames are not freed, and reserved partial frames are reserved.
+    frame_pool_init(&test_pool, test_bitmap, TEST_NFRAMES);
+    frame_pool_free_range(&test_pool, 0x100001, 0x104fff);
+    assert(test_pool.free_frames == 3);
+    frame_pool_reserve_range(&test_pool, 0x102fff, 0x103001);
+    assert(test_pool.free_frames == 1);
+    assert(frame_pool_alloc(&test_pool) == 0x101000);
+    assert(frame_pool_alloc(&test_pool) == FRAME_NONE);
+}
+
+void test_frame_pool_alloc_free(void) {
+    uint32_t a, b, c;
+
+    test_pool_init();
+
+    a = frame_pool_alloc(&test_pool);
+    b = frame_pool_alloc(&test_pool);
+    c = frame_pool_alloc(&test_pool);
+    assert(a == 0x100000 && b == 0x101000 && c == 0x102000);
+    assert(test_pool.free_frames == TEST_FREE_FRAMES - 3);
+
+    frame_pool_free(&test_pool, b);
+    assert(frame_pool_alloc(&test_pool) == b); // Lowest free frame first.
+
+    frame_pool_free(&test_pool, a);
+    frame_pool_free(&test_pool, b);
+    frame_pool_free(&test_pool, c);
+    assert(test_pool.free_frames == TEST_FREE_FRAMES);
+}
+
+void test_frame_pool_exhaust(void) {
+    uint32_t i;
+
+    test_pool_init();
+
+    for (i = 0; i < TEST_FREE_FRAMES; i++)
+        assert(frame_pool_alloc(&test_pool) != FRAME_NONE);
+    assert(frame_pool_alloc(&test_pool) == FRAME_NONE);
+    assert(frame_pool_alloc_contig(&test_pool, 1, 1) == FRAME_NONE);
+
+    frame_pool_free(&test_pool, 0x1FFF000);
+    assert(frame_pool_alloc(&test_pool) == 0x1FFF000);
+}
+
+void test_frame_pool_alloc_contig(void) {
+    uint32_t a, b, c;
+
+    test_pool_init();
+
+    a = frame_pool_alloc(&test_pool);
+    b = frame_pool_alloc_contig(&test_pool, 16, 16);
+    assert(b == 0x110000);                          // 64 KiB aligned.
+    c = frame_pool_alloc_contig(&test_pool, 3, 1);
+    assert(c == 0x101000);                          // First fit.
+    assert(test_pool.free_frames == TEST_FREE_FRAMES - 20);
+
+    frame_pool_free_contig(&test_pool, b, 16);
+    b = frame_pool_alloc_contig(&test_pool, 40, 1); // Spans bitmap words.
+    assert(b == 0x104000);
+    assert(frame_pool_alloc_contig(&test_pool, TEST_FREE_FRAMES, 1) ==
+           FRAME_NONE);
+
+    frame_pool_free(&test_pool, a);
+    frame_pool_free_contig(&test_pool, b, 40);
+    frame_pool_free_contig(&test_pool, c, 3);
+    assert(test_pool.free_frames == TEST_FREE_FRAMES);
+    assert(frame_pool_alloc_contig(&test_pool, TEST_FREE_FRAMES, 1) ==
+           0x100000);
+}
+
+/*
+    Reports the average TSC cycles per operation, for single frame
+    allocations and frees of the whole test pool, and for contiguous
+    allocations of 8 frames.
+*/
+void bench_frame_pool(void) {
+    uint64_t t;
+    uint32_t i, n;
+
+    test_pool_init();
+
+    t = read_tsc();
+    for (i = 0; i < TEST_FREE_FRAMES; i++)
+        test_frames[i] = frame_pool_alloc(&test_pool);
+    print_cycles("frame_alloc: per alloc ", read_tsc() - t, TEST_FREE_FRAMES);
+
+    t = read_tsc();
+    for (i = 0; i < TEST_FREE_FRAMES; i++)
+        frame_pool_free(&test_pool, test_frames[i]);
+    print_cycles("frame_alloc: per free ", read_tsc() - t, TEST_FREE_FRAMES);
+
+    t = read_tsc();
+    for (n = 0; n < TEST_FREE_FRAMES / 8; n++)
+        test_frames[n] = frame_pool_alloc_contig(&test_pool, 8, 1);
+    print_cycles("frame_alloc: per 8 frame alloc_contig ", read_tsc() - t, n);
+
+    for (i = 0; i < n; i++)
+        frame_pool_free_contig(&test_pool, test_frames[i], 8);
+    assert(test_pool.free_frames == TEST_FREE_FRAMES);
+}
+
+void test_all_frame_alloc(void) {
+    test_frame_pool_init();
+    test_frame_pool_alloc_free();
+    test_frame_pool_exhaust();
+    test_frame_pool_alloc_contig();
+    bench_frame_pool();
+}
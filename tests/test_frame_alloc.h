@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for frame_alloc.c/h.
+*/
+#ifndef __TEST_FRAME_ALLOC_H__
+#define __TEST_FRAME_ALLOC_H__
+
+void test_all_frame_alloc(void);
+
+#endif
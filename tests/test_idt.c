@@ -1,4 +1,17 @@
 #include "../kernel/idt.h"
+#include "../include/assert.h"
+#include "../include/stddef.h"
+
+#define TEST_VN (0x80)
+
+static volatile uint32_t test_count;
+static void *test_ctx;
+
+static void test_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    assert(vn == TEST_VN && err_code == 0);
+    test_ctx = ctx;
+    test_count++;
+}
 
 void test_int_0(void) {
     /* @IMPORTANT `INT n` instructions always skip pushing error codes onto the
@@ -19,15 +32,38 @@ void test_v0_intr(void) {
 
 
 void test_v13_intr(void) {
-    /* This generates the #GP/13 interrupt since the IDT currently has only 33
-       entries. If this test fails, check if the number of IDT entries has
-       changed. Notice that err_code->seg_sel_idx == 34, which equals the INT
-       instruction immediate operand below. */
-    __asm__("int $34");
+    /* This generates the #GP/13 interrupt since the GDT has no descriptor at
+       index 0x100. Notice that err_code->seg_sel_idx == 0x100, the selector
+       below shifted right by 3. */
+    __asm__("mov $0x800, %ax");
+    __asm__("mov %ax, %fs");
+}
+
+/*
+    A handler installed at run time on a vector beyond the legacy ones, and
+    the IRQ lines already taken by the drivers.
+*/
+void test_intr_register(void) {
+    static int dev;
+
+    assert(intr_register(TEST_VN, test_handler, &dev) == 0);
+    assert(intr_register(TEST_VN, test_handler, NULL) == -1);
+    test_count = 0;
+    __asm__("int $0x80");
+    assert(test_count == 1 && test_ctx == &dev);
+
+    intr_unregister(TEST_VN);
+    assert(intr_register(TEST_VN, test_handler, NULL) == 0);
+    __asm__("int $0x80");
+    assert(test_count == 2 && test_ctx == NULL);
+    intr_unregister(TEST_VN);
+
+    assert(request_irq(1, test_handler, NULL) == -1); // The keyboard's.
 }
 
 void test_all_idt(void) {
     init_interrupts();
+    test_intr_register();
 
     /* @remark These test cases other than those using the `INT n` instruction
     must remain commented because most interrupts push a return address (EIP)
@@ -0,0 +1,93 @@
+#include "../kernel/idt.h"
+#include "../kernel/intr_stats.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stddef.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+#define TEST_INT3_COUNT (1000)
+#define TEST_VN (0x81)
+#define TEST_SPIN (5000)
+
+/*
+    A handler that takes at least TEST_SPIN cycles.
+*/
+static void test_slow_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    uint64_t t = read_tsc();
+
+    if (vn || err_code || ctx) { // Suppress warning.
+        ;
+    }
+    while (read_tsc() - t < TEST_SPIN)
+        ;
+}
+
+static uint32_t hist_sum(const intr_stats_t *s) {
+    uint32_t n = 0, i;
+
+    for (i = 0; i < INTR_HIST_BUCKETS; i++)
+        n += s->hist[i];
+    return n;
+}
+
+void test_intr_stats_int3(void) {
+    const intr_stats_t *s = intr_stats_get(3);
+    uint32_t i;
+
+    intr_stats_reset();
+    assert(s->count == 0 && hist_sum(s) == 0);
+
+    for (i = 0; i < TEST_INT3_COUNT; i++)
+        __asm__ volatile("int3");
+
+    assert(s->count == TEST_INT3_COUNT);
+    assert(hist_sum(s) == TEST_INT3_COUNT);
+    assert(s->min <= s->max);
+    assert(s->total >= (uint64_t) s->min * s->count);
+    assert(s->total <= (uint64_t) s->max * s->count);
+    assert(intr_stats_get(4)->count == 0);
+}
+
+void test_intr_stats_slow(void) {
+    const intr_stats_t *s = intr_stats_get(TEST_VN);
+    uint32_t b;
+
+    assert(intr_register(TEST_VN, test_slow_handler, NULL) == 0);
+    __asm__ volatile("int $0x81");
+    __asm__ volatile("int $0x81");
+    intr_unregister(TEST_VN);
+
+    // 5000 cycles is in bucket 12, [4096, 8192), or above.
+    assert(s->count == 2 && s->min >= TEST_SPIN);
+    for (b = 0; b < 12; b++)
+        assert(s->hist[b] == 0);
+    assert(hist_sum(s) == 2);
+}
+
+/*
+    The INT3 round trip versus the latency recorded for it, the difference is
+    the interrupt delivery, the register saves, the recording and the IRET.
+*/
+void bench_intr_stats(void) {
+    const intr_stats_t *s = intr_stats_get(3);
+    uint64_t t, round_trip;
+    uint32_t i;
+
+    intr_stats_reset();
+    t = read_tsc();
+    for (i = 0; i < TEST_INT3_COUNT; i++)
+        __asm__ volatile("int3");
+    round_trip = read_tsc() - t;
+
+    kprintf("intr_stats: int3 round trip %u cycles, handler avg %u min %u "
+            "max %u cycles\n", (uint32_t) (round_trip / TEST_INT3_COUNT),
+            (uint32_t) (s->total / s->count), s->min, s->max);
+    intr_stats_dump();
+}
+
+void test_all_intr_stats(void) {
+    test_intr_stats_int3();
+    test_intr_stats_slow();
+    bench_intr_stats();
+}
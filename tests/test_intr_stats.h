@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for intr_stats.c/h.
+*/
+#ifndef __TEST_INTR_STATS_H__
+#define __TEST_INTR_STATS_H__
+
+void test_all_intr_stats(void);
+
+#endif
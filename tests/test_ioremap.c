@@ -0,0 +1,118 @@
+#include "test_all.h"
+#include "../kernel/ioremap.h"
+#include "../kernel/paging.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+/*
+    The VGA text memory window and its size, see screen.c. TEST_OFFSET is not
+    page aligned on purpose.
+*/
+#define TEST_VGA (0xB8000)
+#define TEST_VGA_SIZE (0x8000)
+#define TEST_OFFSET (0x123)
+#define TEST_REDRAWS (16)
+#define TEST_SCROLLS (256)
+
+/*
+    The expected PAT, see pat_init().
+*/
+#define TEST_PAT (0x0007040600070106ULL)
+
+void test_ioremap_map(void) {
+    uint8_t *p, *q;
+
+    p = ioremap(TEST_VGA + TEST_OFFSET, 2);
+    assert(p != NULL);
+    assert(((uint32_t) p & (PAGE_SIZE - 1)) == TEST_OFFSET);
+    assert(paging_translate((uint32_t) p) == TEST_VGA + TEST_OFFSET);
+
+    // Both mappings alias the same memory.
+    q = (uint8_t *) TEST_VGA + TEST_OFFSET;
+    assert(*p == *q);
+
+    iounmap(p, 2);
+    assert(paging_translate((uint32_t) p) == PAGING_NONE);
+
+    p = ioremap_wc(TEST_VGA, TEST_VGA_SIZE);
+    assert(p != NULL);
+    assert(paging_translate((uint32_t) p) == TEST_VGA);
+    assert(paging_translate((uint32_t) p + PAGE_SIZE - 1) ==
+           TEST_VGA + PAGE_SIZE - 1);
+    iounmap(p, TEST_VGA_SIZE);
+
+    if (pat_enabled())
+        assert(rdmsr(MSR_IA32_PAT) == TEST_PAT);
+}
+
+/*
+    Redraws every cell of the screen.
+*/
+static void redraw(void) {
+    int row, col;
+
+    for (row = 0; row < 25; row++)
+        for (col = 0; col < 80; col++)
+            print_ch_at('#', 0, row, col);
+    screen_flush();
+}
+
+/*
+    Scrolls by printing newlines on the last row.
+*/
+static void scroll(void) {
+    print_ch_at('\n', 0, 24, 0);
+    screen_flush();
+}
+
+/*
+    Compares full-screen redraws and scrolls through the identity map, which
+    the MTRRs make uncacheable for the legacy VGA range, with the write
+    combining mapping. Clears the screen afterwards.
+*/
+void bench_ioremap_vga(void) {
+    void *base = screen_get_base();
+    uint64_t t, redraw_uc, scroll_uc, redraw_wc, scroll_wc;
+    uint8_t *wc;
+    uint32_t i;
+
+    wc = ioremap_wc(TEST_VGA, TEST_VGA_SIZE);
+    assert(wc != NULL);
+
+    screen_set_base(NULL);
+    t = read_tsc();
+    for (i = 0; i < TEST_REDRAWS; i++)
+        redraw();
+    redraw_uc = read_tsc() - t;
+    t = read_tsc();
+    for (i = 0; i < TEST_SCROLLS; i++)
+        scroll();
+    scroll_uc = read_tsc() - t;
+
+    screen_set_base(wc);
+    t = read_tsc();
+    for (i = 0; i < TEST_REDRAWS; i++)
+        redraw();
+    redraw_wc = read_tsc() - t;
+    t = read_tsc();
+    for (i = 0; i < TEST_SCROLLS; i++)
+        scroll();
+    scroll_wc = read_tsc() - t;
+
+    screen_set_base(base);
+    iounmap(wc, TEST_VGA_SIZE);
+    clear_screen();
+
+    print(pat_enabled() ? "ioremap: PAT on\n" : "ioremap: PAT off\n");
+    print_cycles("ioremap: redraw uc ", redraw_uc, TEST_REDRAWS);
+    print_cycles("ioremap: redraw wc ", redraw_wc, TEST_REDRAWS);
+    print_cycles("ioremap: scroll uc ", scroll_uc, TEST_SCROLLS);
+    print_cycles("ioremap: scroll wc ", scroll_wc, TEST_SCROLLS);
+}
+
+void test_all_ioremap(void) {
+    test_ioremap_map();
+    bench_ioremap_vga();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for ioremap.c/h.
+*/
+#ifndef __TEST_IOREMAP_H__
+#define __TEST_IOREMAP_H__
+
+void test_all_ioremap(void);
+
+#endif
@@ -0,0 +1,178 @@
+#include "../kernel/klog.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../include/string.h"
+#include "../drivers/screen.h"
+
+/*
+    The test consumer keeps the sequence numbers and levels of the last
+    TEST_KEEP records it is passed and the first character of their message.
+*/
+#define TEST_KEEP (KLOG_RECORDS)
+#define TEST_BENCH (1000)
+
+static uint32_t test_n, test_flushes;
+static uint32_t test_seq[TEST_KEEP];
+static uint8_t test_level[TEST_KEEP];
+static uint16_t test_len[TEST_KEEP];
+static char test_msg[TEST_KEEP][8];
+static uint64_t test_tsc;
+
+static void test_write(const klog_record_t *r) {
+    uint32_t i = test_n++ % TEST_KEEP;
+
+    assert(r->tsc >= test_tsc);
+    test_tsc = r->tsc;
+    test_seq[i] = r->seq - 1;
+    test_level[i] = r->level;
+    test_len[i] = r->len;
+    memcpy(test_msg[i], r->msg, sizeof(test_msg[i]));
+    test_msg[i][sizeof(test_msg[i]) - 1] = '\0';
+}
+
+static void test_flush(void) {
+    test_flushes++;
+}
+
+static klog_consumer_t test_consumer = {
+    "test", KLOG_INFO, test_write, test_flush, 0, 0, NULL
+};
+
+/*
+    Logs without the VGA console, the tests log hundreds of records.
+*/
+static void test_begin(void) {
+    klog_drain();
+    klog_unregister_consumer(&klog_vga);
+    klog_register_consumer(&test_consumer);
+    test_consumer.next_seq = klog_seq();
+    test_n = 0;
+    test_flushes = 0;
+    test_tsc = 0;
+}
+
+static void test_end(void) {
+    klog_unregister_consumer(&test_consumer);
+    klog_register_consumer(&klog_vga);
+    klog_vga.next_seq = klog_seq();
+}
+
+void test_klog_drain(void) {
+    uint32_t seq, v = 1;
+
+    test_begin();
+    seq = klog_seq();
+
+    klog(KLOG_INFO, "a%d", v);
+    klog(KLOG_DEBUG, "filtered");
+    klog(KLOG_ERR, "c");
+    assert(klog_seq() == seq + 3);
+    v = 2; // The arguments were copied, the message is formatted later.
+
+    // Nothing is passed before the drain, then all at once and flushed once.
+    assert(test_n == 0);
+    klog_drain();
+    assert(test_n == 2 && test_flushes == 1);
+    assert(test_seq[0] == seq && test_level[0] == KLOG_INFO);
+    assert(strcmp(test_msg[0], "a1") == 0 && test_len[0] == 2);
+    assert(test_seq[1] == seq + 2 && test_level[1] == KLOG_ERR);
+    assert(strcmp(test_msg[1], "c") == 0 && test_len[1] == 1);
+    assert(test_consumer.next_seq == klog_seq());
+
+    // Nothing new, no flush.
+    klog_drain();
+    assert(test_n == 2 && test_flushes == 1);
+
+    // A long long takes 2 argument words.
+    klog(KLOG_INFO, "%llx%s%c", 0x12ULL, "3", '4');
+    klog_drain();
+    assert(test_n == 3 && strcmp(test_msg[2], "1234") == 0);
+
+    // Only the words the format takes are copied, '*' takes one, %% none.
+    klog(KLOG_INFO, "%*d%%%lld", 3, 1, -2LL);
+    klog_drain();
+    assert(test_n == 4 && strcmp(test_msg[3], "  1%-2") == 0);
+
+    // A format taking more than KLOG_ARGS words isn't formatted.
+    klog(KLOG_INFO, "%llu%llu%llu%llu%llu%llu", 1ULL, 2ULL, 3ULL, 4ULL, 5ULL,
+         6ULL);
+    klog_drain();
+    assert(test_n == 5 && strcmp(test_msg[4], "klog: t") == 0);
+
+    test_end();
+}
+
+void test_klog_overrun(void) {
+    uint32_t seq, i;
+    char s[2] = { 0, 0 };
+
+    test_begin();
+    seq = klog_seq();
+
+    // The oldest 10 records are overwritten before the drain.
+    for (i = 0; i < KLOG_RECORDS + 10; i++)
+        klog(KLOG_INFO, "%c", 'a' + i % 26);
+    klog_drain();
+    assert(test_consumer.dropped == 10);
+    assert(test_n == KLOG_RECORDS);
+    for (i = 0; i < KLOG_RECORDS; i++) {
+        assert(test_seq[i] == seq + 10 + i);
+        s[0] = 'a' + (10 + i) % 26;
+        assert(strcmp(test_msg[i], s) == 0);
+    }
+
+    // A long message is truncated.
+    klog(KLOG_INFO, "%0*d", KLOG_MSG_MAX + 10, 0);
+    klog_drain();
+    i = (test_n - 1) % TEST_KEEP;
+    assert(test_len[i] == KLOG_MSG_MAX - 1 && test_msg[i][0] == '0');
+
+    test_end();
+}
+
+/*
+    The cost of a log line for its producer, e.g. an interrupt handler:
+    klog() versus kprintf() straight to the screen. Then the cost of draining
+    the records to the screen.
+*/
+void bench_klog(void) {
+    uint64_t t, logged, fixed, printed, drained;
+    uint32_t i;
+
+    test_begin();
+    klog_unregister_consumer(&test_consumer);
+
+    t = read_tsc();
+    for (i = 0; i < TEST_BENCH; i++)
+        klog(KLOG_DEBUG, "scan code %02x", i & 0xFF);
+    logged = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_BENCH; i++)
+        klog(KLOG_DEBUG, "scan code");
+    fixed = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_BENCH; i++)
+        kprintf("scan code %02x\n", i & 0xFF);
+    printed = read_tsc() - t;
+
+    klog_register_consumer(&klog_vga);
+    klog_vga.next_seq = klog_seq() - KLOG_RECORDS;
+    t = read_tsc();
+    klog_drain();
+    drained = read_tsc() - t;
+
+    kprintf("klog: per line, klog %llu cycles\n", logged / TEST_BENCH);
+    kprintf("klog: per line, klog no args %llu cycles\n", fixed / TEST_BENCH);
+    kprintf("klog: per line, kprintf %llu cycles\n", printed / TEST_BENCH);
+    kprintf("klog: per line, drain to vga %llu cycles\n",
+            drained / KLOG_RECORDS);
+}
+
+void test_all_klog(void) {
+    test_klog_drain();
+    test_klog_overrun();
+    bench_klog();
+}
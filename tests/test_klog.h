@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for klog.c/h.
+*/
+#ifndef __TEST_KLOG_H__
+#define __TEST_KLOG_H__
+
+void test_all_klog(void);
+
+#endif
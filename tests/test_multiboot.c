@@ -0,0 +1,83 @@
+#include "../kernel/multiboot.h"
+#include "../include/assert.h"
+
+/*
+    A Multiboot memory map like the one QEMU passes for 128 MiB of RAM. The
+    second entry has a larger size field, which must be honored.
+*/
+static struct {
+    multiboot_mmap_entry_t e0;
+    multiboot_mmap_entry_t e1;
+    uint32_t e1_extra;
+    multiboot_mmap_entry_t e2;
+} __attribute__((packed)) test_mmap = {
+    {20, 0x00000000ULL, 0x0009FC00ULL, E820_USABLE},
+    {24, 0x0009FC00ULL, 0x00000400ULL, E820_RESERVED},
+    0,
+    {20, 0x00100000ULL, 0x07EE0000ULL, E820_USABLE},
+};
+
+static multiboot_module_t test_mods[2] = {
+    {0x00200000, 0x00201000, 0, 0},
+    {0x00201000, 0x00201800, 0, 0},
+};
+
+void test_multiboot_mmap(void) {
+    multiboot_info_t mbi;
+    boot_info_t bi;
+
+    mbi.flags = MULTIBOOT_INFO_MEMORY | MULTIBOOT_INFO_MEM_MAP;
+    mbi.mem_lower = 639;
+    mbi.mem_upper = 129920;
+    mbi.mmap_addr = (uint32_t) &test_mmap;
+    mbi.mmap_length = sizeof(test_mmap);
+
+    multiboot_to_boot_info(&mbi, &bi);
+
+    assert(bi.boot_drive == BOOT_INFO_DRIVE_NONE);
+    assert(bi.mmap_len == 3);
+    assert(bi.mmap[1].base == 0x0009FC00ULL);
+    assert(bi.mmap[1].type == E820_RESERVED);
+    assert(bi.mmap[2].base == 0x00100000ULL);
+    assert(bi.mmap[2].length == 0x07EE0000ULL);
+    assert(bi.mods_len == 0);
+}
+
+void test_multiboot_mem_lower_upper(void) {
+    multiboot_info_t mbi;
+    boot_info_t bi;
+
+    mbi.flags = MULTIBOOT_INFO_MEMORY | MULTIBOOT_INFO_BOOTDEV;
+    mbi.mem_lower = 639;
+    mbi.mem_upper = 129920;
+    mbi.boot_device = 0x80FFFFFF;
+
+    multiboot_to_boot_info(&mbi, &bi);
+
+    assert(bi.boot_drive == 0x80);
+    assert(bi.mmap_len == 2);
+    assert(boot_info_usable_size(&bi) == (639ULL + 129920ULL) << 10);
+    assert(boot_info_usable_end(&bi) == 0x100000ULL + (129920ULL << 10));
+}
+
+void test_multiboot_mods(void) {
+    multiboot_info_t mbi;
+    boot_info_t bi;
+
+    mbi.flags = MULTIBOOT_INFO_MODS;
+    mbi.mods_count = 2;
+    mbi.mods_addr = (uint32_t) test_mods;
+
+    multiboot_to_boot_info(&mbi, &bi);
+
+    assert(bi.mmap_len == 0);
+    assert(bi.mods_len == 2);
+    assert(bi.mods[1].start == 0x00201000);
+    assert(bi.mods[1].end == 0x00201800);
+}
+
+void test_all_multiboot(void) {
+    test_multiboot_mmap();
+    test_multiboot_mem_lower_upper();
+    test_multiboot_mods();
+}
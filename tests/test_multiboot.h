@@ -0,0 +1,9 @@
+/*!
+    @header Test cases for multiboot.c/h.
+*/
+#ifndef __TEST_MULTIBOOT_H__
+#define __TEST_MULTIBOOT_H__
+
+void test_all_multiboot(void);
+
+#endif
@@ -0,0 +1,96 @@
+#include "test_all.h"
+#include "../kernel/page_fault.h"
+#include "../kernel/paging.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../include/string.h"
+#include "../drivers/screen.h"
+
+/*
+    The lazy regions live above the identity map, in a 4 MiB region of their
+    own. TEST_BENCH_PAGES pages are committed by the benchmark.
+*/
+#define TEST_REGION (0xD0400000)
+#define TEST_PAGES (16)
+#define TEST_BIG_SIZE (0x4000000)
+#define TEST_BENCH_PAGES (256)
+
+void test_page_fault_demand_zero(void) {
+    const lazy_region_t *r;
+    volatile uint32_t *p;
+    uint32_t faults = page_fault_count();
+    uint32_t free_frames;
+
+    r = lazy_region_register("test", TEST_REGION, TEST_PAGES * PAGE_SIZE,
+                             PTE_WRITE);
+    assert(r != NULL);
+    assert(paging_translate(TEST_REGION) == PAGING_NONE);
+
+    // The first touch of a page commits a zeroed frame, the second is free.
+    p = (volatile uint32_t *) TEST_REGION;
+    assert(p[0] == 0);
+    assert(r->faults == 1 && page_fault_count() == faults + 1);
+    p[1] = 42;
+    assert(p[1] == 42 && r->faults == 1);
+    assert(paging_translate(TEST_REGION) != PAGING_NONE);
+
+    // A write fault on a new page.
+    p = (volatile uint32_t *) (TEST_REGION + 5 * PAGE_SIZE + 100);
+    *p = 7;
+    assert(*p == 7 && r->faults == 2);
+    assert(paging_translate(TEST_REGION + PAGE_SIZE) == PAGING_NONE);
+
+    free_frames = frame_free_count();
+    assert(lazy_region_release(r) == 2);
+    assert(frame_free_count() == free_frames + 2);
+    assert(paging_translate(TEST_REGION) == PAGING_NONE);
+}
+
+/*
+    Reserves a TEST_BIG_SIZE region and touches TEST_BENCH_PAGES of its pages.
+    Compares with committing the same pages up front, zeroed and mapped. Only
+    the touched pages cost memory, reserving the region costs nothing.
+*/
+void bench_page_fault(void) {
+    uint32_t free_frames = frame_free_count();
+    uint64_t t, reserve, lazy, eager;
+    const lazy_region_t *r;
+    uint32_t i, f;
+
+    t = read_tsc();
+    r = lazy_region_register("bench", TEST_REGION, TEST_BIG_SIZE, PTE_WRITE);
+    reserve = read_tsc() - t;
+    assert(frame_free_count() == free_frames);
+
+    t = read_tsc();
+    for (i = 0; i < TEST_BENCH_PAGES; i++)
+        *(volatile uint32_t *) (TEST_REGION + i * PAGE_SIZE) = i;
+    lazy = read_tsc() - t;
+    assert(r->faults == TEST_BENCH_PAGES);
+    lazy_region_release(r);
+
+    t = read_tsc();
+    for (i = 0; i < TEST_BENCH_PAGES; i++) {
+        f = frame_alloc();
+        memset((void *) f, 0, PAGE_SIZE);
+        paging_map(TEST_REGION + i * PAGE_SIZE, f, PTE_WRITE);
+        *(volatile uint32_t *) (TEST_REGION + i * PAGE_SIZE) = i;
+    }
+    eager = read_tsc() - t;
+    for (i = 0; i < TEST_BENCH_PAGES; i++) {
+        f = paging_translate(TEST_REGION + i * PAGE_SIZE);
+        paging_unmap(TEST_REGION + i * PAGE_SIZE);
+        frame_free(f);
+    }
+
+    print_cycles("page_fault: reserve 64 MiB ", reserve, 1);
+    print_cycles("page_fault: demand-zero per page ", lazy, TEST_BENCH_PAGES);
+    print_cycles("page_fault: eager per page ", eager, TEST_BENCH_PAGES);
+}
+
+void test_all_page_fault(void) {
+    test_page_fault_demand_zero();
+    bench_page_fault();
+}
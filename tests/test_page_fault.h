@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for page_fault.c/h.
+*/
+#ifndef __TEST_PAGE_FAULT_H__
+#define __TEST_PAGE_FAULT_H__
+
+void test_all_page_fault(void);
+
+#endif
@@ -0,0 +1,215 @@
+#include "test_all.h"
+#include "../kernel/paging.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../kernel/idt.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+/*
+    TEST_VIRT is above the identity map, QEMU's default 128 MiB of RAM are
+    far below it.
+*/
+#define TEST_VIRT (0xD0000000)
+#define TEST_PATTERN (0x5EED1234U)
+#define TEST_INT3_COUNT (10000)
+#define TEST_BATCH_SMALL (8)
+#define TEST_BATCH_PAGES (256)
+#define CPUID_EDX_PGE (1U << 13)
+
+static uint32_t test_static;
+
+void test_paging_identity(void) {
+    assert(paging_enabled());
+    assert(paging_translate((uint32_t) &test_static) ==
+           (uint32_t) &test_static);
+    assert(paging_translate(0xB8000) == 0xB8000);
+    assert(paging_translate(TEST_VIRT) == PAGING_NONE);
+}
+
+void test_paging_map(void) {
+    uint32_t f = frame_alloc();
+    volatile uint32_t *v = (volatile uint32_t *) TEST_VIRT;
+    volatile uint32_t *p = (volatile uint32_t *) f;
+
+    assert(f != FRAME_NONE);
+    *p = TEST_PATTERN;
+
+    assert(paging_map(TEST_VIRT, f, PTE_WRITE));
+    assert(paging_translate(TEST_VIRT + 4) == f + 4);
+    assert(paging_translate(TEST_VIRT + PAGE_SIZE) == PAGING_NONE);
+    assert(*v == TEST_PATTERN);
+    v[1] = ~TEST_PATTERN;
+    assert(p[1] == ~TEST_PATTERN);
+
+    paging_unmap(TEST_VIRT);
+    assert(paging_translate(TEST_VIRT) == PAGING_NONE);
+
+    frame_free(f);
+}
+
+void test_paging_split(void) {
+    uint32_t f = frame_alloc();
+    uint32_t base = f & ~(PAGE_LARGE_SIZE - 1);
+
+    // Mapping a 4 KiB page inside the identity map splits its 4 MiB page,
+    // the rest of the 4 MiB keeps its mapping.
+    assert(paging_map(f, f, PTE_WRITE));
+    assert(paging_translate(base) == base);
+    assert(paging_translate(base + PAGE_LARGE_SIZE - 1) ==
+           base + PAGE_LARGE_SIZE - 1);
+    assert(paging_translate(f + 8) == f + 8);
+    test_static = TEST_PATTERN;
+    assert(test_static == TEST_PATTERN);
+
+    frame_free(f);
+}
+
+void test_paging_global(void) {
+    cpuid_regs_t r;
+
+    cpuid(1, &r);
+    assert(paging_global_enabled() == ((r.edx & CPUID_EDX_PGE) != 0));
+}
+
+/*
+    Maps n pages at TEST_VIRT to frame f, in a batch if b is not NULL.
+*/
+static void test_map_pages(tlb_batch_t *b, uint32_t n, uint32_t f,
+                           uint32_t flags) {
+    uint32_t i;
+
+    if (b)
+        tlb_batch_begin(b);
+    for (i = 0; i < n; i++)
+        assert(paging_map(TEST_VIRT + i * PAGE_SIZE, f, flags));
+    if (b)
+        tlb_batch_end(b);
+}
+
+static void test_unmap_pages(tlb_batch_t *b, uint32_t n) {
+    uint32_t i;
+
+    if (b)
+        tlb_batch_begin(b);
+    for (i = 0; i < n; i++)
+        paging_unmap(TEST_VIRT + i * PAGE_SIZE);
+    if (b)
+        tlb_batch_end(b);
+}
+
+void test_tlb_batch(void) {
+    uint32_t f = frame_alloc();
+    tlb_stats_t s0, s1;
+    tlb_batch_t b;
+
+    // New mappings need no invalidation.
+    tlb_stats(&s0);
+    test_map_pages(&b, TEST_BATCH_SMALL, f, PTE_WRITE);
+    tlb_stats(&s1);
+    assert(b.n == 0 && s1.invlpg == s0.invlpg && s1.batches == s0.batches + 1);
+
+    // A small batch of changed mappings takes one INVLPG per page.
+    test_map_pages(&b, TEST_BATCH_SMALL, f, 0);
+    tlb_stats(&s0);
+    assert(b.n == TEST_BATCH_SMALL);
+    assert(s0.invlpg == s1.invlpg + TEST_BATCH_SMALL && s0.flush == s1.flush);
+    assert(*(volatile uint32_t *) TEST_VIRT == *(volatile uint32_t *) f);
+    test_unmap_pages(NULL, TEST_BATCH_SMALL);
+
+    // A large batch takes a single full flush, global only if needed.
+    test_map_pages(NULL, TEST_BATCH_PAGES, f, PTE_WRITE);
+    tlb_stats(&s0);
+    test_unmap_pages(&b, TEST_BATCH_PAGES);
+    tlb_stats(&s1);
+    assert(b.n == TEST_BATCH_PAGES && !b.global);
+    assert(s1.invlpg == s0.invlpg && s1.flush == s0.flush + 1);
+    assert(paging_translate(TEST_VIRT) == PAGING_NONE);
+
+    test_map_pages(NULL, TEST_BATCH_PAGES, f, PTE_WRITE | PTE_GLOBAL);
+    tlb_stats(&s0);
+    test_unmap_pages(&b, TEST_BATCH_PAGES);
+    tlb_stats(&s1);
+    assert(b.global);
+    assert(s1.flush_global + s1.flush == s0.flush_global + s0.flush + 1);
+
+    frame_free(f);
+}
+
+static uint64_t time_int3(void) {
+    uint64_t t;
+    uint32_t i;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_INT3_COUNT; i++)
+        __asm__ volatile("int3");
+
+    return read_tsc() - t;
+}
+
+/*
+    Times TEST_INT3_COUNT round trips through the interrupt path, INT3 to the
+    #BP handler and back, with paging off and on. The kernel, its stack and
+    the IDT are in the first 4 MiB page, the paged path should cost no more
+    than the unpaged one.
+*/
+void bench_paging_int3(void) {
+    uint32_t count = intr_bp_count;
+    uint64_t off, on;
+
+    paging_disable();
+    time_int3();                        // Warm up the caches.
+    off = time_int3();
+    paging_enable();
+    time_int3();
+    on = time_int3();
+
+    assert(intr_bp_count == count + 4 * TEST_INT3_COUNT);
+
+    print_cycles("paging: int3 unpaged ", off, TEST_INT3_COUNT);
+    print_cycles("paging: int3 4 MiB paged ", on, TEST_INT3_COUNT);
+}
+
+/*
+    Remaps and touches TEST_BATCH_PAGES pages, with an INVLPG per page and in
+    a batch with a single flush. Reports the average TSC cycles per page.
+*/
+void bench_tlb_batch(void) {
+    uint32_t f = frame_alloc();
+    uint64_t t, single, batched;
+    tlb_batch_t b;
+    uint32_t i;
+
+    test_map_pages(NULL, TEST_BATCH_PAGES, f, PTE_WRITE);
+
+    t = read_tsc();
+    test_map_pages(NULL, TEST_BATCH_PAGES, f, PTE_WRITE);
+    for (i = 0; i < TEST_BATCH_PAGES; i++)
+        (void) *(volatile uint32_t *) (TEST_VIRT + i * PAGE_SIZE);
+    single = read_tsc() - t;
+
+    t = read_tsc();
+    test_map_pages(&b, TEST_BATCH_PAGES, f, PTE_WRITE);
+    for (i = 0; i < TEST_BATCH_PAGES; i++)
+        (void) *(volatile uint32_t *) (TEST_VIRT + i * PAGE_SIZE);
+    batched = read_tsc() - t;
+
+    test_unmap_pages(&b, TEST_BATCH_PAGES);
+    frame_free(f);
+
+    print_cycles("paging: remap per page, invlpg ", single, TEST_BATCH_PAGES);
+    print_cycles("paging: remap per page, batched ", batched,
+                 TEST_BATCH_PAGES);
+    tlb_print_stats();
+}
+
+void test_all_paging(void) {
+    test_paging_identity();
+    test_paging_map();
+    test_paging_split();
+    test_paging_global();
+    test_tlb_batch();
+    bench_paging_int3();
+    bench_tlb_batch();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for paging.c/h.
+*/
+#ifndef __TEST_PAGING_H__
+#define __TEST_PAGING_H__
+
+void test_all_paging(void);
+
+#endif
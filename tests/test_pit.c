@@ -0,0 +1,116 @@
+#include "../drivers/pit.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stddef.h"
+#include "../include/stdio.h"
+
+#define TEST_TICKS (20)
+#define TEST_ONESHOT_US (5000)
+#define TEST_TIMEOUT (100000000ULL)
+
+static volatile uint32_t events;
+static volatile uint64_t event_tsc;
+static uint32_t slow_tick;
+
+static void test_event(void *ctx) {
+    if (ctx) { // Suppress warning.
+        ;
+    }
+    event_tsc = read_tsc();
+    events++;
+}
+
+static void wait_jiffy(void) {
+    uint32_t j = jiffies;
+    uint64_t t = read_tsc();
+
+    while (jiffies == j)
+        assert(read_tsc() - t < TEST_TIMEOUT);
+}
+
+static void spin(uint64_t cycles) {
+    uint64_t t = read_tsc();
+
+    while (read_tsc() - t < cycles)
+        ;
+}
+
+/*
+    Cycles per tick at rate hz.
+*/
+static uint32_t time_tick(uint32_t hz) {
+    uint64_t t;
+    uint32_t i;
+
+    assert(pit_clock_event.set_periodic(hz) == 0);
+    assert(pit_get_hz() == hz);
+    wait_jiffy(); // Start on a tick.
+    t = read_tsc();
+    for (i = 0; i < TEST_TICKS; i++)
+        wait_jiffy();
+    return (read_tsc() - t) / TEST_TICKS;
+}
+
+/*
+    The tick is 10 times shorter at 1000 Hz than at 100 Hz, and the handler is
+    called on each.
+*/
+void test_pit_periodic(void) {
+    uint32_t e = events, fast;
+
+    assert(pit_clock_event.set_periodic(PIT_MIN_HZ - 1) == -1);
+    assert(pit_clock_event.set_periodic(PIT_MAX_HZ + 1) == -1);
+
+    pit_clock_event.handler = test_event;
+    slow_tick = time_tick(100);
+    fast = time_tick(1000);
+    assert(events - e >= 2 * TEST_TICKS);
+    assert(fast * 5 < slow_tick && slow_tick < fast * 20);
+
+    kprintf("pit: tick 100 Hz %u cycles, 1000 Hz %u cycles\n", slow_tick,
+            fast);
+}
+
+/*
+    A one-shot event fires once, after its delay, and stops the tick. A
+    shutdown cancels it.
+*/
+void test_pit_oneshot(void) {
+    uint32_t e, j;
+    uint64_t t, delay;
+
+    assert(pit_clock_event.set_next_event(0) == -1);
+    assert(pit_clock_event.set_next_event(pit_clock_event.max_delta_us + 1)
+           == -1);
+
+    e = events;
+    t = read_tsc();
+    assert(pit_clock_event.set_next_event(TEST_ONESHOT_US) == 0);
+    j = jiffies;
+    assert(pit_get_hz() == 0);
+    while (events == e)
+        assert(read_tsc() - t < TEST_TIMEOUT);
+    delay = event_tsc - t;
+
+    spin(2 * delay);
+    assert(events == e + 1 && jiffies == j);
+    // 5 ms is half a tick at 100 Hz.
+    assert(delay > slow_tick / 4 && delay < slow_tick);
+
+    assert(pit_clock_event.set_next_event(TEST_ONESHOT_US) == 0);
+    pit_clock_event.shutdown();
+    spin(2 * delay);
+    assert(events == e + 1);
+
+    kprintf("pit: one-shot %u us in %u cycles\n", TEST_ONESHOT_US,
+            (uint32_t) delay);
+}
+
+void test_all_pit(void) {
+    test_pit_periodic();
+    test_pit_oneshot();
+
+    pit_clock_event.handler = NULL;
+    assert(pit_clock_event.set_periodic(PIT_HZ) == 0);
+    wait_jiffy();
+}
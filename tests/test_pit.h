@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for pit.c/h.
+*/
+#ifndef __TEST_PIT_H__
+#define __TEST_PIT_H__
+
+void test_all_pit(void);
+
+#endif
@@ -0,0 +1,251 @@
+#include "test_all.h"
+#include "../drivers/screen.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+
+/*
+    The video memory of the last row on screen, characters and attributes
+    interleaved. TEST_LINES lines of TEST_LINE are printed by the benchmarks, a
+    screen's worth is flushed at a time when batched.
+*/
+#define TEST_LAST_ROW (test_row(24))
+#define TEST_LINES (500)
+#define TEST_BATCH (25)
+#define TEST_LINE "log: the quick brown fox jumps over the lazy dog 0123456789\n"
+
+/*
+    Returns the CRTC start address, the character offset of the top left
+    character on screen.
+*/
+static uint32_t crtc_start(void) {
+    uint32_t start;
+
+    outb(0x3D4, 0x0C);
+    start = inb(0x3D5) << 8;
+    outb(0x3D4, 0x0D);
+    start |= inb(0x3D5);
+
+    return start;
+}
+
+/*
+    Returns the CRTC cursor location, a character offset.
+*/
+static uint32_t crtc_cursor(void) {
+    uint32_t cursor;
+
+    outb(0x3D4, 0x0E);
+    cursor = inb(0x3D5) << 8;
+    outb(0x3D4, 0x0F);
+    cursor |= inb(0x3D5);
+
+    return cursor;
+}
+
+/*
+    Returns the video memory of row row on screen.
+*/
+static volatile uint8_t *test_row(uint32_t row) {
+    return (volatile uint8_t *) screen_get_base() +
+           (crtc_start() + row * 80) * 2;
+}
+
+/*
+    Prints line i as "L<i>".
+*/
+static void print_line(int i) {
+    print("L");
+    print_d(i);
+    print("\n");
+}
+
+/*
+    Returns 1 if row row on screen shows line i, see print_line().
+*/
+static int row_is_line(uint32_t row, int i) {
+    char s[STDIO_STR_SIZE_MAX];
+    volatile uint8_t *v = test_row(row);
+    int j;
+
+    _dtoa(i, s);
+    if (v[0] != 'L')
+        return 0;
+    for (j = 0; s[j]; j++)
+        if (v[(j + 1) * 2] != s[j])
+            return 0;
+
+    return 1;
+}
+
+void test_screen_shadow(void) {
+    print_at("x", 24, 0);
+    assert(TEST_LAST_ROW[0] == 'x');
+
+    // Not visible until flushed.
+    screen_set_autoflush(0);
+    print_at("ab", 24, 0);
+    assert(TEST_LAST_ROW[0] == 'x');
+    screen_flush();
+    assert(TEST_LAST_ROW[0] == 'a' && TEST_LAST_ROW[2] == 'b');
+
+    // Scrolling moves the last row up.
+    print("\n");
+    screen_flush();
+    assert(TEST_LAST_ROW[0] == 0);
+    assert(TEST_LAST_ROW[-80 * 2] == 'a');
+
+    // Enabling autoflush flushes.
+    print_at("c", 24, 0);
+    assert(TEST_LAST_ROW[0] == 0);
+    screen_set_autoflush(1);
+    assert(TEST_LAST_ROW[0] == 'c');
+    print("\n");
+}
+
+void test_screen_scroll(void) {
+    uint32_t start, i;
+
+    // A scroll moves the start address down a row, or wraps it to 0.
+    print("\n");
+    start = crtc_start();
+    print("\n");
+    assert(crtc_start() == start + 80 || crtc_start() == 0);
+
+    // Enough lines to wrap the video memory window.
+    for (i = 0; i < 300; i++) {
+        print_line(i);
+        assert(crtc_start() + 25 * 80 <= 0x8000 / 2);
+    }
+    assert(row_is_line(23, 299) && row_is_line(0, 276));
+
+    // Page back and forth.
+    assert(screen_scrollback(10) == 10);
+    assert(row_is_line(23, 289));
+    assert(screen_scrollback(-4) == 6);
+    assert(row_is_line(23, 293));
+
+    // Output doesn't move the view.
+    print_line(300);
+    assert(row_is_line(23, 293));
+    assert(screen_scrollback(-100) == 0);
+    assert(row_is_line(23, 300));
+
+    // The scrollback holds 7 screens.
+    assert(screen_scrollback(1000) == 7 * 25);
+    assert(row_is_line(0, 300 - 23 - 7 * 25));
+    assert(screen_scrollback(-1000) == 0);
+}
+
+void test_screen_cursor(void) {
+    print_at("ab", 24, 0);
+    assert(crtc_cursor() == crtc_start() + 24 * 80 + 2);
+
+    // The hardware cursor catches up when the updates are enabled.
+    screen_suppress_cursor(1);
+    print_at("abc", 24, 0);
+    assert(crtc_cursor() == crtc_start() + 24 * 80 + 2);
+    screen_suppress_cursor(0);
+    assert(crtc_cursor() == crtc_start() + 24 * 80 + 3);
+
+    // And follows the start address.
+    print("\n\n");
+    assert(crtc_cursor() == crtc_start() + 24 * 80);
+}
+
+/*
+    Prints log lines, flushing after every line and then once per screen's
+    worth of lines, as a periodic flush would.
+*/
+void bench_screen_log(void) {
+    uint64_t t, line, batch;
+    uint32_t i;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        print(TEST_LINE);
+    line = read_tsc() - t;
+
+    screen_set_autoflush(0);
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++) {
+        print(TEST_LINE);
+        if (i % TEST_BATCH == TEST_BATCH - 1)
+            screen_flush();
+    }
+    screen_flush();
+    batch = read_tsc() - t;
+    screen_set_autoflush(1);
+
+    print_cycles("screen: per line, flush per line ", line, TEST_LINES);
+    print_cycles("screen: per line, flush per screen ", batch, TEST_LINES);
+}
+
+/*
+    Scrolls a line at a time with the CRTC start address, then redrawing the
+    whole screen on every scroll as a copying scroll would.
+*/
+void bench_screen_scroll(void) {
+    uint64_t t, hw, copy;
+    uint32_t i;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        print("\n");
+    hw = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++) {
+        print("\n");
+        screen_redraw();
+    }
+    copy = read_tsc() - t;
+
+    print_cycles("screen: scroll, start address ", hw, TEST_LINES);
+    print_cycles("screen: scroll, redraw ", copy, TEST_LINES);
+}
+
+/*
+    Prints TEST_LINE a character at a time, which moves the hardware cursor for
+    every character, then a line at a time and with cursor updates suppressed.
+*/
+void bench_screen_cursor(void) {
+    char c[2] = { 0, 0 };
+    uint64_t t, per_char, per_print, suppressed;
+    uint32_t i, j, n;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++) {
+        for (j = 0; TEST_LINE[j]; j++) {
+            c[0] = TEST_LINE[j];
+            print(c);
+        }
+    }
+    per_char = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        print(TEST_LINE);
+    per_print = read_tsc() - t;
+
+    screen_suppress_cursor(1);
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        print(TEST_LINE);
+    suppressed = read_tsc() - t;
+    screen_suppress_cursor(0);
+
+    n = TEST_LINES * (sizeof(TEST_LINE) - 1);
+    print_cycles("screen: per char, cursor per char ", per_char, n);
+    print_cycles("screen: per char, cursor per print ", per_print, n);
+    print_cycles("screen: per char, cursor suppressed ", suppressed, n);
+}
+
+void test_all_screen(void) {
+    test_screen_shadow();
+    test_screen_scroll();
+    test_screen_cursor();
+    bench_screen_log();
+    bench_screen_scroll();
+    bench_screen_cursor();
+}
@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for screen.c/h.
+*/
+#ifndef __TEST_SCREEN_H__
+#define __TEST_SCREEN_H__
+
+void test_all_screen(void);
+
+#endif
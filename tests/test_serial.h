@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for serial.c/h.
+*/
+#ifndef __TEST_SERIAL_H__
+#define __TEST_SERIAL_H__
+
+void test_all_serial(void);
+
+#endif
@@ -0,0 +1,213 @@
+#include "test_all.h"
+#include "../kernel/slab.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../drivers/screen.h"
+
+/*
+    The tests take their slabs from the kernel's frame pool, and check that
+    every frame is returned by kmem_cache_shrink().
+*/
+#define TEST_OBJ_SIZE (100)
+#define TEST_BIG_SIZE (1000)
+#define TEST_MAGIC (0xA5)
+#define TEST_NOBJS (64)
+#define TEST_BENCH_OBJS (256)
+#define TEST_BENCH_ROUNDS (64)
+
+typedef struct _test_obj_t {
+    uint8_t bytes[TEST_OBJ_SIZE];
+} test_obj_t;
+
+static void *test_objs[TEST_BENCH_OBJS];
+static uint32_t test_ctor_calls;
+
+static void test_ctor(void *obj) {
+    uint8_t *p = (uint8_t *) obj;
+    uint32_t i;
+
+    for (i = 0; i < TEST_OBJ_SIZE; i++)
+        p[i] = TEST_MAGIC;
+    test_ctor_calls++;
+}
+
+static uint32_t test_constructed(const void *obj) {
+    const uint8_t *p = (const uint8_t *) obj;
+    uint32_t i;
+
+    for (i = 0; i < TEST_OBJ_SIZE; i++) {
+        if (p[i] != TEST_MAGIC)
+            return 0;
+    }
+    return 1;
+}
+
+void test_slab_layout(void) {
+    uint32_t free_frames;
+    kmem_cache_t *c;
+    uint32_t i;
+
+    c = kmem_cache_create("test", TEST_OBJ_SIZE, KMEM_CACHE_LINE, NULL);
+    assert(c != NULL);
+    free_frames = frame_free_count();
+    assert(c->stride == 128);
+    assert(c->first_offset == KMEM_CACHE_LINE);
+    assert(c->slab_order == 0);
+    assert(c->objs_per_slab == (FRAME_SIZE - KMEM_CACHE_LINE) / 128);
+    assert(c->nr_slabs == 0);
+
+    for (i = 0; i < TEST_NOBJS; i++) {
+        test_objs[i] = kmem_cache_alloc(c);
+        assert(test_objs[i] != NULL);
+        assert(((uint32_t) test_objs[i] & (KMEM_CACHE_LINE - 1)) == 0);
+        if (i % c->objs_per_slab)       // Address order within a slab.
+            assert(test_objs[i] == (uint8_t *) test_objs[i - 1] + c->stride);
+    }
+    assert(c->nr_slabs == 3);           // 64 objects, 31 per slab.
+    assert(c->misses == 3);
+    assert(c->hits == TEST_NOBJS - 3);
+
+    for (i = 0; i < TEST_NOBJS; i++)
+        kmem_cache_free(c, test_objs[i]);
+    assert(c->nr_slabs == 3 && c->partial == NULL && c->full == NULL);
+    assert(kmem_cache_shrink(c) == 3);
+    assert(frame_free_count() == free_frames);
+    kmem_cache_destroy(c);
+}
+
+void test_slab_reuse(void) {
+    uint32_t free_frames;
+    kmem_cache_t *c;
+    void *a, *b;
+    uint32_t i;
+
+    c = kmem_cache_create("test", TEST_OBJ_SIZE, 0, NULL);
+    free_frames = frame_free_count();
+    a = kmem_cache_alloc(c);
+    b = kmem_cache_alloc(c);
+    kmem_cache_free(c, a);
+    assert(kmem_cache_alloc(c) == a);   // LIFO.
+    kmem_cache_free(c, a);
+    kmem_cache_free(c, b);
+
+    // The empty slab stays on the cache, no miss to refill it.
+    assert(c->empty != NULL && c->partial == NULL && c->nr_slabs == 1);
+    assert(frame_free_count() == free_frames - 1);
+    for (i = 0; i < TEST_NOBJS; i++)
+        test_objs[i] = kmem_cache_alloc(c);
+    assert(c->misses == 2);             // 64 objects of 100 B, 40 per slab.
+    for (i = 0; i < TEST_NOBJS; i++)
+        kmem_cache_free(c, test_objs[i]);
+    assert(c->empty != NULL && c->partial == NULL && c->full == NULL);
+
+    // Pages only go back under memory pressure.
+    assert(kmem_cache_reap() >= 2);
+    assert(c->reaped == 2 && c->nr_slabs == 0);
+    assert(frame_free_count() >= free_frames);
+
+    kmem_cache_destroy(c);
+}
+
+void test_slab_ctor(void) {
+    kmem_cache_t *c;
+    uint32_t i;
+
+    test_ctor_calls = 0;
+    c = kmem_cache_create("test_ctor", TEST_OBJ_SIZE, 0, test_ctor);
+    assert(c->free_offset >= TEST_OBJ_SIZE);
+
+    for (i = 0; i < TEST_NOBJS; i++) {
+        test_objs[i] = kmem_cache_alloc(c);
+        assert(test_constructed(test_objs[i]));
+    }
+    assert(test_ctor_calls == c->nr_slabs * c->objs_per_slab);
+
+    // Freed objects keep their constructed state, no constructor call.
+    for (i = 0; i < TEST_NOBJS; i++)
+        kmem_cache_free(c, test_objs[i]);
+    for (i = 0; i < TEST_NOBJS; i++) {
+        test_objs[i] = kmem_cache_alloc(c);
+        assert(test_constructed(test_objs[i]));
+    }
+    assert(test_ctor_calls == c->nr_slabs * c->objs_per_slab);
+
+    for (i = 0; i < TEST_NOBJS; i++)
+        kmem_cache_free(c, test_objs[i]);
+    kmem_cache_destroy(c);
+}
+
+void test_slab_big(void) {
+    uint32_t free_frames;
+    kmem_cache_t *c;
+    uint32_t i;
+
+    c = kmem_cache_create("test_big", TEST_BIG_SIZE, 0, NULL);
+    free_frames = frame_free_count();
+    assert(c->slab_order == 1);         // 4 objects per frame are too few.
+    assert(c->objs_per_slab == 8);
+
+    for (i = 0; i < TEST_NOBJS; i++)
+        test_objs[i] = kmem_cache_alloc(c);
+    assert(c->nr_slabs == TEST_NOBJS / 8);
+    assert(frame_free_count() == free_frames - 2 * TEST_NOBJS / 8);
+    for (i = 0; i < TEST_NOBJS; i++)
+        kmem_cache_free(c, test_objs[i]);
+    assert(kmem_cache_shrink(c) == 2 * TEST_NOBJS / 8);
+    assert(frame_free_count() == free_frames);
+
+    kmem_cache_destroy(c);
+}
+
+/*
+    Allocates and frees TEST_BENCH_OBJS objects, TEST_BENCH_ROUNDS times.
+    Reports the average TSC cycles per alloc and per free, and the hits and
+    misses.
+*/
+void bench_slab(void) {
+    uint64_t t, alloc_cycles = 0, free_cycles = 0;
+    char s[STDIO_STR_SIZE_MAX];
+    kmem_cache_t *c;
+    uint32_t i, r;
+
+    c = kmem_cache_create("bench", sizeof(test_obj_t), KMEM_CACHE_LINE, NULL);
+
+    for (r = 0; r < TEST_BENCH_ROUNDS; r++) {
+        t = read_tsc();
+        for (i = 0; i < TEST_BENCH_OBJS; i++)
+            test_objs[i] = kmem_cache_alloc(c);
+        alloc_cycles += read_tsc() - t;
+
+        t = read_tsc();
+        for (i = 0; i < TEST_BENCH_OBJS; i++)
+            kmem_cache_free(c, test_objs[i]);
+        free_cycles += read_tsc() - t;
+    }
+
+    // Only the first round creates slabs.
+    assert(c->misses == c->nr_slabs);
+    assert(c->hits == TEST_BENCH_ROUNDS * TEST_BENCH_OBJS - c->misses);
+
+    print_cycles("slab: per alloc ", alloc_cycles,
+                 TEST_BENCH_ROUNDS * TEST_BENCH_OBJS);
+    print_cycles("slab: per free ", free_cycles,
+                 TEST_BENCH_ROUNDS * TEST_BENCH_OBJS);
+    print("slab: hits ");
+    _utoa(c->hits, s);
+    print(s);
+    print(" misses ");
+    _utoa(c->misses, s);
+    print(s);
+    print("\n");
+
+    kmem_cache_destroy(c);
+}
+
+void test_all_slab(void) {
+    test_slab_layout();
+    test_slab_reuse();
+    test_slab_ctor();
+    test_slab_big();
+    bench_slab();
+}
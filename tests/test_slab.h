@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for slab.c/h.
+*/
+#ifndef __TEST_SLAB_H__
+#define __TEST_SLAB_H__
+
+void test_all_slab(void);
+
+#endif
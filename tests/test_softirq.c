@@ -0,0 +1,162 @@
+#include "../kernel/softirq.h"
+#include "../kernel/idt.h"
+#include "../kernel/intr_stats.h"
+#include "../kernel/klog.h"
+#include "../kernel/low_level.h"
+#include "../include/assert.h"
+#include "../include/stddef.h"
+#include "../include/stdio.h"
+#include "../drivers/keyboard.h"
+#include "../drivers/ps_2_ctlr.h"
+#include "../drivers/screen.h"
+
+#define TEST_VN (0x82)
+#define TEST_KEYS (50)
+#define TEST_TIMEOUT (100000000ULL)
+#define EFLAGS_IF (1U << 9)
+
+static uint32_t order[4], n_order;
+static uint32_t if_set, nesting, depth, max_depth, reraise;
+
+static void test_order_work(void *ctx) {
+    order[n_order++ & 3] = (uint32_t) ctx;
+}
+
+static tasklet_t t1 = { test_order_work, (void *) 1, 0, 0, 0, NULL };
+static tasklet_t t2 = { test_order_work, (void *) 2, 0, 0, 0, NULL };
+
+/*
+    Records the context it runs in, and raises TEST_VN again if asked to.
+*/
+static void test_irq_work(void *ctx) {
+    uint32_t flags = irq_save();
+
+    irq_restore(flags);
+    if_set = flags & EFLAGS_IF;
+    nesting = intr_nesting;
+    if (ctx) { // Suppress warning.
+        ;
+    }
+
+    if (++depth > max_depth)
+        max_depth = depth;
+    if (reraise) {
+        reraise = 0;
+        __asm__ volatile("int $0x82");
+    }
+    depth--;
+}
+
+static tasklet_t t_irq = { test_irq_work, NULL, 0, 0, 0, NULL };
+
+static void test_handler(uint32_t vn, uint32_t err_code, void *ctx) {
+    if (vn || err_code || ctx) { // Suppress warning.
+        ;
+    }
+    tasklet_schedule(&t_irq);
+}
+
+/*
+    Tasklets run once however many times they were scheduled, in scheduling
+    order.
+*/
+void test_tasklet_order(void) {
+    uint32_t flags, runs1 = t1.runs, runs2 = t2.runs;
+
+    n_order = 0;
+    flags = irq_save();
+    tasklet_schedule(&t1);
+    tasklet_schedule(&t2);
+    tasklet_schedule(&t1);
+    irq_restore(flags);
+    softirq_run();
+
+    assert(n_order == 2 && order[0] == 1 && order[1] == 2);
+    assert(t1.runs == runs1 + 1 && t2.runs == runs2 + 1);
+    assert(!t1.scheduled && !t2.scheduled);
+}
+
+/*
+    A tasklet scheduled by a handler runs on the interrupt's exit, with
+    interrupts enabled, outside of the handler. An interrupt raised by the
+    tasklet doesn't run it nested, it runs again after. Nothing runs on the
+    exit to a program that had interrupts disabled.
+*/
+void test_tasklet_irq_exit(void) {
+    uint32_t runs, flags;
+
+    assert(intr_register(TEST_VN, test_handler, NULL) == 0);
+
+    runs = t_irq.runs;
+    if_set = 0;
+    nesting = 1;
+    __asm__ volatile("int $0x82");
+    assert(t_irq.runs == runs + 1 && if_set && nesting == 0);
+
+    runs = t_irq.runs;
+    max_depth = 0;
+    reraise = 1;
+    __asm__ volatile("int $0x82");
+    assert(t_irq.runs == runs + 2 && max_depth == 1);
+
+    runs = t_irq.runs;
+    flags = irq_save();
+    __asm__ volatile("int $0x82");
+    assert(t_irq.runs == runs && t_irq.scheduled);
+    irq_restore(flags);
+    softirq_run();
+    assert(t_irq.runs == runs + 1);
+
+    intr_unregister(TEST_VN);
+}
+
+/*
+    The drain of the log, a tasklet scheduled by the tick, passes the VGA
+    console every record.
+*/
+void test_klog_tasklet(void) {
+    uint32_t runs = klog_tasklet.runs;
+
+    klog(KLOG_DEBUG, "softirq: drained by klog_tasklet");
+    klog_tick(NULL);
+    softirq_run();
+    assert(klog_tasklet.runs == runs + 1);
+    assert(klog_vga.next_seq == klog_seq());
+}
+
+/*
+    Feeds TEST_KEYS scan codes through the PS/2 controller, which raises
+    IRQ1 for each as if it came from the keyboard. Reports the cycles per key
+    spent in v33_handler, with interrupts disabled, and in the keyboard
+    tasklet, which ran inside the handler before it was deferred.
+*/
+void bench_softirq_keyboard(void) {
+    const intr_stats_t *s = intr_stats_get(IRQ_VN(KEYBOARD_IRQ));
+    uint32_t count = s->count, runs = keyboard_tasklet.runs, r, i;
+    uint64_t total = s->total, cycles = keyboard_tasklet.cycles, t;
+
+    for (i = 0; i < TEST_KEYS; i++) {
+        r = keyboard_tasklet.runs;
+        send_byte_ctlr(W_KBD_OUTPUT_BUF);
+        send_byte(i & 1 ? 0x9E : 0x1E); // 'a' pressed, released.
+        t = read_tsc();
+        while (keyboard_tasklet.runs == r)
+            assert(read_tsc() - t < TEST_TIMEOUT);
+    }
+    print("\n");
+
+    count = s->count - count;
+    runs = keyboard_tasklet.runs - runs;
+    assert(count == TEST_KEYS && runs == TEST_KEYS);
+
+    kprintf("softirq: keyboard per key, IF=0 %u cycles, deferred %u cycles\n",
+            (uint32_t) ((s->total - total) / count),
+            (uint32_t) ((keyboard_tasklet.cycles - cycles) / runs));
+}
+
+void test_all_softirq(void) {
+    test_tasklet_order();
+    test_tasklet_irq_exit();
+    test_klog_tasklet();
+    bench_softirq_keyboard();
+}
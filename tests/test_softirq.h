@@ -0,0 +1,9 @@
+/*!
+    @header Test cases and benchmark for softirq.c/h.
+*/
+#ifndef __TEST_SOFTIRQ_H__
+#define __TEST_SOFTIRQ_H__
+
+void test_all_softirq(void);
+
+#endif
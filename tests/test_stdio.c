@@ -1,6 +1,8 @@
 #include "../include/stdio.h"
 #include "../include/assert.h"
 #include "../include/string.h"
+#include "../kernel/low_level.h"
+#include "../drivers/screen.h"
 
 // @TODO Add all corner case tests.
 
@@ -126,9 +128,107 @@ void test_xtoa(void) {
     assert(strcmp(s, "FFFFFFFFFFFFFFFF") == 0);
 }
 
+/*
+    Formats with snprintf() into a TEST_BUF_SIZE buffer and compares with
+    expected.
+*/
+#define TEST_BUF_SIZE 64
+#define TEST_FMT(expected, ...) \
+    do { \
+        char _s[TEST_BUF_SIZE]; \
+        assert(snprintf(_s, sizeof(_s), __VA_ARGS__) == \
+               (int) sizeof(expected) - 1); \
+        assert(strcmp(_s, expected) == 0); \
+    } while (0)
+
+void test_snprintf(void) {
+    const char *null_str = NULL;
+    char s[8];
+
+    TEST_FMT("", "%s", "");
+    TEST_FMT("100%", "100%%");
+    TEST_FMT("-42 42 42", "%d %i %u", -42, 42, 42U);
+    TEST_FMT("-2147483648 4294967295", "%d %u", -2147483647 - 1,
+             4294967295U);
+    TEST_FMT("deadbeef DEADBEEF 777", "%x %X %o", 0xdeadbeef, 0xdeadbeef,
+             0777);
+    TEST_FMT("a z", "%c %c", 'a', 'z');
+    TEST_FMT("abc (null)", "%s %s", "abc", null_str);
+    TEST_FMT("0x000b8000", "%p", (void *) 0xb8000);
+
+    // Width and precision.
+    TEST_FMT("   42|42   |00042", "%5d|%-5d|%05d", 42, 42, 42);
+    TEST_FMT("  -42|-0042|  042", "%5d|%05d|%5.3d", -42, -42, 42);
+    TEST_FMT("   ab|ab   |abc", "%5s|%-5s|%.3s", "ab", "ab", "abcdef");
+    TEST_FMT("   ab|    x", "%*s|%*c", 5, "ab", 5, 'x');
+    TEST_FMT("ab   |abc", "%-*s|%.*s", 5, "ab", 3, "abcdef");
+    TEST_FMT("||1|0", "|%.0d|%.0x|%#.0o", 0, 1, 0);
+    TEST_FMT("+1  1 0x1f 0X1F 017 0", "%+d % d %#x %#X %#o %#x", 1, 1, 31,
+             31, 15, 0);
+    TEST_FMT("0x0000001f", "%#010x", 31);
+
+    // Length modifiers.
+    TEST_FMT("-1 65535 255 -1", "%hd %hu %hhu %hhd", -1, 65535 + 65536,
+             255 + 256, 255);
+    TEST_FMT("-9223372036854775807 18446744073709551615",
+             "%lld %llu", -9223372036854775807LL,
+             18446744073709551615ULL);
+    TEST_FMT("ffffffffffffffff 1777777777777777777777", "%llx %llo",
+             18446744073709551615ULL, 18446744073709551615ULL);
+    TEST_FMT("-5 5 4000", "%ld %lu %zu", -5L, 5UL, (size_t) 4000);
+
+    // Truncation.
+    assert(snprintf(s, sizeof(s), "%s", "0123456789") == 10);
+    assert(strcmp(s, "0123456") == 0);
+    assert(snprintf(s, 1, "%d", 12345) == 5 && s[0] == '\0');
+    assert(snprintf(NULL, 0, "%d", 12345) == 5);
+}
+
+/*
+    Prints TEST_LINES lines of 3 values with print() calls per piece and with
+    one kprintf() per line. Also times the formatting alone.
+*/
+#define TEST_LINES 500
+
+void bench_kprintf(void) {
+    uint64_t t, pieces, formatted, format_only;
+    char s[KPRINTF_BUF_SIZE];
+    uint32_t i;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++) {
+        print("vector ");
+        print_d(i);
+        print(" error ");
+        print_x32(i * 8);
+        print(" name ");
+        print("bench");
+        print("\n");
+    }
+    pieces = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        kprintf("vector %u error %08x name %s\n", i, i * 8, "bench");
+    formatted = read_tsc() - t;
+
+    t = read_tsc();
+    for (i = 0; i < TEST_LINES; i++)
+        snprintf(s, sizeof(s), "vector %u error %08x name %s\n", i, i * 8,
+                 "bench");
+    format_only = read_tsc() - t;
+
+    kprintf("stdio: per line, print pieces %llu cycles\n", pieces / TEST_LINES);
+    kprintf("stdio: per line, kprintf %llu cycles\n", formatted / TEST_LINES);
+    kprintf("stdio: per line, snprintf only %llu cycles\n",
+            format_only / TEST_LINES);
+}
+
 void test_all_stdio(void) {
     test_otoa();
     test_dtoa();
     test_utoa();
     test_xtoa();
+    test_snprintf();
+    bench_kprintf();
 }
\ No newline at end of file
@@ -1,5 +1,15 @@
+#include "test_all.h"
 #include "../include/stdlib.h"
 #include "../include/assert.h"
+#include "../include/stdio.h"
+#include "../include/string.h"
+#include "../kernel/frame_alloc.h"
+#include "../kernel/low_level.h"
+#include "../drivers/screen.h"
+
+#define TEST_SLOTS (256)
+#define TEST_ITERATIONS (20000)
+#define TEST_FF_HEAP_SIZE (TEST_SLOTS * 2048 + 4096)
 
 void test_atoi(void) {
     int i;
@@ -25,6 +35,214 @@ void test_atoi(void) {
     assert(i != r);
 }
 
+void test_kmalloc(void) {
+    uint8_t *p, *q;
+    size_t size;
+
+    assert(kmalloc(0) == NULL);
+    kfree(NULL);
+
+    for (size = 1; size <= KMALLOC_MAX_SIZE; size++) {
+        p = kmalloc(size);
+        assert(p != NULL);
+        assert(ksize(p) >= size && ksize(p) < 2 * size + KMALLOC_MIN_SIZE);
+        assert(((uint32_t) p & (ksize(p) < 64 ? ksize(p) - 1 : 63)) == 0);
+        p[0] = 1;
+        p[size - 1] = 2;
+        kfree(p);
+    }
+
+    // Large blocks are whole pages.
+    p = kmalloc(KMALLOC_MAX_SIZE + 1);
+    assert(((uint32_t) p & (FRAME_SIZE - 1)) == 0 && ksize(p) == FRAME_SIZE);
+    q = kmalloc(3 * FRAME_SIZE);
+    assert(((uint32_t) q & (FRAME_SIZE - 1)) == 0 && ksize(q) == 4 * FRAME_SIZE);
+    kfree(p);
+    kfree(q);
+}
+
+void test_krealloc_kcalloc(void) {
+    uint8_t *p, *q;
+    uint32_t i;
+
+    p = krealloc(NULL, 10);
+    for (i = 0; i < 10; i++)
+        p[i] = i;
+    assert(krealloc(p, 16) == p);       // Fits in its size class.
+
+    q = krealloc(p, 5000);
+    assert(q != NULL && ksize(q) == 2 * FRAME_SIZE);
+    for (i = 0; i < 10; i++)
+        assert(q[i] == i);
+    assert(krealloc(q, 0) == NULL);
+
+    p = kcalloc(100, 7);
+    for (i = 0; i < 700; i++)
+        assert(p[i] == 0);
+    kfree(p);
+    assert(kcalloc(0x10000, 0x10000) == NULL);
+}
+
+/*
+    A linear congruential pseudo random number generator, Numerical Recipes
+    constants.
+*/
+static uint32_t test_rand_state = 1;
+
+static uint32_t test_rand(void) {
+    test_rand_state = test_rand_state * 1664525 + 1013904223;
+    return test_rand_state >> 8;
+}
+
+static uint8_t *test_blocks[TEST_SLOTS];
+static uint32_t test_sizes[TEST_SLOTS];
+
+/*
+    Random kmalloc/krealloc/kfree in TEST_SLOTS slots, each block filled with
+    its slot number and checked before it is resized or freed. Every 16th
+    block is large.
+*/
+void test_kmalloc_stress(void) {
+    uint32_t i, j, slot, size;
+
+    for (i = 0; i < TEST_ITERATIONS; i++) {
+        slot = test_rand() % TEST_SLOTS;
+        size = test_rand() % (test_rand() % 16 ? KMALLOC_MAX_SIZE :
+                                                 4 * FRAME_SIZE) + 1;
+
+        if (test_blocks[slot]) {
+            for (j = 0; j < test_sizes[slot]; j++)
+                assert(test_blocks[slot][j] == (uint8_t) slot);
+        }
+
+        if (test_blocks[slot] && i % 3 == 0) {
+            kfree(test_blocks[slot]);
+            test_blocks[slot] = NULL;
+            test_sizes[slot] = 0;
+            continue;
+        }
+
+        test_blocks[slot] = krealloc(test_blocks[slot], size);
+        assert(test_blocks[slot] != NULL);
+        if (size > test_sizes[slot])
+            memset(test_blocks[slot], slot, size);
+        test_sizes[slot] = size;
+    }
+
+    for (i = 0; i < TEST_SLOTS; i++) {
+        kfree(test_blocks[i]);
+        test_blocks[i] = NULL;
+        test_sizes[i] = 0;
+    }
+}
+
+/*
+    A naive first-fit heap for comparison: a block header in front of each
+    block, the blocks are searched from the start of the heap.
+*/
+typedef struct _ff_block_t {
+    uint32_t size;      // Including the header.
+    uint32_t free;
+} ff_block_t;
+
+static uint8_t ff_heap[TEST_FF_HEAP_SIZE] __attribute__((aligned(16)));
+
+static void ff_init(void) {
+    ff_block_t *b = (ff_block_t *) ff_heap;
+
+    b->size = TEST_FF_HEAP_SIZE;
+    b->free = 1;
+}
+
+static void *ff_malloc(uint32_t size) {
+    ff_block_t *b, *rest;
+    uint32_t off;
+
+    size = (size + sizeof(ff_block_t) + 15) & ~15U;
+
+    for (off = 0; off < TEST_FF_HEAP_SIZE; off += b->size) {
+        b = (ff_block_t *) (ff_heap + off);
+        if (!b->free || b->size < size)
+            continue;
+
+        if (b->size - size >= 32) {
+            rest = (ff_block_t *) (ff_heap + off + size);
+            rest->size = b->size - size;
+            rest->free = 1;
+            b->size = size;
+        }
+        b->free = 0;
+        return b + 1;
+    }
+
+    return NULL;
+}
+
+static void ff_free(void *p) {
+    ff_block_t *b = (ff_block_t *) p - 1;
+    ff_block_t *next;
+
+    b->free = 1;
+    next = (ff_block_t *) ((uint8_t *) b + b->size);
+    while ((uint8_t *) next < ff_heap + TEST_FF_HEAP_SIZE && next->free) {
+        b->size += next->size;
+        next = (ff_block_t *) ((uint8_t *) b + b->size);
+    }
+}
+
+/*
+    Random alloc and free of 1 to KMALLOC_MAX_SIZE bytes in TEST_SLOTS slots,
+    with kmalloc/kfree and with the first-fit heap. Reports the average TSC
+    cycles per alloc and free pair.
+*/
+void bench_kmalloc(void) {
+    uint64_t t, k_cycles = 0, ff_cycles = 0;
+    uint32_t i, slot, size, seed;
+
+    seed = test_rand_state;
+    for (i = 0; i < TEST_ITERATIONS; i++) {
+        slot = test_rand() % TEST_SLOTS;
+        size = test_rand() % KMALLOC_MAX_SIZE + 1;
+        t = read_tsc();
+        if (test_blocks[slot]) {
+            kfree(test_blocks[slot]);
+            test_blocks[slot] = NULL;
+        } else {
+            test_blocks[slot] = kmalloc(size);
+        }
+        k_cycles += read_tsc() - t;
+    }
+    for (i = 0; i < TEST_SLOTS; i++) {
+        kfree(test_blocks[i]);
+        test_blocks[i] = NULL;
+    }
+
+    ff_init();
+    test_rand_state = seed;             // The same sequence.
+    for (i = 0; i < TEST_ITERATIONS; i++) {
+        slot = test_rand() % TEST_SLOTS;
+        size = test_rand() % KMALLOC_MAX_SIZE + 1;
+        t = read_tsc();
+        if (test_blocks[slot]) {
+            ff_free(test_blocks[slot]);
+            test_blocks[slot] = NULL;
+        } else {
+            test_blocks[slot] = ff_malloc(size);
+            assert(test_blocks[slot] != NULL);
+        }
+        ff_cycles += read_tsc() - t;
+    }
+    for (i = 0; i < TEST_SLOTS; i++)
+        test_blocks[i] = NULL;
+
+    print_cycles("kmalloc: per op ", k_cycles, TEST_ITERATIONS);
+    print_cycles("first-fit: per op ", ff_cycles, TEST_ITERATIONS);
+}
+
 void test_all_stdlib(void) {
     test_atoi();
-}
\ No newline at end of file
+    test_kmalloc();
+    test_krealloc_kcalloc();
+    test_kmalloc_stress();
+    bench_kmalloc();
+}